@@ -10,3 +10,16 @@
 #include "LMultivector_Literals.h"
 #include "LMultivector_ostream.h"
 #include "LMultivector_Plucker.h"
+#include "LMultivector_Sparse.h"
+#include "LMultivector_View.h"
+#include "LMultivector_Batch.h"
+#include "LMultivector_Expr.h"
+#include "LMultivector_Versor.h"
+#include "LMultivector_Outermorphism.h"
+#include "LMultivector_Exp.h"
+#include "LMultivector_Conformal.h"
+#include "LMultivector_Runtime.h"
+#include "LMultivector_File.h"
+#include "LMultivector_Stream.h"
+#include "LMultivector_Parallel.h"
+#include "LMultivector_Reduce.h"
@@ -2,6 +2,10 @@
 
 #include <cassert>
 #include <string.h>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
 
 /*!	\file	LMultivector.h		Multivector routing
 	
@@ -20,6 +24,25 @@
  */
 
 
+#ifndef LGA_BASIS_BITS
+//! Width of the blade masks: 16 (e1...e16) or 32 (e1...e32).
+#define LGA_BASIS_BITS 16
+#endif
+
+#if LGA_BASIS_BITS == 16
+typedef std::uint16_t GABasisMask;
+#elif LGA_BASIS_BITS == 32
+typedef std::uint32_t GABasisMask;
+#else
+#error "LGA_BASIS_BITS must be 16 or 32"
+#endif
+
+#ifndef LGA_DENSE_BITS
+//! A GATuple (PS+1 coefficients) may use the first LGA_DENSE_BITS basis vectors.
+#define LGA_DENSE_BITS 12
+#endif
+
+
 //! Enumeration that consists of the basis.
 /*! Each basis is orthonormal to all the others.
  
@@ -29,137 +52,990 @@
  
 	@warning	These are or'd together.  The type is used by the compiler
 				to chose the proper overloaded operators.
+	@warning	A GATuple stores every blade below its pseudo-scalar, use a
+				GASparseTuple past a dozen basis vectors.
+ */
+enum GABasis : GABasisMask
+{
+	scalar	= 0x0,	//!< Special value for the scalar
+	e1		= 0x001,
+	e2		= 0x002,
+	e3		= 0x004,
+	e4		= 0x008,
+	e5		= 0x010,
+	e6		= 0x020,
+	e7		= 0x040,
+	e8		= 0x080,
+	e9		= 0x100,
+	e10		= 0x200,
+	e11		= 0x400,
+	e12		= 0x800,
+	e13		= 0x1000,
+	e14		= 0x2000,
+	e15		= 0x4000,
+	e16		= 0x8000,
+#if LGA_BASIS_BITS == 32
+	e17		= 0x10000,
+	e18		= 0x20000,
+	e19		= 0x40000,
+	e20		= 0x80000,
+	e21		= 0x100000,
+	e22		= 0x200000,
+	e23		= 0x400000,
+	e24		= 0x800000,
+	e25		= 0x1000000,
+	e26		= 0x2000000,
+	e27		= 0x4000000,
+	e28		= 0x8000000,
+	e29		= 0x10000000,
+	e30		= 0x20000000,
+	e31		= 0x40000000,
+	e32		= 0x80000000,
+#endif
+};
+
+
+//! Determine the grade of a basis
+/*! We define the grade as the number of basis vectors for the given subspace.
+	
+	The order is used for the inner and outer products.  Counted without a
+	loop, so the runtime algebras can use it too.
+ 
+	@param		t a constant that tells of the type.
+ */
+constexpr int GAGrade(const GABasis t)
+{
+	unsigned int it = (unsigned int)t;
+	it = it - ((it >> 1) & 0x55555555u);
+	it = (it & 0x33333333u) + ((it >> 2) & 0x33333333u);
+	it = (it + (it >> 4)) & 0x0F0F0F0Fu;
+	return int((it * 0x01010101u) >> 24);
+}
+
+
+//! Combines multiple basis by multiplying left to right.
+/*!	Consider e1^e2 and e2^e3, the combination is e1^e3 since the e2s cancel out.
+ */
+constexpr GABasis operator^(const GABasis left, const GABasis right)
+{
+	return GABasis((unsigned int)left^(unsigned int)right);
+}
+
+//! Takes two basis and finds the maximum
+/*!	Rather than the minimal combination, what is the largest combination.
+	In other words, find the most logical psedo-vector of the left and right.
+ */
+constexpr GABasis operator|(const GABasis left, const GABasis right)
+{
+	return GABasis((unsigned int)left|(unsigned int)right);
+}
+
+
+static_assert(GAGrade(scalar) == 0, "GAGrade: Order(scalar) = 0");
+static_assert(GAGrade(e1) == 1, "GAGrade: Order(e1) = 1");
+static_assert(GAGrade(e3) == 1, "GAGrade: Order(e3) = 1");
+static_assert(GAGrade(e2^e4^e6) == 3, "GAGrade: Order(e2^e4^e6) = 3");
+
+
+//! The bases of right that flip the sign of the product left right.
+/*!	Each basis of right jumps over the bases of left that come after it, and
+	only the parity of the jumps matters: bit i is the parity of the bases of
+	left above e(i+1), smeared down in five shifts.
+ */
+constexpr unsigned int GAProductFlips(unsigned int left)
+{
+	unsigned int after = left >> 1;
+	after ^= after >> 1;
+	after ^= after >> 2;
+	after ^= after >> 4;
+	after ^= after >> 8;
+	after ^= after >> 16;
+	return after;
+}
+
+
+//! Handles the case where the geometric product is not associative.
+/*! Recall, e1^e2 = -e2^e1.  Each time there is a shift of two elements in the
+	basis, we flip sign.  e1^e2^e3 = -e2^e1^e3.  And this works as dimensions
+	go up.
+ 
+	We assume that e1...en come in order, as such put right after left, and
+	see how many elements have to be shifted to sort the e1, e2, e3...
+	elements.
+ */
+constexpr int GAProductMultiplyBy(const GABasis left, const GABasis right)
+{
+	return GAGrade(GABasis(GAProductFlips((unsigned int)left) & (unsigned int)right)) % 2 == 0 ? 1 : -1;
+}
+
+static_assert(GAProductMultiplyBy(e1, e2) == 1, "GAProductMultiplyBy: In order, simple");
+static_assert(GAProductMultiplyBy(e1, e4) == 1, "GAProductMultiplyBy: In order, simple");
+static_assert(GAProductMultiplyBy(e2, e1) == -1, "GAProductMultiplyBy: Reverse order, simple");
+static_assert(GAProductMultiplyBy(e4, e1) == -1, "GAProductMultiplyBy: In order, simple");
+static_assert(GAProductMultiplyBy(e2, e1^e3) == -1, "GAProductMultiplyBy: Middle, with negation");
+
+
+//! An operation that does the geometric product.
+struct GA_GeometricProduct
+{
+	//! Sign of the product of two basis blades, 0 if the pair never contributes.
+	static constexpr int sign(const GABasis left, const GABasis right)
+	{ return GAProductMultiplyBy(left, right); }
+};
+
+
+//! An operation that does the inner product.
+/*!	The inner product keeps the part of the geometric product whose grade is
+	GAGrade(right) - GAGrade(left), in other words the left contraction.
+	Only the pairs where left is within right have that grade.
+ */
+struct GA_InnerProduct
+{
+	static constexpr int sign(const GABasis left, const GABasis right)
+	{
+		return (left & right) == left ? GAProductMultiplyBy(left, right) : 0;
+	}
+};
+
+
+//! An operation that does the outer product.
+struct GA_OuterProduct
+{
+	static constexpr int sign(const GABasis left, const GABasis right)
+	{
+		return (left & right) == 0 ? GAProductMultiplyBy(left, right) : 0;
+	}
+};
+
+
+//! The left contraction, left _| right, is the inner product used by *.
+typedef GA_InnerProduct GA_LeftContraction;
+
+
+//! An operation that does the right contraction, left |_ right.
+/*!	Keeps the part of the geometric product whose grade is
+	GAGrade(left) - GAGrade(right), from the pairs where right is within left.
+ */
+struct GA_RightContraction
+{
+	static constexpr int sign(const GABasis left, const GABasis right)
+	{
+		return (left & right) == right ? GAProductMultiplyBy(left, right) : 0;
+	}
+};
+
+
+//! An operation that does the scalar product (the grade 0 part).
+struct GA_ScalarProduct
+{
+	static constexpr int sign(const GABasis left, const GABasis right)
+	{
+		return left == right ? GAProductMultiplyBy(left, right) : 0;
+	}
+};
+
+
+//! Product of the squares of the basis vectors of m.
+/*!	The vectors of neg square to -1, those of zero to 0, the others to 1. */
+constexpr int GAMetricSquare(unsigned int m, unsigned int neg, unsigned int zero)
+{
+	return (m & zero) != 0 ? 0 : GAGrade(GABasis(m & neg)) % 2 == 0 ? 1 : -1;
+}
+
+
+//! Metric signature: what each basis vector squares to.
+/*!	The basis vectors of NEG square to -1, those of ZERO to 0 (degenerate),
+	and all others to +1.  A product of two blades contracts the vectors they
+	share, so its sign picks up the squares of left & right.
+	
+	@code
+		// Projective 3D algebra, e4 is the degenerate vector at infinity.
+		GATuple<e1^e2^e3^e4, float, GAProjective> plane;
+	@endcode
+	
+	@tparam	NEG		Basis vectors that square to -1
+	@tparam	ZERO	Basis vectors that square to 0
+ */
+template<GABasis NEG = scalar, GABasis ZERO = scalar>
+struct GASignature
+{
+	static_assert((NEG & ZERO) == 0, "A basis vector has a single square");
+	
+	static constexpr unsigned int neg = NEG;		//!< Vectors squaring to -1
+	static constexpr unsigned int zero = ZERO;		//!< Vectors squaring to 0
+	
+	//! Product of the squares of the basis vectors of m.
+	static constexpr int square(unsigned int m)
+	{ return GAMetricSquare(m, NEG, ZERO); }
+};
+
+
+//! Every basis vector squares to +1, the default of GA and GATuple.
+typedef GASignature<> GAEuclidean;
+
+//! Projective (plane-based) 3D algebra, e1...e3 and a degenerate e4.
+typedef GASignature<scalar, e4> GAProjective;
+
+//! Conformal 3D algebra, e1...e3, e4 = e+ (squares to 1), e5 = e- (squares to -1).
+/*!	See LMultivector_Conformal.h for points and the null basis. */
+typedef GASignature<e5> GAConformal;
+
+static_assert(GAProjective::square(e1^e4) == 0, "GASignature: degenerate");
+static_assert(GAConformal::square(e4^e5) == -1, "GASignature: e- squares to -1");
+
+
+//! An operation (GA_GeometricProduct...) within the metric S.
+/*!	The signs of the terms that contract a degenerate vector are 0, so the
+	Cayley tables drop them at compile time and the products of PGA cost
+	less than their Euclidean counterparts.
+ */
+template<class OP, class S>
+struct GAMetricProduct
+{
+	static constexpr int sign(const GABasis left, const GABasis right)
+	{ return OP::sign(left, right) * S::square(left & right); }
+};
+
+
+//! The operation OP within the metric S, OP itself when Euclidean.
+/*!	Keeping OP for the Euclidean metric shares its tables (and the SIMD
+	kernels) with the code that ignores metrics. */
+template<class OP, class S>
+struct GAMetricOp
+{
+	typedef GAMetricProduct<OP, S> type;
+};
+
+template<class OP>
+struct GAMetricOp<OP, GAEuclidean>
+{
+	typedef OP type;
+};
+
+
+//! Spreads the low bits of a counter over the bits set in a mask.
+/*!	Used to enumerate the blades of a pseudo-scalar in increasing order:
+	the i-th blade of PS is GADeposit(i, PS).
+ */
+constexpr unsigned int GADeposit(unsigned int bits, unsigned int mask)
+{
+	unsigned int o = 0;
+	for (unsigned int b = 1; mask != 0; b <<= 1)
+	{
+		const unsigned int low = mask & (~mask + 1);
+		if (bits & b)
+			o |= low;
+		mask &= mask - 1;
+	}
+	return o;
+}
+
+
+//! Inverse of GADeposit, packs the bits of a selected by the mask.
+constexpr unsigned int GAExtract(unsigned int bits, unsigned int mask)
+{
+	unsigned int o = 0;
+	for (unsigned int b = 1; mask != 0; b <<= 1)
+	{
+		const unsigned int low = mask & (~mask + 1);
+		if (bits & low)
+			o |= b;
+		mask &= mask - 1;
+	}
+	return o;
+}
+
+static_assert(GADeposit(0x5, e1^e3^e4) == (e1^e4), "GADeposit: spread bits");
+static_assert(GAExtract(e1^e4, e1^e3^e4) == 0x5, "GAExtract: pack bits");
+
+
+//! Compile-time list of the blades that are stored in a multivector.
+/*!	The blades must be given in increasing order, with no duplicates.  The
+	position of a blade in the list is its slot in the storage.
+ 
+	@code
+		// A 3D vector stores three coefficients.
+		typedef GABlades<e1, e2, e3> Vector3;
+	@endcode
+ */
+template<GABasis... B>
+struct GABlades
+{
+	//! Number of blades (and coefficients) in the set.
+	static constexpr int count = sizeof...(B);
+	
+	//! The masks, with a trailing 0 so an empty set is a valid array.
+	static constexpr unsigned int masks[sizeof...(B) + 1] = {(unsigned int)B..., 0};
+	
+	//! The i-th blade in the set.
+	static constexpr unsigned int mask(int i) { return masks[i]; }
+	
+	//! Where the i-th blade is stored.
+	static constexpr int slot(int i) { return i; }
+	
+	//! Slot holding the blade, -1 if the blade is not in the set.
+	static constexpr int find(unsigned int m)
+	{
+		int lo = 0;
+		int hi = count;
+		while (lo < hi)
+		{
+			const int mid = (lo + hi) / 2;
+			if (masks[mid] < m)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return (lo < count && masks[lo] == m) ? lo : -1;
+	}
+	
+	//! Every blade that can be stored (used to size the product tables).
+	static constexpr unsigned int span()
+	{
+		unsigned int o = 0;
+		for (int i=0; i<count; i++)
+			o |= masks[i];
+		return o;
+	}
+	
+	//! Check that the blades are in canonical order.
+	static constexpr bool sorted()
+	{
+		for (int i=1; i<count; i++)
+			if (masks[i-1] >= masks[i])
+				return false;
+		return true;
+	}
+	
+	static_assert(sorted(), "GABlades: blades must be unique and in increasing order");
+};
+
+template<GABasis... B>
+constexpr unsigned int GABlades<B...>::masks[sizeof...(B) + 1];
+
+
+//! Layout of the blades within a GATuple.
+/*!	Every blade of the pseudo-scalar PS is present, and the mask is used as
+	the index into the storage.
+ */
+template<GABasis PS>
+struct GADenseBlades
+{
+	static constexpr int count = 1 << GAGrade(PS);
+	
+	static constexpr unsigned int mask(int i) { return GADeposit(i, PS); }
+	
+	static constexpr int slot(int i) { return (int)mask(i); }
+	
+	static constexpr int find(unsigned int m)
+	{ return (m & ~(unsigned int)PS) == 0 ? (int)m : -1; }
+	
+	static constexpr unsigned int span() { return PS; }
+};
+
+
+//! Layout of some of the blades of a GATuple.
+/*!	Only the blades of B are read (or written), but they are stored where
+	the GATuple stores them (the mask is the index into the storage).
+ */
+template<class B>
+struct GAScatteredBlades
+{
+	static constexpr int count = B::count;
+	
+	static constexpr unsigned int mask(int i) { return B::mask(i); }
+	
+	static constexpr int slot(int i) { return (int)mask(i); }
+	
+	static constexpr int find(unsigned int m)
+	{ return B::find(m) >= 0 ? (int)m : -1; }
+	
+	static constexpr unsigned int span() { return B::span(); }
+};
+
+
+//! One term of a product table: out[o] += sign * lhs[l] * rhs[r]
+/*!	The indices are slots within the storage of each operand. */
+struct GAProductTerm
+{
+	int l;
+	int r;
+	int o;
+	int sign;
+};
+
+
+//! The terms of a product table.
+template<int N>
+struct GAProductTerms
+{
+	GAProductTerm term[N > 0 ? N : 1];
+};
+
+
+//! Count the terms of a product that can contribute.
+template<class L, class R, class O, class OP>
+constexpr int GAProductTermCount()
+{
+	int n = 0;
+	for (int i=0; i<L::count; i++)
+	{
+		for (int j=0; j<R::count; j++)
+		{
+			const unsigned int lm = L::mask(i);
+			const unsigned int rm = R::mask(j);
+			
+			if (OP::sign(GABasis(lm), GABasis(rm)) != 0 && O::find(lm ^ rm) >= 0)
+				n++;
+		}
+	}
+	return n;
+}
+
+
+//! Build the terms of a product that can contribute.
+template<class L, class R, class O, class OP, int N>
+constexpr GAProductTerms<N> GAProductTermBuild()
+{
+	GAProductTerms<N> t{};
+	int n = 0;
+	for (int i=0; i<L::count; i++)
+	{
+		for (int j=0; j<R::count; j++)
+		{
+			const unsigned int lm = L::mask(i);
+			const unsigned int rm = R::mask(j);
+			const int sign = OP::sign(GABasis(lm), GABasis(rm));
+			const int o = O::find(lm ^ rm);
+			
+			if (sign != 0 && o >= 0)
+			{
+				t.term[n].l = L::slot(i);
+				t.term[n].r = R::slot(j);
+				t.term[n].o = o;
+				t.term[n].sign = sign;
+				n++;
+			}
+		}
+	}
+	return t;
+}
+
+
+//! Compile-time Cayley table of a product.
+/*!	Lists only the (lhs, rhs, result, sign) quadruples that can be nonzero,
+	so the products never visit a pair that is thrown away.
+ 
+	@tparam	L	Blade layout of the left-hand side (GABlades, GADenseBlades...)
+	@tparam	R	Blade layout of the right-hand side
+	@tparam	O	Blade layout of the result.  Terms landing outside are dropped.
+	@tparam	OP	The operation (GA_GeometricProduct...)
+ */
+template<class L, class R, class O, class OP>
+struct GAProductTable
+{
+	static constexpr int count = GAProductTermCount<L, R, O, OP>();
+	
+	static constexpr GAProductTerms<count> value = GAProductTermBuild<L, R, O, OP, count>();
+};
+
+template<class L, class R, class O, class OP>
+constexpr GAProductTerms<GAProductTable<L, R, O, OP>::count> GAProductTable<L, R, O, OP>::value;
+
+
+#ifndef LGA_UNROLL_LIMIT
+//! Tables with more terms than this are unrolled in chunks of this many terms.
+#define LGA_UNROLL_LIMIT 1024
+#endif
+
+
+//! Unrolled product: a flat list of multiply-adds (the terms FIRST to FIRST + sizeof...(I)).
+/*!	o does not overlap l or r, so each result stays in a register between
+	its terms instead of being stored and loaded back for each one. */
+template<class TABLE, int FIRST, class T, std::size_t... I>
+inline void GAProductApply(T *__restrict o, const T *l, const T *r, std::index_sequence<I...>)
+{
+	(void)o; (void)l; (void)r;	// Unused when nothing can contribute
+	
+	using expand = int[];
+	(void)expand{0, ((o[TABLE::value.term[FIRST + I].o] +=
+					  T(TABLE::value.term[FIRST + I].sign) * l[TABLE::value.term[FIRST + I].l] * r[TABLE::value.term[FIRST + I].r]), 0)...};
+}
+
+
+//! Accumulate a product into o, as described by the table.
+template<class TABLE, class T>
+inline void GAProductApply(T *o, const T *l, const T *r, std::true_type)
+{
+	GAProductApply<TABLE, 0>(o, l, r, std::make_index_sequence<TABLE::count>());
+}
+
+
+//! One chunk of LGA_UNROLL_LIMIT terms of a large table, in its own function.
+template<class TABLE, int CHUNK, class T>
+void GAProductApplyChunk(T *o, const T *l, const T *r)
+{
+	constexpr int first = CHUNK * LGA_UNROLL_LIMIT;
+	constexpr int n = TABLE::count - first < LGA_UNROLL_LIMIT ? TABLE::count - first : LGA_UNROLL_LIMIT;
+	
+	GAProductApply<TABLE, first>(o, l, r, std::make_index_sequence<n>());
+}
+
+
+template<class TABLE, class T, std::size_t... C>
+inline void GAProductApply(T *o, const T *l, const T *r, std::index_sequence<C...>, std::false_type)
+{
+	using expand = int[];
+	(void)expand{0, (GAProductApplyChunk<TABLE, int(C)>(o, l, r), 0)...};
+}
+
+
+//! Large tables (high dimensions) are unrolled chunk by chunk.
+/*!	A loop over the table costs about 1 ns per term, several times the
+	unrolled terms.  Each chunk is its own function (too large to be
+	inlined), so the build time grows linearly with the table. */
+template<class TABLE, class T>
+inline void GAProductApply(T *o, const T *l, const T *r, std::false_type)
+{
+	GAProductApply<TABLE>(o, l, r, std::make_index_sequence<(TABLE::count + LGA_UNROLL_LIMIT - 1) / LGA_UNROLL_LIMIT>(), std::false_type());
+}
+
+
+#ifndef LGA_BLOCK_BITS
+//! Dense products over more basis vectors than this are run block by block.
+#define LGA_BLOCK_BITS 4
+#endif
+
+
+//! The signs of OP split over the low and high vectors of the blades.
+/*!	With the blades split as l = l0 l1 and r = r0 r1 (l0 and r0 over the
+	low vectors), the geometric product and the products that keep some of
+	its pairs (outer, inner, contractions...) are:
+	
+	@code
+		sign(l, r) = (-1)^(grade(l1) grade(r0)) sign(l0, r0) sign(l1, r1)
+	@endcode
+	
+	as long as the pairs kept are those kept by both halves, and the metric
+	contracts each vector on its own.  Other operations use the flat table.
+ */
+template<class OP>
+struct GAProductSplits : public std::false_type {};
+
+template<> struct GAProductSplits<GA_GeometricProduct> : public std::true_type {};
+template<> struct GAProductSplits<GA_InnerProduct> : public std::true_type {};
+template<> struct GAProductSplits<GA_OuterProduct> : public std::true_type {};
+template<> struct GAProductSplits<GA_RightContraction> : public std::true_type {};
+template<> struct GAProductSplits<GA_ScalarProduct> : public std::true_type {};
+
+template<class OP, class S>
+struct GAProductSplits<GAMetricProduct<OP, S>> : public GAProductSplits<OP> {};
+
+
+//! The product of L and R into O is run block by block (see GAProductBlocks).
+template<class L, class R, class O, class OP>
+struct GAProductBlocked : public std::false_type {};
+
+template<GABasis P1, GABasis P2, GABasis P3, class OP>
+struct GAProductBlocked<GADenseBlades<P1>, GADenseBlades<P2>, GADenseBlades<P3>, OP>
+: public std::integral_constant<bool, GAProductSplits<OP>::value && (GAGrade(GABasis(P1 | P2 | P3)) > LGA_BLOCK_BITS)>
+{};
+
+
+template<class L, class R, class O, class OP, class T>
+inline void GAProduct(T *o, const T *l, const T *r);
+
+
+//! Accumulate the product of two blocks into o (see GAProductBlocks).
+/*!	The 4D blocks of floats are specialized with SIMD code in
+	LMultivector_SIMD.h */
+template<class L0, class R0, class O0, class OP, class T>
+struct GABlockKernel
+{
+	static void apply(T *o, const T *l, const T *r)
+	{
+		GAProduct<L0, R0, O0, OP>(o, l, r);
+	}
+};
+
+
+//! Product of dense tuples over many vectors, as products of their blocks.
+/*!	The blades of a GATuple are stored at their mask, so the blades sharing
+	their high vectors are a block of 2^LGA_BLOCK_BITS coefficients.  The
+	table of the high vectors pairs the blocks, and each pair is a small
+	product over the low vectors (see GAProductSplits), run by the 4D SIMD
+	kernels for floats:
+	
+	@code
+		o[l1 ^ r1] += sign(l1, r1) l[l1] r[r1]		// r[r1] with its odd blades negated when l1 is odd
+	@endcode
+	
+	A 9D geometric product is 1024 unrolled 4D products, rather than a loop
+	over a table of 262144 terms.
+ */
+template<class L, class R, class O, class OP>
+struct GAProductBlocks;
+
+template<GABasis P1, GABasis P2, GABasis P3, class OP>
+struct GAProductBlocks<GADenseBlades<P1>, GADenseBlades<P2>, GADenseBlades<P3>, OP>
+{
+	template<class T>
+	static void apply(T *o, const T *l, const T *r)
+	{
+		constexpr unsigned int low = GADeposit((1u << LGA_BLOCK_BITS) - 1, P1 | P2 | P3);
+		
+		typedef GADenseBlades<GABasis(P1 & low)> L0;
+		typedef GADenseBlades<GABasis(P2 & low)> R0;
+		typedef GADenseBlades<GABasis(P3 & low)> O0;
+		typedef GAProductTable<GADenseBlades<GABasis(P1 & ~low)>, GADenseBlades<GABasis(P2 & ~low)>,
+							   GADenseBlades<GABasis(P3 & ~low)>, OP> HIGH;
+		
+		// -l, and r with the blades of an odd number of low vectors negated.
+		T negated[P1+1];
+		T odd[P2+1];
+		for (int b=0; b<=P1; b++)
+			negated[b] = -l[b];
+		for (int b=0; b<=P2; b++)
+			odd[b] = GAGrade(GABasis(b & low)) % 2 == 0 ? r[b] : -r[b];
+		
+		for (int i=0; i<HIGH::count; i++)
+		{
+			const GAProductTerm &t = HIGH::value.term[i];
+			
+			GABlockKernel<L0, R0, O0, OP, T>::apply(o + t.o, (t.sign < 0 ? negated : l) + t.l,
+													(GAGrade(GABasis(t.l)) % 2 == 0 ? r : odd) + t.r);
+		}
+	}
+};
+
+
+template<class L, class R, class O, class OP, class T>
+inline void GAProduct(T *o, const T *l, const T *r, std::false_type)
+{
+	typedef GAProductTable<L, R, O, OP> TABLE;
+	GAProductApply<TABLE>(o, l, r, std::integral_constant<bool, TABLE::count <= LGA_UNROLL_LIMIT>());
+}
+
+
+template<class L, class R, class O, class OP, class T>
+inline void GAProduct(T *o, const T *l, const T *r, std::true_type)
+{
+	GAProductBlocks<L, R, O, OP>::apply(o, l, r);
+}
+
+
+//! Accumulate the product of l and r into o.
+/*!	@tparam	L, R, O, OP		See GAProductTable
+	@param	o				Storage of the result (slots of O), apart from l and r
+	@param	l				Storage of the left-hand side (slots of L)
+	@param	r				Storage of the right-hand side (slots of R)
+ */
+template<class L, class R, class O, class OP, class T>
+inline void GAProduct(T *o, const T *l, const T *r)
+{
+	GAProduct<L, R, O, OP>(o, l, r, GAProductBlocked<L, R, O, OP>());
+}
+
+
+//! Sorted list of masks computed at compile time.
+template<int N>
+struct GAMaskList
+{
+	unsigned int mask[N > 0 ? N : 1];
+};
+
+
+#ifndef LGA_MASK_TABLE_BITS
+//! Sources spanning more basis vectors than this collect their masks in a sorted list.
+#define LGA_MASK_TABLE_BITS 12
+#endif
+
+
+//! Collects masks in a table indexed by the packed bits of the mask.
+/*!	Marking is a single store, and walking the table in order yields the
+	masks sorted, without duplicates.  The table has 2^span entries, so it
+	is only used for narrow spans.
+ */
+template<unsigned int SPAN>
+struct GAMaskTable
+{
+	bool hit[1 << GAGrade(GABasis(SPAN))] = {};
+	
+	constexpr void add(unsigned int m) { hit[GAExtract(m, SPAN)] = true; }
+	
+	//! Number of distinct masks.
+	constexpr int finish() const
+	{
+		int n = 0;
+		for (int i=0; i < (1 << GAGrade(GABasis(SPAN))); i++)
+			if (hit[i])
+				n++;
+		return n;
+	}
+	
+	template<int N>
+	constexpr void copy(GAMaskList<N> &o) const
+	{
+		int n = 0;
+		for (int i=0; i < (1 << GAGrade(GABasis(SPAN))); i++)
+			if (hit[i])
+				o.mask[n++] = GADeposit(i, SPAN);
+	}
+};
+
+
+//! Collects up to N masks in a list, sorted once they are all in.
+/*!	Used for wide spans (up to 32 basis vectors), where the memory is
+	bounded by what the source can mark rather than by the span.  The list
+	is heap sorted (no recursion, n log n steps for the constexpr limits).
+ */
+template<int N>
+struct GAMaskSorted
+{
+	unsigned int mask[N > 0 ? N : 1] = {};
+	int count = 0;
+	
+	constexpr void add(unsigned int m) { mask[count++] = m; }
+	
+	//! Sort, drop the duplicates and return the number of distinct masks.
+	constexpr int finish()
+	{
+		for (int i=count/2 - 1; i >= 0; i--)
+			sift(i, count);
+		for (int end=count - 1; end > 0; end--)
+		{
+			const unsigned int t = mask[0];
+			mask[0] = mask[end];
+			mask[end] = t;
+			sift(0, end);
+		}
+		
+		int n = 0;
+		for (int i=0; i<count; i++)
+			if (n == 0 || mask[n-1] != mask[i])
+				mask[n++] = mask[i];
+		count = n;
+		return n;
+	}
+	
+	template<int M>
+	constexpr void copy(GAMaskList<M> &o) const
+	{
+		for (int i=0; i<count; i++)
+			o.mask[i] = mask[i];
+	}
+	
+private:
+	constexpr void sift(int i, int end)
+	{
+		for (int c = 2*i + 1; c < end; i = c, c = 2*i + 1)
+		{
+			if (c + 1 < end && mask[c] < mask[c + 1])
+				c++;
+			if (mask[i] >= mask[c])
+				return;
+			
+			const unsigned int t = mask[i];
+			mask[i] = mask[c];
+			mask[c] = t;
+		}
+	}
+};
+
+
+//! The collector used for a source, picked by the width of its span.
+template<class SOURCE>
+using GAMaskCollector = typename std::conditional<GAGrade(GABasis(SOURCE::span)) <= LGA_MASK_TABLE_BITS,
+												  GAMaskTable<SOURCE::span>, GAMaskSorted<SOURCE::bound>>::type;
+
+
+//! Count the masks marked by a source.
+/*!	A source provides a span (every mask it marks is a subset of the span),
+	a bound on the number of masks it marks and a mark() routine that adds
+	the masks it produces to a collector.
  */
-enum GABasis
+template<class SOURCE>
+constexpr int GAMaskCount()
 {
-	scalar	= 0x0,	//!< Special value for the scalar
-	e1		= 0x001,
-	e2		= 0x002,
-	e3		= 0x004,
-	e4		= 0x008,
-	e5		= 0x010,
-	e6		= 0x020,
-	e7		= 0x040,
-	e8		= 0x080,
-	e9		= 0x100,
-};
+	GAMaskCollector<SOURCE> c{};
+	SOURCE::mark(c);
+	return c.finish();
+}
 
 
-//! An operation that does the geometric product.
-struct GA_GeometricProduct
+//! List the masks marked by a source, in increasing order.
+template<class SOURCE, int N>
+constexpr GAMaskList<N> GAMaskBuild()
 {
-	template<class X, class Y, class Z>
-	constexpr static void action(X &o, Y &lhs, Z &rhs)
-	{ o += (lhs | rhs); }
-};
+	GAMaskCollector<SOURCE> c{};
+	SOURCE::mark(c);
+	c.finish();
+	
+	GAMaskList<N> o{};
+	c.copy(o);
+	return o;
+}
 
 
-//! An operation that does the inner product.
-struct GA_InnerProduct
+template<class LIST, class SEQ>
+struct GABladesFromList;
+
+template<class LIST, std::size_t... I>
+struct GABladesFromList<LIST, std::index_sequence<I...>>
 {
-	template<class X, class Y, class Z>
-	constexpr static void action(X &o, Y &lhs, Z &rhs)
-	{ o += (lhs * rhs); }
+	typedef GABlades<GABasis(LIST::value.mask[I])...> type;
 };
 
 
-//! An operation that does the outer product.
-struct GA_OuterProduct
+//! Turns the masks marked by a source into a GABlades type.
+template<class SOURCE>
+struct GAMaskSet
 {
-	template<class X, class Y, class Z>
-	constexpr static void action(X &o, Y &lhs, Z &rhs)
-	{ o += (lhs ^ rhs); }
+	static constexpr int count = GAMaskCount<SOURCE>();
+	
+	static constexpr GAMaskList<count> value = GAMaskBuild<SOURCE, count>();
+	
+	typedef typename GABladesFromList<GAMaskSet, std::make_index_sequence<count>>::type type;
 };
 
+template<class SOURCE>
+constexpr GAMaskList<GAMaskSet<SOURCE>::count> GAMaskSet<SOURCE>::value;
 
-//! Determine the grade of a basis
-/*! We define the grade as the number of basis vectors for the given subspace.
-	
-	The order is used for the inner and outer products.
- 
-	@warning	Only meant to be used at compile time
-	@param		t a constant that tells of the type.
- */
-constexpr int GAGrade(const GABasis t)
+
+//! Marks the blades that L OP R can produce.
+template<class L, class R, class OP>
+struct GAProductMarks
 {
-	int o = 0;
-	unsigned int it = (unsigned int)t;
-	while (it > 0)
+	static constexpr unsigned int span = L::span() | R::span();
+	
+	static constexpr int bound = L::count * R::count;
+	
+	template<class C>
+	static constexpr void mark(C &hit)
 	{
-		if ((it & 0x1) == 0x1)
-			o++;
-		it >>= 1;
+		for (int i=0; i<L::count; i++)
+		{
+			for (int j=0; j<R::count; j++)
+			{
+				const unsigned int lm = L::mask(i);
+				const unsigned int rm = R::mask(j);
+				if (OP::sign(GABasis(lm), GABasis(rm)) != 0)
+					hit.add(lm ^ rm);
+			}
+		}
 	}
-	return o;
-}
+};
 
 
-//! Combines multiple basis by multiplying left to right.
-/*!	Consider e1^e2 and e2^e3, the combination is e1^e3 since the e2s cancel out.
- */
-constexpr GABasis operator^(const GABasis left, const GABasis right)
+//! Marks the blades found in either L or R.
+template<class L, class R>
+struct GAUnionMarks
 {
-	return GABasis((unsigned int)left^(unsigned int)right);
-}
+	static constexpr unsigned int span = L::span() | R::span();
+	
+	static constexpr int bound = L::count + R::count;
+	
+	template<class C>
+	static constexpr void mark(C &hit)
+	{
+		for (int i=0; i<L::count; i++)
+			hit.add(L::mask(i));
+		for (int j=0; j<R::count; j++)
+			hit.add(R::mask(j));
+	}
+};
 
-//! Takes two basis and finds the maximum
-/*!	Rather than the minimal combination, what is the largest combination.
-	In other words, find the most logical psedo-vector of the left and right.
- */
-constexpr GABasis operator|(const GABasis left, const GABasis right)
+
+//! Marks the blades of grade K within a blade layout.
+template<class L, int K>
+struct GAGradeMarks
 {
-	return GABasis((unsigned int)left|(unsigned int)right);
-}
+	static constexpr unsigned int span = L::span();
+	
+	static constexpr int bound = L::count;
+	
+	template<class C>
+	static constexpr void mark(C &hit)
+	{
+		for (int i=0; i<L::count; i++)
+			if (GAGrade(GABasis(L::mask(i))) == K)
+				hit.add(L::mask(i));
+	}
+};
 
 
-static_assert(GAGrade(scalar) == 0, "GAGrade: Order(scalar) = 0");
-static_assert(GAGrade(e1) == 1, "GAGrade: Order(e1) = 1");
-static_assert(GAGrade(e3) == 1, "GAGrade: Order(e3) = 1");
-static_assert(GAGrade(e2^e4^e6) == 3, "GAGrade: Order(e2^e4^e6) = 3");
+//! The binomial coefficient, n choose k.
+constexpr int GABinomial(const int n, const int k)
+{
+	long long toRet = 1;	// 32 choose 16 overflows an int on the way
+	for (int i=0; i<k; i++)
+		toRet = toRet * (n - i) / (i + 1);
+	return (k < 0 || k > n) ? 0 : (int)toRet;
+}
 
 
-//! Handles the case where the geometric product is not associative.
-/*! Recall, e1^e2 = -e2^e1.  Each time there is a shift of two elements in the
-	basis, we flip sign.  e1^e2^e3 = -e2^e1^e3.  And this works as dimensions
-	go up.
- 
-	We assume that e1...en come in order, as such put right after left, and
-	see how many elements have to be shifted to sort the e1, e2, e3...
-	elements.
+//! Marks the blades of grade K within the pseudo-scalar PS.
+/*!	Walks the subsets of K basis vectors directly (the next subset with the
+	same number of bits is found with Gosper's hack), so a grade of a wide
+	algebra costs its own size rather than 2^span.
  */
-constexpr int GAProductMultiplyBy(const GABasis left, const GABasis right)
+template<GABasis PS, int K>
+struct GAPseudoScalarGradeMarks
 {
-	const unsigned int uil = (unsigned int)left;
-	const unsigned int uir = (unsigned int)right;
+	static constexpr unsigned int span = PS;
 	
-	// Find the last bit in uil
-	int lastBit = 9;
-	while ( lastBit >= 0 && ((uil >> lastBit) & 0x1) == 0 )
-		lastBit--;
+	static constexpr int bound = GABinomial(GAGrade(PS), K);
 	
-	// Find the bits in right...
-	int sign = 1;
-	for (int rb=0; rb<=9; rb++)
+	template<class C>
+	static constexpr void mark(C &hit)
 	{
-		if ( (uir >> rb) & 0x1)
+		unsigned long long v = (1ull << K) - 1;
+		for (int i=0; i<bound; i++)
 		{
-			// Count every bit we must jump over...
-			for (int j=lastBit; j > rb; j--)
+			hit.add(GADeposit((unsigned int)v, span));
+			
+			if (i + 1 < bound)
 			{
-				if ((uil >> j) & 0x1)
-					sign *= -1;
+				const unsigned long long low = v & (~v + 1);
+				const unsigned long long r = v + low;
+				v = (((r ^ v) >> 2) / low) | r;
 			}
 		}
 	}
-	
-	return sign;
-}
+};
 
-static_assert(GAProductMultiplyBy(e1, e2) == 1, "GAProductMultiplyBy: In order, simple");
-static_assert(GAProductMultiplyBy(e1, e4) == 1, "GAProductMultiplyBy: In order, simple");
-static_assert(GAProductMultiplyBy(e2, e1) == -1, "GAProductMultiplyBy: Reverse order, simple");
-static_assert(GAProductMultiplyBy(e4, e1) == -1, "GAProductMultiplyBy: In order, simple");
-static_assert(GAProductMultiplyBy(e2, e1^e3) == -1, "GAProductMultiplyBy: Middle, with negation");
+static_assert(GABinomial(16, 2) == 120, "GABinomial: 16 choose 2");
+
+
+//! The exact set of blades that L OP R can produce.
+/*!	@code
+		// Vector ^ vector is a pure bivector.
+		typedef GABlades<e1, e2, e3> V;
+		GAProductBlades<V, V, GA_OuterProduct>::type	// GABlades<e1^e2, e1^e3, e2^e3>
+	@endcode
+ */
+template<class L, class R, class OP>
+using GAProductBlades = GAMaskSet<GAProductMarks<L, R, OP>>;
+
+
+//! The union of two blade sets (used for summations).
+template<class L, class R>
+using GAUnionBlades = GAMaskSet<GAUnionMarks<L, R>>;
+
+
+//! All the blades of grade K within the pseudo-scalar PS.
+template<GABasis PS, int K>
+using GAGradeBlades = GAMaskSet<GAPseudoScalarGradeMarks<PS, K>>;
+
+
+//! The blades of grade K within a blade set.
+template<class B, int K>
+using GASelectGrade = GAMaskSet<GAGradeMarks<B, K>>;
+
+
+//! All the blades within the pseudo-scalar PS (the blades of a GATuple<PS>).
+template<GABasis PS>
+using GAAllBlades = GAMaskSet<GAUnionMarks<GADenseBlades<PS>, GABlades<>>>;
 
 
 
@@ -172,21 +1048,24 @@ static_assert(GAProductMultiplyBy(e2, e1^e3) == -1, "GAProductMultiplyBy: Middle
 	@tparam	MV		The integral id.  For scalars, this is 0.  For vectors,
 					this is 1,2,3,...F.  For bivectors, it is 11...FF.
 					For example, e1e2e3 is written as 123.
+	@tparam	S		The metric signature (GAEuclidean, GAProjective...)
  */
-template<GABasis MV, class T = float>
+template<GABasis MV, class T = float, class S = GAEuclidean>
 class GA
 {
 public:
 	GA(T in_t = 0) : t(in_t) {}
 	
 	//! Assigning operator
-	GA<MV, T>&operator=(T in_) { t = in_; return *this; }
+	GA<MV, T, S>&operator=(T in_) { t = in_; return *this; }
 	
 	//! Cast operator
 	operator T() const { return t; }
 	
 	T &operator()() { return t; }
 	
+	T operator()() const { return t; }
+	
 	//! Utility method to get the basis vectors associated with the given multiplier t.
 	/*! @warning For performance, we use the template argument directly when available. */
 	static constexpr GABasis type() { return MV; }
@@ -197,10 +1076,10 @@ protected:
 
 
 //! Return the negative of a GA...
-template<GABasis MV, class T>
-GA<MV, T> operator-(const GA<MV, T> left_)
+template<GABasis MV, class T, class S>
+GA<MV, T, S> operator-(const GA<MV, T, S> left_)
 {
-	return GA<MV,T>(- T(left_));
+	return GA<MV, T, S>(- T(left_));
 }
 
 
@@ -213,59 +1092,101 @@ public:
 };
 
 
+//! Product of two blades that can contribute.
+template<class OP, class T, GABasis M1, GABasis M2, class S>
+constexpr GA<M1^M2, T, S> GABladeMultiply(GA<M1, T, S> l, GA<M2, T, S> r, std::true_type)
+{
+	return GA<M1^M2, T, S>(l() * r() * (T)OP::sign(M1, M2));
+}
+
+
+//! Product of two blades that can never contribute, nothing is evaluated.
+template<class OP, class T, GABasis M1, GABasis M2, class S>
+constexpr GA<M1^M2, T, S> GABladeMultiply(GA<M1, T, S>, GA<M2, T, S>, std::false_type)
+{
+	return GA<M1^M2, T, S>(0);
+}
+
+
+//! Product of two blades for the given operation (GA_OuterProduct...)
+/*!	The metric of the blades is folded into the sign, so a product that
+	contracts a degenerate basis vector is 0 at compile time. */
+template<class OP, class T, GABasis M1, GABasis M2, class S>
+constexpr GA<M1^M2, T, S> GABladeMultiply(GA<M1, T, S> l, GA<M2, T, S> r)
+{
+	typedef typename GAMetricOp<OP, S>::type MOP;
+	return GABladeMultiply<MOP>(l, r, std::integral_constant<bool, MOP::sign(M1, M2) != 0>());
+}
+
+
 //! Product of two GA objects.
-template<class T, GABasis M1, GABasis M2>
-constexpr GA<M1^M2, T> operator| (GA<M1, T> l, GA<M2, T> r)
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GA<M1^M2, T, S> operator| (GA<M1, T, S> l, GA<M2, T, S> r)
 {
-	CompilerEval<GAProductMultiplyBy(M1, M2)> sign;
-	
-	GA<M1^M2, T> result = l() * r() * (T)sign.result();
-	
-	return result;
+	return GABladeMultiply<GA_GeometricProduct>(l, r);
 }
 
 
 //! Product of a GA object with a scalar
-template<class T, GABasis M1>
-constexpr GA<M1, T> operator| (GA<M1, T> l, float r)
+template<class T, GABasis M1, class S>
+constexpr GA<M1, T, S> operator| (GA<M1, T, S> l, float r)
 {
-	GA<M1, T> result = l() * r;
+	GA<M1, T, S> result = l() * r;
 	
 	return result;
 }
 
 
 //! Product of a scalar with a GA object
-template<class T, GABasis M1>
-constexpr GA<M1, T> operator| ( float l, GA<M1, T> r)
+template<class T, GABasis M1, class S>
+constexpr GA<M1, T, S> operator| ( float l, GA<M1, T, S> r)
 {
-	GA<M1, T> result = l * r();
+	GA<M1, T, S> result = l * r();
 	
 	return result;
 }
 
 
 //! Outer product of two GA objects.
-template<class T, GABasis M1, GABasis M2>
-constexpr GA<M1^M2, T> operator^ (GA<M1, T> l, GA<M2, T> r)
+/*!	Zero, without touching either operand, when the blades share a basis. */
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GA<M1^M2, T, S> operator^ (GA<M1, T, S> l, GA<M2, T, S> r)
 {
-	CompilerEval<GAGrade(M1^M2) == GAGrade(M1) + GAGrade(M2) ? 1:0> sign;
-
-	GA<M1^M2, T> result = (l | r) * (T)sign.result();
-	
-	return result;
+	return GABladeMultiply<GA_OuterProduct>(l, r);
 }
 
 
 //! Inner product of two GA objects.
-template<class T, GABasis M1, GABasis M2>
-constexpr GA<M1^M2, T> operator* (GA<M1, T> l, GA<M2, T> r)
+/*!	Zero, without touching either operand, when the left blade is not
+	contained in the right blade. */
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GA<M1^M2, T, S> operator* (GA<M1, T, S> l, GA<M2, T, S> r)
 {
-	CompilerEval<GAGrade(M1^M2) == GAGrade(M2) - GAGrade(M1) ? 1:0> sign;
+	return GABladeMultiply<GA_InnerProduct>(l, r);
+}
 	
-	GA<M1^M2, T> result = (l | r) * (T)sign.result();
 	
-	return result;
+//! Left contraction of two GA objects (same as the inner product, *)
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GA<M1^M2, T, S> LeftContraction(GA<M1, T, S> l, GA<M2, T, S> r)
+{
+	return GABladeMultiply<GA_LeftContraction>(l, r);
+}
+
+
+//! Right contraction of two GA objects.
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GA<M1^M2, T, S> RightContraction(GA<M1, T, S> l, GA<M2, T, S> r)
+{
+	return GABladeMultiply<GA_RightContraction>(l, r);
+}
+
+
+//! Scalar product of two GA objects.
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GA<scalar, T, S> ScalarProduct(GA<M1, T, S> l, GA<M2, T, S> r)
+{
+	return GA<scalar, T, S>(GABladeMultiply<GA_ScalarProduct>(l, r)());
 }
 
 
@@ -273,10 +1194,14 @@ constexpr GA<M1^M2, T> operator* (GA<M1, T> l, GA<M2, T> r)
 /*! Provides a means of holding summations of scalar GA objects
 	@tparam PS	Psuedo-scalar.  Or largest possible type needed...
 	@tparam T	The type (default float)
+	@tparam S	The metric signature (default GAEuclidean).  Products only
+				combine tuples of the same signature.
  */
-template<GABasis PS, class T = float>
+template<GABasis PS, class T = float, class S = GAEuclidean>
 class GATuple
 {
+	static_assert(((unsigned int)PS >> LGA_DENSE_BITS) == 0, "GATuple stores PS+1 coefficients, use a GASparseTuple past LGA_DENSE_BITS");
+	
 public:
 	
 	//! Default...
@@ -284,19 +1209,22 @@ public:
 	
 	//! Copy from another tuple...
 	template<GABasis M1>
-	GATuple(GATuple<M1, T> &in_)
+	GATuple(const GATuple<M1, T, S> &in_)
 	{
-		static_assert(M1 <= PS, "Data loss would ensue");
-		memcpy(_data, in_._data, sizeof(T) * (M1+1));
+		static_assert((M1 & ~PS) == 0, "Data loss would ensue");
+		
+		typedef GADenseBlades<M1> B;
+		for (int i=0; i<B::count; i++)
+			_data[B::mask(i)] = in_._data[B::mask(i)];
 	}
 	
 	//! Fetch - use templates to force computations
 	template<GABasis I>
-	GA<I, T> at() { static_assert(I >= 0 && I <= PS, "range check"); return GA<I,T>(_data[I]); }
+	GA<I, T, S> at() { static_assert(I >= 0 && I <= PS, "range check"); return GA<I, T, S>(_data[I]); }
 	
 	//! Assign - to set a value in the tuple.
 	template<GABasis I>
-	GATuple<PS,T> &operator=(GA<I,T> in_g)
+	GATuple<PS, T, S> &operator=(GA<I, T, S> in_g)
 	{
 		static_assert(I >= 0 && I <= PS, "range check");
 		_data[I] = in_g();
@@ -305,13 +1233,22 @@ public:
 	
 	//! Add a value
 	template<GABasis I>
-	GATuple<PS,T> &operator+=(GA<I,T> in_g)
+	GATuple<PS, T, S> &operator+=(GA<I, T, S> in_g)
 	{
 		static_assert(I >= 0 && I <= PS, "range check");
 		_data[I] += in_g();
 		return *this;
 	}
 	
+	//! Subtract a value
+	template<GABasis I>
+	GATuple<PS, T, S> &operator-=(GA<I, T, S> in_g)
+	{
+		static_assert(I >= 0 && I <= PS, "range check");
+		_data[I] -= in_g();
+		return *this;
+	}
+	
 	
 public:
 	//! Data, the e1... act as an index
@@ -320,40 +1257,31 @@ public:
 };
 
 
-//! Recursive helper structure to help in doing operations over tuples
-template<GABasis X, GABasis MV, class Y, class T>
-struct GAMetaHelper
+//! Visit every blade of a tuple, as a GA object of that blade.
+/*!	operand.action(GA<I, T, S>) is called for I = scalar, e1, e2, e1^e2... MV,
+	as a single flat pack expansion (no recursion, so no depth limit). */
+template<GABasis MV, class T, class S, class Y, std::size_t... I>
+void GATupleForEach(const GATuple<MV, T, S> &tpl, Y &operand, std::index_sequence<I...>)
 {
-	GAMetaHelper<GABasis(X-1), MV, Y, T> _t;
-	
-	GAMetaHelper(GATuple<MV, T> &tpl, Y &operand)
-	: _t(tpl, operand)
-	{
-		GA<X, T> gObj(tpl._data[X]);
-		operand.action(gObj);
-	}
-};
+	using expand = int[];
+	(void)expand{0, (operand.action(GA<GABasis(I), T, S>(tpl._data[I])), 0)...};
+}
 
 
-//! Terminating case within the structure.
-template<GABasis MV, class Y, class T>
-struct GAMetaHelper<scalar, MV, Y, T>
+template<GABasis MV, class T, class S, class Y>
+void GATupleForEach(const GATuple<MV, T, S> &tpl, Y &operand)
 {
-	GAMetaHelper(GATuple<MV, T> &tpl, Y &operand)
-	{
-		GA<scalar, T> gObj(tpl._data[scalar]);
-		operand.action(gObj);
-	}
-};
+	GATupleForEach(tpl, operand, std::make_index_sequence<MV+1>());
+}
 
 
 //! Provide a rudimentary summation.
 /*! This allows us to define a GATuple using the sum of GA objects.
 	As should be the case. */
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1|M2, T> operator+ ( GA<M1, T> l, GA<M2, T> r)
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATuple<M1|M2, T, S> operator+ ( GA<M1, T, S> l, GA<M2, T, S> r)
 {
-	GATuple<M1|M2, T> ret;
+	GATuple<M1|M2, T, S> ret;
 	
 	ret += l;
 	ret += r;
@@ -363,210 +1291,320 @@ constexpr GATuple<M1|M2, T> operator+ ( GA<M1, T> l, GA<M2, T> r)
 
 
 //! Case where we wish to add an element to a multivector
-/*! For performance, use += instead, as we must make copies! */
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1|M2, T> operator+( GATuple<M1, T> l, GA<M2, T> r)
+/*! For performance, use += instead, as we must make copies!  (Or Lazy(),
+	see LMultivector_Expr.h) */
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATuple<M1|M2, T, S> operator+( const GATuple<M1, T, S> &l, GA<M2, T, S> r)
 {
-	GATuple<M1|M2, T> ret(l);
+	GATuple<M1|M2, T, S> ret(l);
 	ret += r;
 	return ret;
 }
 
 
 //! Case where we wish to add an element to a multivector
-/*! For performance, use += instead, as we must make copies! */
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1|M2, T> operator+( GA<M1, T> l, GATuple<M2, T> r)
+/*! For performance, use += instead, as we must make copies!  (Or Lazy(),
+	see LMultivector_Expr.h) */
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATuple<M1|M2, T, S> operator+( GA<M1, T, S> l, const GATuple<M2, T, S> &r)
 {
-	GATuple<M1|M2, T> ret(r);
+	GATuple<M1|M2, T, S> ret(r);
 	ret += l;
 	return ret;
 }
 
 
-//! Utility to add tuples together
-template<class T, GABasis MV>
-struct GATupleSummationUtil
+//! Adding to tuples together
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATuple<M1, T, S>& operator+=(GATuple<M1, T, S>& src, const GATuple<M2, T, S> &r)
 {
-	GATupleSummationUtil(GATuple<MV, T> &in_d)
-	: _dest(in_d)
-	{}
+	static_assert((M2 & ~M1) == 0, "Data loss would ensue");
 	
-	template<GABasis X, class Y>
-	void action(GA<X, Y> &o)
-	{
-		_dest += o;
-	}
+	typedef GADenseBlades<M2> B;
+	for (int i=0; i<B::count; i++)
+		src._data[B::mask(i)] += r._data[B::mask(i)];
+	return src;
+}
+
+
+//! Pseudo-scalar of the blades that L OP R can produce.
+/*!	The result of a tuple product only has room for these.  A GA and a tuple
+	list their pairs (see GAProductBlades).  Two tuples hold every blade of
+	their pseudo-scalars, so the geometric and outer products reach all of
+	M1|M2 (1 ^ x = x), and the inner product all of M2 (1 * x = x).
 	
-private:
-	GATuple<MV, T> &_dest;
-};
+	@code
+		GA<e1> * GATuple<e1^e2^e3>			// GATuple<e2^e3>
+		GATuple<e1^e2> * GATuple<e1^e2^e3>	// GATuple<e1^e2^e3>
+	@endcode
+ */
+template<class L, class R, class OP>
+struct GAProductSpan
+: public std::integral_constant<GABasis, GABasis(GAProductBlades<L, R, OP>::type::span())>
+{};
 
+template<GABasis M1, GABasis M2, class OP>
+struct GAProductSpan<GADenseBlades<M1>, GADenseBlades<M2>, OP>
+: public std::integral_constant<GABasis, GABasis(M1 | M2)>
+{};
+
+template<GABasis M1, GABasis M2>
+struct GAProductSpan<GADenseBlades<M1>, GADenseBlades<M2>, GA_InnerProduct>
+: public std::integral_constant<GABasis, M2>
+{};
+
+template<GABasis M1, GABasis M2, class OP, class S>
+struct GAProductSpan<GADenseBlades<M1>, GADenseBlades<M2>, GAMetricProduct<OP, S>>
+: public GAProductSpan<GADenseBlades<M1>, GADenseBlades<M2>, OP>
+{};
 
-//! Adding to tuples together
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1,T>& operator+=(GATuple<M1,T>& src, GATuple<M2,T> r)
-{
-	GATupleSummationUtil<T, M1> tsu(src);
-	GAMetaHelper<M2, M2, GATupleSummationUtil<T, M1>, T> gmh(r, tsu);
-	return src;
-}
 
+//! The tuple holding l OP r, for the blade layouts L and R.
+template<class OP, class L, class R, class T, class S>
+using GATupleProduct = GATuple<GAProductSpan<L, R, OP>::value, T, S>;
 
-//! Utility to post-multiply by a GA...
-template<class T, GABasis MV, GABasis M2, class OP>
-struct GAPostMultiplyUtil
+
+//! Run a product of a tuple by a GA
+template<class OP, class T, GABasis M1, GABasis M2, class S>
+GATupleProduct<OP, GADenseBlades<M1>, GABlades<M2>, T, S> GATupleMultiply(const GATuple<M1, T, S> &l, GA<M2, T, S> r)
 {
-	GAPostMultiplyUtil(GATuple<MV, T> &in_d, GA<M2, T> &rhs)
-	: _dest(in_d)
-	, _rhs(rhs)
-	{}
-	
-	template<GABasis X, class Y>
-	void action(GA<X, Y> &o)
-	{
-		OP::action(_dest, o, _rhs);
-	}
+	GATupleProduct<OP, GADenseBlades<M1>, GABlades<M2>, T, S> toRet;
+	GAProduct<GADenseBlades<M1>, GABlades<M2>, GADenseBlades<GAProductSpan<GADenseBlades<M1>, GABlades<M2>, OP>::value>,
+			  typename GAMetricOp<OP, S>::type>(toRet._data, l._data, &r());
 	
-private:
-	GATuple<MV, T> &_dest;
-	GA<M2, T> &_rhs;
-};
+	return toRet;
+}
 
 
 //! Multiply a tuple to a GA...
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1|M2, T> operator|( GATuple<M1, T> l, GA<M2, T> r)
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATupleProduct<GA_GeometricProduct, GADenseBlades<M1>, GABlades<M2>, T, S> operator|( const GATuple<M1, T, S> &l, GA<M2, T, S> r)
 {
-	GATuple<M1|M2, T> toRet;
-	GAPostMultiplyUtil<T, M1|M2, M2, GA_GeometricProduct> pmu(toRet, r);
-	GAMetaHelper<M1, M1, GAPostMultiplyUtil<T, M1|M2, M2, GA_GeometricProduct>, T> gmh(l, pmu);
-	
-	return toRet;
+	return GATupleMultiply<GA_GeometricProduct>(l, r);
 }
 
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1|M2, T> operator^( GATuple<M1, T> l, GA<M2, T> r)
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATupleProduct<GA_OuterProduct, GADenseBlades<M1>, GABlades<M2>, T, S> operator^( const GATuple<M1, T, S> &l, GA<M2, T, S> r)
 {
-	GATuple<M1|M2, T> toRet;
-	GAPostMultiplyUtil<T, M1|M2, M2, GA_OuterProduct> pmu(toRet, r);
-	GAMetaHelper<M1, M1, GAPostMultiplyUtil<T, M1|M2, M2, GA_OuterProduct>, T> gmh(l, pmu);
-	
-	return toRet;
+	return GATupleMultiply<GA_OuterProduct>(l, r);
 }
 
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1|M2, T> operator*( GATuple<M1, T> l, GA<M2, T> r)
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATupleProduct<GA_InnerProduct, GADenseBlades<M1>, GABlades<M2>, T, S> operator*( const GATuple<M1, T, S> &l, GA<M2, T, S> r)
+{
+	return GATupleMultiply<GA_InnerProduct>(l, r);
+}
+
+
+//! Run a product of a GA by a tuple
+template<class OP, class T, GABasis M1, GABasis M2, class S>
+GATupleProduct<OP, GABlades<M1>, GADenseBlades<M2>, T, S> GATupleMultiply(GA<M1, T, S> l, const GATuple<M2, T, S> &r)
 {
-	GATuple<M1|M2, T> toRet;
-	GAPostMultiplyUtil<T, M1|M2, M2, GA_InnerProduct> pmu(toRet, r);
-	GAMetaHelper<M1, M1, GAPostMultiplyUtil<T, M1|M2, M2, GA_InnerProduct>, T> gmh(l, pmu);
+	GATupleProduct<OP, GABlades<M1>, GADenseBlades<M2>, T, S> toRet;
+	GAProduct<GABlades<M1>, GADenseBlades<M2>, GADenseBlades<GAProductSpan<GABlades<M1>, GADenseBlades<M2>, OP>::value>,
+			  typename GAMetricOp<OP, S>::type>(toRet._data, &l(), r._data);
 	
 	return toRet;
 }
 
 
-//! Utility to pre-multiply by a GA...
-template<class T, GABasis MV, GABasis M2, class OP>
-struct GAPreMultiplyUtil
+//! Multiply a GA to a tuple...
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATupleProduct<GA_GeometricProduct, GABlades<M1>, GADenseBlades<M2>, T, S> operator|( GA<M1, T, S> l, const GATuple<M2, T, S> &r)
+{
+	return GATupleMultiply<GA_GeometricProduct>(l, r);
+}
+
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATupleProduct<GA_OuterProduct, GABlades<M1>, GADenseBlades<M2>, T, S> operator^( GA<M1, T, S> l, const GATuple<M2, T, S> &r)
+{
+	return GATupleMultiply<GA_OuterProduct>(l, r);
+}
+
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATupleProduct<GA_InnerProduct, GABlades<M1>, GADenseBlades<M2>, T, S> operator*( GA<M1, T, S> l, const GATuple<M2, T, S> &r)
+{
+	return GATupleMultiply<GA_InnerProduct>(l, r);
+}
+
+
+//! Kernel used for the product of a tuple by a tuple
+/*!	The Cayley table only lists the pairs of blades within M1 and M2 that
+	contribute to the result, so the product unrolls into a flat list of
+	multiply-adds (256 for the geometric product in 4D, but only 81 for the
+	outer and inner products).
+ 
+	The common algebras are specialized with SIMD code in LMultivector_SIMD.h
+ */
+template<class OP, GABasis M1, GABasis M2, class T>
+struct GATupleKernel
 {
-	GAPreMultiplyUtil(GATuple<MV, T> &in_d, GA<M2, T> &lhs)
-	: _dest(in_d)
-	, _lhs(lhs)
-	{}
+	//! Storage of the result.
+	typedef GADenseBlades<GAProductSpan<GADenseBlades<M1>, GADenseBlades<M2>, OP>::value> O;
 	
-	template<GABasis X, class Y>
-	void action(GA<X, Y> &o)
+	//! Write l OP r into o (the O::span()+1 coefficients of the result).
+	static void apply(T *o, const T *l, const T *r)
 	{
-		OP::action(_dest, _lhs, o);
+		for (unsigned int b=0; b<=O::span(); b++)
+			o[b] = T(0);
+		GAProduct<GADenseBlades<M1>, GADenseBlades<M2>, O, OP>(o, l, r);
 	}
-	
-private:
-	GATuple<MV, T> &_dest;
-	GA<M2, T> &_lhs;
 };
 
 
-//! Multiply a GA to a tuple...
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1|M2, T> operator|( GA<M1, T> l, GATuple<M2, T> r)
+//! Run a product of a tuple by a tuple
+template<class OP, class T, GABasis M1, GABasis M2, class S>
+GATupleProduct<OP, GADenseBlades<M1>, GADenseBlades<M2>, T, S> GATupleMultiply(const GATuple<M1, T, S> &l, const GATuple<M2, T, S> &r)
 {
-	GATuple<M1|M2, T> toRet;
-	GAPreMultiplyUtil<T, M1|M2, M1, GA_GeometricProduct> pmu(toRet, l);
-	GAMetaHelper<M2, M2, GAPreMultiplyUtil<T, M1|M2, M1, GA_GeometricProduct>, T> gmh(r, pmu);
+	GATupleProduct<OP, GADenseBlades<M1>, GADenseBlades<M2>, T, S> toRet;
+	GATupleKernel<typename GAMetricOp<OP, S>::type, M1, M2, T>::apply(toRet._data, l._data, r._data);
 	
 	return toRet;
 }
 
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1|M2, T> operator^( GA<M1, T> l, GATuple<M2, T> r)
+
+//! Multiply a tuple by a tuple...
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATupleProduct<GA_GeometricProduct, GADenseBlades<M1>, GADenseBlades<M2>, T, S> operator|( const GATuple<M1, T, S> &l, const GATuple<M2, T, S> &r)
+{
+	return GATupleMultiply<GA_GeometricProduct>(l, r);
+}
+
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATupleProduct<GA_OuterProduct, GADenseBlades<M1>, GADenseBlades<M2>, T, S> operator^( const GATuple<M1, T, S> &l, const GATuple<M2, T, S> &r)
+{
+	return GATupleMultiply<GA_OuterProduct>(l, r);
+}
+
+template<class T, GABasis M1, GABasis M2, class S>
+constexpr GATupleProduct<GA_InnerProduct, GADenseBlades<M1>, GADenseBlades<M2>, T, S> operator*( const GATuple<M1, T, S> &l, const GATuple<M2, T, S> &r)
 {
-	GATuple<M1|M2, T> toRet;
-	GAPreMultiplyUtil<T, M1|M2, M1, GA_OuterProduct> pmu(toRet, l);
-	GAMetaHelper<M2, M2, GAPreMultiplyUtil<T, M1|M2, M1, GA_OuterProduct>, T> gmh(r, pmu);
+	return GATupleMultiply<GA_InnerProduct>(l, r);
+}
+
+
+//! Subtracting a tuple from another
+template<class T, GABasis M1, GABasis M2, class S>
+GATuple<M1, T, S> &operator-=(GATuple<M1, T, S> &src, const GATuple<M2, T, S> &r)
+{
+	static_assert((M2 & ~M1) == 0, "Data loss would ensue");
 	
-	return toRet;
+	// Only the blades of M2 (e3 is above e1^e2, but does not hold it).
+	typedef GADenseBlades<M2> B;
+	for (int i=0; i<B::count; i++)
+		src._data[B::mask(i)] -= r._data[B::mask(i)];
+	return src;
 }
 
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1|M2, T> operator*( GA<M1, T> l, GATuple<M2, T> r)
+
+//! Run a product of a tuple by a tuple, in place.
+/*!	The product goes to a separate buffer first, so r may be l (x |= x).
+	The result must fit within l. */
+template<class OP, class T, GABasis M1, GABasis M2, class S>
+GATuple<M1, T, S> &GATupleMultiplyAssign(GATuple<M1, T, S> &l, const GATuple<M2, T, S> &r)
 {
-	GATuple<M1|M2, T> toRet;
-	GAPreMultiplyUtil<T, M1|M2, M1, GA_InnerProduct> pmu(toRet, l);
-	GAMetaHelper<M2, M2, GAPreMultiplyUtil<T, M1|M2, M1, GA_InnerProduct>, T> gmh(r, pmu);
+	static_assert((M2 & ~M1) == 0, "Data loss would ensue");
 	
-	return toRet;
+	T toRet[M1+1] = {0};
+	GATupleKernel<typename GAMetricOp<OP, S>::type, M1, M2, T>::apply(toRet, l._data, r._data);
+	
+	memcpy(l._data, toRet, sizeof(toRet));
+	return l;
 }
 
 
-//! Utility to multiply tuples
-template<class T, GABasis MV, GABasis M2, class OP>
-struct GATupleMultiplyUtil
+//! Run a product of a tuple by a GA, in place.
+template<class OP, class T, GABasis M1, GABasis M2, class S>
+GATuple<M1, T, S> &GATupleMultiplyAssign(GATuple<M1, T, S> &l, GA<M2, T, S> r)
 {
-	GATupleMultiplyUtil(GATuple<MV, T> &in_d, GATuple<M2, T> &rhs)
-	: _dest(in_d)
-	, _rhs(rhs)
-	{}
+	static_assert((M2 & ~M1) == 0, "Data loss would ensue");
 	
-	template<GABasis X, class Y>
-	void action(GA<X, Y> &o)
-	{
-		OP::action(_dest, o, _rhs);
-	}
+	T toRet[M1+1] = {0};
+	GAProduct<GADenseBlades<M1>, GABlades<M2>, GADenseBlades<M1>, typename GAMetricOp<OP, S>::type>(toRet, l._data, &r());
 	
-private:
-	GATuple<MV, T> &_dest;
-	GATuple<M2, T> &_rhs;
-};
+	memcpy(l._data, toRet, sizeof(toRet));
+	return l;
+}
 
 
-//! Multiply a tuple by a tuple...
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1|M2, T> operator|( GATuple<M1, T> l, GATuple<M2, T> r)
+//! In-place geometric product, l = l | r
+template<class T, GABasis M1, GABasis M2, class S>
+GATuple<M1, T, S> &operator|=(GATuple<M1, T, S> &l, const GATuple<M2, T, S> &r)
+{
+	return GATupleMultiplyAssign<GA_GeometricProduct>(l, r);
+}
+
+template<class T, GABasis M1, GABasis M2, class S>
+GATuple<M1, T, S> &operator|=(GATuple<M1, T, S> &l, GA<M2, T, S> r)
+{
+	return GATupleMultiplyAssign<GA_GeometricProduct>(l, r);
+}
+
+
+//! In-place outer product, l = l ^ r
+template<class T, GABasis M1, GABasis M2, class S>
+GATuple<M1, T, S> &operator^=(GATuple<M1, T, S> &l, const GATuple<M2, T, S> &r)
+{
+	return GATupleMultiplyAssign<GA_OuterProduct>(l, r);
+}
+
+template<class T, GABasis M1, GABasis M2, class S>
+GATuple<M1, T, S> &operator^=(GATuple<M1, T, S> &l, GA<M2, T, S> r)
+{
+	return GATupleMultiplyAssign<GA_OuterProduct>(l, r);
+}
+
+
+//! In-place inner product, l = l * r
+template<class T, GABasis M1, GABasis M2, class S>
+GATuple<M1, T, S> &operator*=(GATuple<M1, T, S> &l, const GATuple<M2, T, S> &r)
+{
+	return GATupleMultiplyAssign<GA_InnerProduct>(l, r);
+}
+
+template<class T, GABasis M1, GABasis M2, class S>
+GATuple<M1, T, S> &operator*=(GATuple<M1, T, S> &l, GA<M2, T, S> r)
 {
-	GATuple<M1|M2, T> toRet;
-	GATupleMultiplyUtil<T, M1|M2, M2, GA_GeometricProduct> pmu(toRet, r);
-	GAMetaHelper<M1, M1, GATupleMultiplyUtil<T, M1|M2, M2, GA_GeometricProduct>, T> gmh(l, pmu);
+	return GATupleMultiplyAssign<GA_InnerProduct>(l, r);
+}
+
+
+//! Left contraction of two tuples
+/*!	Every blade of the result is contained in a blade of r, so the result
+	only has room for M2. */
+template<class T, GABasis M1, GABasis M2, class S>
+GATuple<M2, T, S> LeftContraction(const GATuple<M1, T, S> &l, const GATuple<M2, T, S> &r)
+{
+	GATuple<M2, T, S> toRet;
+	GAProduct<GADenseBlades<M1>, GADenseBlades<M2>, GADenseBlades<M2>, typename GAMetricOp<GA_LeftContraction, S>::type>(toRet._data, l._data, r._data);
 	
 	return toRet;
 }
 
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1|M2, T> operator^( GATuple<M1, T> l, GATuple<M2, T> r)
+
+//! Right contraction of two tuples
+/*!	Every blade of the result is contained in a blade of l, so the result
+	only has room for M1. */
+template<class T, GABasis M1, GABasis M2, class S>
+GATuple<M1, T, S> RightContraction(const GATuple<M1, T, S> &l, const GATuple<M2, T, S> &r)
 {
-	GATuple<M1|M2, T> toRet;
-	GATupleMultiplyUtil<T, M1|M2, M2, GA_OuterProduct> pmu(toRet, r);
-	GAMetaHelper<M1, M1, GATupleMultiplyUtil<T, M1|M2, M2, GA_OuterProduct>, T> gmh(l, pmu);
+	GATuple<M1, T, S> toRet;
+	GAProduct<GADenseBlades<M1>, GADenseBlades<M2>, GADenseBlades<M1>, typename GAMetricOp<GA_RightContraction, S>::type>(toRet._data, l._data, r._data);
 	
 	return toRet;
 }
 
-template<class T, GABasis M1, GABasis M2>
-constexpr GATuple<M1|M2, T> operator*( GATuple<M1, T> l, GATuple<M2, T> r)
+
+//! Scalar product of two tuples
+/*!	Only pairs of identical blades are visited. */
+template<class T, GABasis M1, GABasis M2, class S>
+GA<scalar, T, S> ScalarProduct(const GATuple<M1, T, S> &l, const GATuple<M2, T, S> &r)
 {
-	GATuple<M1|M2, T> toRet;
-	GATupleMultiplyUtil<T, M1|M2, M2, GA_InnerProduct> pmu(toRet, r);
-	GAMetaHelper<M1, M1, GATupleMultiplyUtil<T, M1|M2, M2, GA_InnerProduct>, T> gmh(l, pmu);
+	GA<scalar, T, S> toRet;
+	GAProduct<GADenseBlades<M1>, GADenseBlades<M2>, GABlades<scalar>, typename GAMetricOp<GA_ScalarProduct, S>::type>(&toRet(), l._data, r._data);
 	
 	return toRet;
 }
+
+
+#include "LMultivector_SIMD.h"
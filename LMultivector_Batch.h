@@ -0,0 +1,496 @@
+#pragma once//
+
+#include "LMultivector.h"
+#include "LMultivector_Dual.h"
+
+/*!	@file	LMultivector_Batch.h		Structure-of-arrays batches of tuples
+	
+	Operating on one GATuple at a time leaves the compiler nothing to
+	vectorize.  A GATupleBatch holds N tuples as one contiguous lane array
+	per blade, so every term of a product table becomes a multiply-add
+	across the N lanes.
+	
+	@code
+		GATuple<e1^e2^e3> points[1024];
+		GATupleBatch<e1^e2^e3, float, 8> batch;
+		
+		for (int i=0; i<1024; i+=8)
+		{
+			batch.gather(points + i);
+			batch = batch | rotor;
+			batch.scatter(points + i);
+		}
+	@endcode
+	
+	The products are dispatched at run time (see GADispatch), so the lane
+	loops use the widest instruction set of the CPU running the program.
+ */
+
+
+#if defined(__GNUC__) && !defined(__clang__)
+	//! The lanes of the output never overlap the lanes of the operands.
+	#define LGA_IVDEP	_Pragma("GCC ivdep")
+#else
+	#define LGA_IVDEP
+#endif
+
+
+//! N tuples stored as one lane array per blade
+/*!	@tparam PS	Psuedo-scalar, as for GATuple.
+	@tparam T	The type (default float)
+	@tparam N	Number of tuples (lanes) in the batch.
+ */
+template<GABasis PS, class T = float, int N = 8>
+class GATupleBatch
+{
+public:
+	//! Number of tuples within the batch.
+	static constexpr int lanes = N;
+	
+	//! Default, all zeros.
+	GATupleBatch() {}
+	
+	//! Gather N tuples.
+	explicit GATupleBatch(const GATuple<PS, T> *in_)
+	{
+		gather(in_);
+	}
+	
+	//! Gather up to N tuples, the remaining lanes are zero.
+	void gather(const GATuple<PS, T> *in_, int count = N)
+	{
+		assert(count >= 0 && count <= N);
+		
+		for (int b=0; b<=PS; b++)
+		{
+			for (int n=0; n<count; n++)
+				_data[b][n] = in_[n]._data[b];
+			for (int n=count; n<N; n++)
+				_data[b][n] = 0;
+		}
+	}
+	
+	//! Scatter up to N tuples.
+	void scatter(GATuple<PS, T> *out_, int count = N) const
+	{
+		assert(count >= 0 && count <= N);
+		
+		for (int b=0; b<=PS; b++)
+			for (int n=0; n<count; n++)
+				out_[n]._data[b] = _data[b][n];
+	}
+	
+	//! Store one tuple in a lane.
+	void set(int lane, const GATuple<PS, T> &in_)
+	{
+		for (int b=0; b<=PS; b++)
+			_data[b][lane] = in_._data[b];
+	}
+	
+	//! Read one tuple from a lane.
+	GATuple<PS, T> get(int lane) const
+	{
+		GATuple<PS, T> toRet;
+		for (int b=0; b<=PS; b++)
+			toRet._data[b] = _data[b][lane];
+		return toRet;
+	}
+	
+	//! Fetch the lanes of a blade.
+	template<GABasis I>
+	T *at() { static_assert(I >= 0 && I <= PS, "range check"); return _data[I]; }
+	
+	template<GABasis I>
+	const T *at() const { static_assert(I >= 0 && I <= PS, "range check"); return _data[I]; }
+	
+	//! Add a batch, lane by lane.
+	template<GABasis M2>
+	GATupleBatch<PS, T, N> &operator+=(const GATupleBatch<M2, T, N> &in_)
+	{
+		static_assert((M2 & ~PS) == 0, "Data loss would ensue");
+		
+		for (int i=0; i<GADenseBlades<M2>::count; i++)
+		{
+			const int b = GADenseBlades<M2>::slot(i);
+			for (int n=0; n<N; n++)
+				_data[b][n] += in_._data[b][n];
+		}
+		return *this;
+	}
+	
+	//! Add the same tuple to every lane.
+	template<GABasis M2>
+	GATupleBatch<PS, T, N> &operator+=(const GATuple<M2, T> &in_)
+	{
+		static_assert((M2 & ~PS) == 0, "Data loss would ensue");
+		
+		for (int i=0; i<GADenseBlades<M2>::count; i++)
+		{
+			const int b = GADenseBlades<M2>::slot(i);
+			for (int n=0; n<N; n++)
+				_data[b][n] += in_._data[b];
+		}
+		return *this;
+	}
+	
+	//! Add the same GA to every lane.
+	template<GABasis I>
+	GATupleBatch<PS, T, N> &operator+=(GA<I, T> in_g)
+	{
+		static_assert(I >= 0 && I <= PS, "range check");
+		
+		for (int n=0; n<N; n++)
+			_data[I][n] += in_g();
+		return *this;
+	}
+	
+public:
+	//! Data, the e1... act as an index to the lanes of each blade.
+	alignas(64) T _data[PS+1][N] = {};
+};
+
+
+//! out += s * l * r, across the lanes.
+template<int N, class T>
+inline void GABatchMultiplyAdd(T *o, const T *l, const T *r, const T s)
+{
+	LGA_IVDEP
+	for (int n=0; n<N; n++)
+		o[n] += s * l[n] * r[n];
+}
+
+
+//! out += s * l * r, where r is the same for every lane.
+template<int N, class T>
+inline void GABatchMultiplyAdd(T *o, const T *l, const T r, const T s)
+{
+	const T sr = s * r;
+	LGA_IVDEP
+	for (int n=0; n<N; n++)
+		o[n] += sr * l[n];
+}
+
+
+//! out += s * l * r, where l is the same for every lane.
+template<int N, class T>
+inline void GABatchMultiplyAdd(T *o, const T l, const T *r, const T s)
+{
+	const T sl = s * l;
+	LGA_IVDEP
+	for (int n=0; n<N; n++)
+		o[n] += sl * r[n];
+}
+
+
+//! Unrolled batch product: each term of the table is a multiply-add over the lanes.
+/*!	Operands are either lane arrays (T (*)[N]) or tuples shared by every
+	lane (const T *). */
+template<class TABLE, int N, class T, class X, class Y, std::size_t... I>
+inline void GABatchProductApply(T (*o)[N], X l, Y r, std::index_sequence<I...>)
+{
+	(void)o; (void)l; (void)r;	// Unused when nothing can contribute
+	
+	using expand = int[];
+	(void)expand{0, (GABatchMultiplyAdd<N>(o[TABLE::value.term[I].o],
+										   l[TABLE::value.term[I].l],
+										   r[TABLE::value.term[I].r],
+										   T(TABLE::value.term[I].sign)), 0)...};
+}
+
+
+template<class TABLE, int N, class T, class X, class Y>
+inline void GABatchProductApply(T (*o)[N], X l, Y r, std::true_type)
+{
+	GABatchProductApply<TABLE>(o, l, r, std::make_index_sequence<TABLE::count>());
+}
+
+
+template<class TABLE, int N, class T, class X, class Y>
+inline void GABatchProductApply(T (*o)[N], X l, Y r, std::false_type)
+{
+	for (int i=0; i<TABLE::count; i++)
+	{
+		const GAProductTerm &t = TABLE::value.term[i];
+		GABatchMultiplyAdd<N>(o[t.o], l[t.l], r[t.r], T(t.sign));
+	}
+}
+
+
+//! Accumulate the product of l and r into the lanes of o.
+/*!	Same as GAProduct, with every coefficient replaced by N lanes. */
+template<class L, class R, class O, class OP, int N, class T, class X, class Y>
+inline void GABatchProduct(T (*o)[N], X l, Y r)
+{
+	typedef GAProductTable<L, R, O, OP> TABLE;
+	GABatchProductApply<TABLE>(o, l, r, std::integral_constant<bool, TABLE::count <= LGA_UNROLL_LIMIT>());
+}
+
+
+//! Batch product, as a kernel for GADispatch.
+template<class L, class R, class O, class OP>
+struct GABatchKernel
+{
+	template<int N, class T, class X, class Y>
+	static void run(T (*o)[N], X l, Y r)
+	{
+		// The local copy cannot alias l or r, so it can stay in registers.
+		constexpr int rows = O::count > 0 ? O::slot(O::count - 1) + 1 : 1;
+		alignas(64) T acc[rows][N];
+		
+		for (int b=0; b<rows; b++)
+			for (int n=0; n<N; n++)
+				acc[b][n] = o[b][n];
+		
+		GABatchProduct<L, R, O, OP>(acc, l, r);
+		
+		for (int b=0; b<rows; b++)
+			for (int n=0; n<N; n++)
+				o[b][n] = acc[b][n];
+	}
+};
+
+
+//! The batch products win with AVX2 and AVX-512 (SSE4.1 ties the scalar code).
+template<class L, class R, class O, class OP>
+struct GASIMDWins<GABatchKernel<L, R, O, OP>, LGA_SIMD_AVX2>
+: public std::true_type
+{};
+
+template<class L, class R, class O, class OP>
+struct GASIMDWins<GABatchKernel<L, R, O, OP>, LGA_SIMD_AVX512>
+: public std::true_type
+{};
+
+
+//! Accumulate the product of l and r into the lanes of o, for the running CPU.
+template<class L, class R, class O, class OP, int N, class T, class X, class Y>
+inline void GABatchProductDispatch(T (*o)[N], X l, Y r)
+{
+	GADispatch<GABatchKernel<L, R, O, OP>, T (*)[N], X, Y>::apply(o, l, r);
+}
+
+
+//! The batch holding l OP r, for the blade layouts L and R (see GATupleProduct).
+template<class OP, class L, class R, class T, int N>
+using GATupleBatchProduct = GATupleBatch<GAProductSpan<L, R, OP>::value, T, N>;
+
+
+//! Run a product of a batch by a batch
+template<class OP, class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<OP, GADenseBlades<M1>, GADenseBlades<M2>, T, N> GABatchMultiply(const GATupleBatch<M1, T, N> &l, const GATupleBatch<M2, T, N> &r)
+{
+	GATupleBatchProduct<OP, GADenseBlades<M1>, GADenseBlades<M2>, T, N> toRet;
+	GABatchProductDispatch<GADenseBlades<M1>, GADenseBlades<M2>, GADenseBlades<GAProductSpan<GADenseBlades<M1>, GADenseBlades<M2>, OP>::value>, OP>(toRet._data, l._data, r._data);
+	
+	return toRet;
+}
+
+
+//! Run a product of a batch by the same tuple for every lane
+template<class OP, class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<OP, GADenseBlades<M1>, GADenseBlades<M2>, T, N> GABatchMultiply(const GATupleBatch<M1, T, N> &l, const GATuple<M2, T> &r)
+{
+	GATupleBatchProduct<OP, GADenseBlades<M1>, GADenseBlades<M2>, T, N> toRet;
+	GABatchProductDispatch<GADenseBlades<M1>, GADenseBlades<M2>, GADenseBlades<GAProductSpan<GADenseBlades<M1>, GADenseBlades<M2>, OP>::value>, OP>(toRet._data, l._data, r._data);
+	
+	return toRet;
+}
+
+
+//! Run a product of the same tuple for every lane by a batch
+template<class OP, class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<OP, GADenseBlades<M1>, GADenseBlades<M2>, T, N> GABatchMultiply(const GATuple<M1, T> &l, const GATupleBatch<M2, T, N> &r)
+{
+	GATupleBatchProduct<OP, GADenseBlades<M1>, GADenseBlades<M2>, T, N> toRet;
+	GABatchProductDispatch<GADenseBlades<M1>, GADenseBlades<M2>, GADenseBlades<GAProductSpan<GADenseBlades<M1>, GADenseBlades<M2>, OP>::value>, OP>(toRet._data, l._data, r._data);
+	
+	return toRet;
+}
+
+
+//! Run a product of a batch by the same GA for every lane
+template<class OP, class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<OP, GADenseBlades<M1>, GABlades<M2>, T, N> GABatchMultiply(const GATupleBatch<M1, T, N> &l, GA<M2, T> r)
+{
+	GATupleBatchProduct<OP, GADenseBlades<M1>, GABlades<M2>, T, N> toRet;
+	GABatchProductDispatch<GADenseBlades<M1>, GABlades<M2>, GADenseBlades<GAProductSpan<GADenseBlades<M1>, GABlades<M2>, OP>::value>, OP>(toRet._data, l._data, (const T *)&r());
+	
+	return toRet;
+}
+
+
+//! Run a product of the same GA for every lane by a batch
+template<class OP, class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<OP, GABlades<M1>, GADenseBlades<M2>, T, N> GABatchMultiply(GA<M1, T> l, const GATupleBatch<M2, T, N> &r)
+{
+	GATupleBatchProduct<OP, GABlades<M1>, GADenseBlades<M2>, T, N> toRet;
+	GABatchProductDispatch<GABlades<M1>, GADenseBlades<M2>, GADenseBlades<GAProductSpan<GABlades<M1>, GADenseBlades<M2>, OP>::value>, OP>(toRet._data, (const T *)&l(), r._data);
+	
+	return toRet;
+}
+
+
+//! Geometric product, lane by lane.
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_GeometricProduct, GADenseBlades<M1>, GADenseBlades<M2>, T, N> operator|(const GATupleBatch<M1, T, N> &l, const GATupleBatch<M2, T, N> &r)
+{
+	return GABatchMultiply<GA_GeometricProduct>(l, r);
+}
+
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_GeometricProduct, GADenseBlades<M1>, GADenseBlades<M2>, T, N> operator|(const GATupleBatch<M1, T, N> &l, const GATuple<M2, T> &r)
+{
+	return GABatchMultiply<GA_GeometricProduct>(l, r);
+}
+
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_GeometricProduct, GADenseBlades<M1>, GADenseBlades<M2>, T, N> operator|(const GATuple<M1, T> &l, const GATupleBatch<M2, T, N> &r)
+{
+	return GABatchMultiply<GA_GeometricProduct>(l, r);
+}
+
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_GeometricProduct, GADenseBlades<M1>, GABlades<M2>, T, N> operator|(const GATupleBatch<M1, T, N> &l, GA<M2, T> r)
+{
+	return GABatchMultiply<GA_GeometricProduct>(l, r);
+}
+
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_GeometricProduct, GABlades<M1>, GADenseBlades<M2>, T, N> operator|(GA<M1, T> l, const GATupleBatch<M2, T, N> &r)
+{
+	return GABatchMultiply<GA_GeometricProduct>(l, r);
+}
+
+
+//! Outer product, lane by lane.
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_OuterProduct, GADenseBlades<M1>, GADenseBlades<M2>, T, N> operator^(const GATupleBatch<M1, T, N> &l, const GATupleBatch<M2, T, N> &r)
+{
+	return GABatchMultiply<GA_OuterProduct>(l, r);
+}
+
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_OuterProduct, GADenseBlades<M1>, GADenseBlades<M2>, T, N> operator^(const GATupleBatch<M1, T, N> &l, const GATuple<M2, T> &r)
+{
+	return GABatchMultiply<GA_OuterProduct>(l, r);
+}
+
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_OuterProduct, GADenseBlades<M1>, GADenseBlades<M2>, T, N> operator^(const GATuple<M1, T> &l, const GATupleBatch<M2, T, N> &r)
+{
+	return GABatchMultiply<GA_OuterProduct>(l, r);
+}
+
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_OuterProduct, GADenseBlades<M1>, GABlades<M2>, T, N> operator^(const GATupleBatch<M1, T, N> &l, GA<M2, T> r)
+{
+	return GABatchMultiply<GA_OuterProduct>(l, r);
+}
+
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_OuterProduct, GABlades<M1>, GADenseBlades<M2>, T, N> operator^(GA<M1, T> l, const GATupleBatch<M2, T, N> &r)
+{
+	return GABatchMultiply<GA_OuterProduct>(l, r);
+}
+
+
+//! Inner product, lane by lane.
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_InnerProduct, GADenseBlades<M1>, GADenseBlades<M2>, T, N> operator*(const GATupleBatch<M1, T, N> &l, const GATupleBatch<M2, T, N> &r)
+{
+	return GABatchMultiply<GA_InnerProduct>(l, r);
+}
+
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_InnerProduct, GADenseBlades<M1>, GADenseBlades<M2>, T, N> operator*(const GATupleBatch<M1, T, N> &l, const GATuple<M2, T> &r)
+{
+	return GABatchMultiply<GA_InnerProduct>(l, r);
+}
+
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_InnerProduct, GADenseBlades<M1>, GADenseBlades<M2>, T, N> operator*(const GATuple<M1, T> &l, const GATupleBatch<M2, T, N> &r)
+{
+	return GABatchMultiply<GA_InnerProduct>(l, r);
+}
+
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_InnerProduct, GADenseBlades<M1>, GABlades<M2>, T, N> operator*(const GATupleBatch<M1, T, N> &l, GA<M2, T> r)
+{
+	return GABatchMultiply<GA_InnerProduct>(l, r);
+}
+
+template<class T, int N, GABasis M1, GABasis M2>
+GATupleBatchProduct<GA_InnerProduct, GABlades<M1>, GADenseBlades<M2>, T, N> operator*(GA<M1, T> l, const GATupleBatch<M2, T, N> &r)
+{
+	return GABatchMultiply<GA_InnerProduct>(l, r);
+}
+
+
+//! Utility to permute one blade of every lane, see GAComplement.
+template<class MAP, GABasis MV, unsigned int B, class T, int N>
+inline void GABatchComplementBlade(T (*o)[N], const T (*in_)[N])
+{
+	LGA_IVDEP
+	for (int n=0; n<N; n++)
+		o[B ^ MV][n] = GASigned<MAP::sign(MV, GABasis(B))>(in_[B][n]);
+}
+
+
+template<class MAP, GABasis MV, class T, int N, std::size_t... I>
+GATupleBatch<MV, T, N> GAComplement(const GATupleBatch<MV, T, N> &in_, std::index_sequence<I...>)
+{
+	GATupleBatch<MV, T, N> toRet;
+	
+	using expand = int[];
+	(void)expand{0, (GABatchComplementBlade<MAP, MV, GADeposit(I, MV)>(toRet._data, in_._data), 0)...};
+	
+	return toRet;
+}
+
+
+//! Apply a complement (GA_Dual, GA_Undual...) to every tuple within the batch.
+template<class MAP, GABasis MV, class T, int N>
+GATupleBatch<MV, T, N> GAComplement(const GATupleBatch<MV, T, N> &in_)
+{
+	return GAComplement<MAP>(in_, std::make_index_sequence<1 << GAGrade(MV)>());
+}
+
+
+//! Dual of every tuple within the batch (see Dual in LMultivector_Dual.h)
+template<GABasis MV, class T, int N>
+GATupleBatch<MV, T, N> Dual(const GATupleBatch<MV, T, N> &in_)
+{
+	return GAComplement<GA_Dual>(in_);
+}
+
+
+//! Undual of every tuple within the batch
+template<GABasis MV, class T, int N>
+GATupleBatch<MV, T, N> Undual(const GATupleBatch<MV, T, N> &in_)
+{
+	return GAComplement<GA_Undual>(in_);
+}
+
+
+//! Regressive product of every pair of tuples (see Regressive in LMultivector_Dual.h)
+template<GABasis M1, GABasis M2, class T, int N>
+GATupleBatch<M1|M2, T, N> Regressive(const GATupleBatch<M1, T, N> &l, const GATupleBatch<M2, T, N> &r)
+{
+	GATupleBatch<M1|M2, T, N> toRet;
+	GABatchProductDispatch<GADenseBlades<M1>, GADenseBlades<M2>, GAComplementBlades<M1|M2>,
+						   GA_RegressiveProduct<M1|M2>>(toRet._data, l._data, r._data);
+	
+	return toRet;
+}
+
+
+//! Cross product of every pair of tuples (see Cross in LMultivector_Dual.h)
+template<GABasis MV, class T, int N>
+GATupleBatch<MV, T, N> Cross(const GATupleBatch<MV, T, N> &left_, const GATupleBatch<MV, T, N> &right_)
+{
+	GATupleBatch<MV, T, N> toRet;
+	GABatchProductDispatch<GADenseBlades<MV>, GADenseBlades<MV>, GAComplementBlades<MV>,
+						   GA_ComplementResult<GA_OuterProduct, GA_CrossComplement, MV>>(toRet._data, left_._data, right_._data);
+	
+	return toRet;
+}
@@ -0,0 +1,179 @@
+#pragma once//
+
+#include "LMultivector.h"
+
+/*! @file LMultivector_Conformal.h	Points and the null basis of conformal space
+	
+	The conformal 3D algebra (GAConformal) adds e4 = e+ (squares to 1) and
+	e5 = e- (squares to -1) to e1...e3.  The products run in that diagonal
+	basis, where the metric is folded into the Cayley tables.  Geometry is
+	usually written with the null vectors instead:
+		
+		n0 = (e5 - e4) / 2		(the origin)
+		ni = e4 + e5			(the point at infinity)
+	
+	The change of basis only mixes the coefficients of A, A^e4, A^e5 and
+	A^e4^e5 for each blade A of e1...e3, so the kernels below touch those
+	groups directly instead of multiplying by a 32x32 matrix.
+	
+	@code
+		auto p = Conformal::Point(1.0f, 2.0f, 3.0f);
+		auto q = Conformal::Point(2.0f, 2.0f, 3.0f);
+		float d = -2 * ScalarProduct(p, q)();		// |p - q|^2 = 1
+	@endcode
+ */
+
+
+//! Coefficients of a conformal tuple over the null basis.
+/*!	The slot of e4 holds the coefficient of n0 and the slot of e5 the
+	coefficient of ni (e4^e5 holds n0^ni).  There are no products on this
+	type, convert back with FromNullBasis first.
+ */
+template<GABasis PS, class T = float>
+struct GANullCoordinates
+{
+	T _data[PS+1] = {0};
+};
+
+
+//! Blades of PS that do not hold e4 or e5, the groups of the null basis.
+template<GABasis PS>
+constexpr unsigned int GANullRest()
+{
+	static_assert((PS & (e4|e5)) == (e4|e5), "The null basis needs e4 and e5");
+	return (unsigned int)PS & ~(unsigned int)(e4|e5);
+}
+
+
+//! Express a conformal tuple over the null basis.
+/*!	A^e4 = -A^n0 + A^ni/2, A^e5 = A^n0 + A^ni/2 and e4^e5 = -n0^ni. */
+template<GABasis PS, class T>
+GANullCoordinates<PS, T> ToNullBasis(const GATuple<PS, T, GAConformal> &in_)
+{
+	constexpr unsigned int rest = GANullRest<PS>();
+	
+	GANullCoordinates<PS, T> toRet;
+	for (unsigned int i=0; i < (1u << GAGrade(GABasis(rest))); i++)
+	{
+		const unsigned int a = GADeposit(i, rest);
+		const T p = in_._data[a|e4];
+		const T m = in_._data[a|e5];
+		
+		toRet._data[a] = in_._data[a];
+		toRet._data[a|e4] = m - p;
+		toRet._data[a|e5] = T(0.5) * (p + m);
+		toRet._data[a|e4|e5] = -in_._data[a|e4|e5];
+	}
+	return toRet;
+}
+
+
+//! Back from the null basis, the inverse of ToNullBasis.
+template<GABasis PS, class T>
+GATuple<PS, T, GAConformal> FromNullBasis(const GANullCoordinates<PS, T> &in_)
+{
+	constexpr unsigned int rest = GANullRest<PS>();
+	
+	GATuple<PS, T, GAConformal> toRet;
+	for (unsigned int i=0; i < (1u << GAGrade(GABasis(rest))); i++)
+	{
+		const unsigned int a = GADeposit(i, rest);
+		const T o = in_._data[a|e4];
+		const T n = in_._data[a|e5];
+		
+		toRet._data[a] = in_._data[a];
+		toRet._data[a|e4] = n - T(0.5) * o;
+		toRet._data[a|e5] = n + T(0.5) * o;
+		toRet._data[a|e4|e5] = -in_._data[a|e4|e5];
+	}
+	return toRet;
+}
+
+
+namespace Conformal
+{
+	//! A tuple of the conformal 3D algebra.
+	template<class TYPE = float>
+	using Tuple = GATuple<GABasis(e1^e2^e3^e4^e5), TYPE, GAConformal>;
+	
+	
+	//! The origin, n0 = (e5 - e4) / 2
+	template<class TYPE = float>
+	Tuple<TYPE> Origin()
+	{
+		Tuple<TYPE> toRet;
+		toRet._data[e4] = TYPE(-0.5);
+		toRet._data[e5] = TYPE(0.5);
+		return toRet;
+	}
+	
+	
+	//! The point at infinity, ni = e4 + e5
+	template<class TYPE = float>
+	Tuple<TYPE> Infinity()
+	{
+		Tuple<TYPE> toRet;
+		toRet._data[e4] = TYPE(1);
+		toRet._data[e5] = TYPE(1);
+		return toRet;
+	}
+	
+	
+	//! Embed a point, x + x^2/2 ni + n0.
+	/*!	Only the five vector slots are written: e4 = (x^2 - 1)/2 and
+		e5 = (x^2 + 1)/2. */
+	template<class TYPE>
+	Tuple<TYPE> Point(const TYPE x_, const TYPE y_, const TYPE z_)
+	{
+		const TYPE half = TYPE(0.5) * (x_*x_ + y_*y_ + z_*z_);
+		
+		Tuple<TYPE> toRet;
+		toRet._data[e1] = x_;
+		toRet._data[e2] = y_;
+		toRet._data[e3] = z_;
+		toRet._data[e4] = half - TYPE(0.5);
+		toRet._data[e5] = half + TYPE(0.5);
+		return toRet;
+	}
+	
+	
+	//! Embed a Euclidean vector (its grade 1 part).
+	template<class TYPE>
+	Tuple<TYPE> Up(const GATuple<e1^e2^e3, TYPE> &v)
+	{
+		return Point(v._data[e1], v._data[e2], v._data[e3]);
+	}
+	
+	
+	//! The Euclidean point of a conformal point (of any weight).
+	/*!	Divides by -X.ni = e5 - e4, which is 1 for the points of Up. */
+	template<class TYPE>
+	GATuple<e1^e2^e3, TYPE> Down(const Tuple<TYPE> &p)
+	{
+		const TYPE w = TYPE(1) / (p._data[e5] - p._data[e4]);
+		
+		GATuple<e1^e2^e3, TYPE> toRet;
+		toRet._data[e1] = p._data[e1] * w;
+		toRet._data[e2] = p._data[e2] * w;
+		toRet._data[e3] = p._data[e3] * w;
+		return toRet;
+	}
+	
+	
+	//! Embed count points.
+	template<class TYPE>
+	void Up(Tuple<TYPE> *out, const GATuple<e1^e2^e3, TYPE> *in_, std::ptrdiff_t count)
+	{
+		for (std::ptrdiff_t i=0; i<count; i++)
+			out[i] = Up(in_[i]);
+	}
+	
+	
+	//! The Euclidean points of count conformal points.
+	template<class TYPE>
+	void Down(GATuple<e1^e2^e3, TYPE> *out, const Tuple<TYPE> *in_, std::ptrdiff_t count)
+	{
+		for (std::ptrdiff_t i=0; i<count; i++)
+			out[i] = Down(in_[i]);
+	}
+}
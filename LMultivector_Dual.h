@@ -2,9 +2,264 @@
 
 /*!
  *	@file	LMultivector_Dual		Code needed to compute the dual
+	
+	The dual, undual and complements send each blade b of the pseudo-scalar
+	PS to the blade b ^ PS, with a sign.  They are done as a permutation of
+	the coefficients decided at compile time (no multiplies), and can also be
+	read through a view (GATupleComplement) that products fold into their
+	Cayley tables.
  */
 
 #include "LMultivector.h"
+#include "LMultivector_Sparse.h"
+#include "LMultivector_View.h"
+
+
+//! The dual, b _| PS^-1
+struct GA_Dual
+{
+	//! Sign of the blade b ^ PS that the blade b of PS becomes.
+	static constexpr int sign(const GABasis PS, const GABasis b)
+	{
+		// PS^-1 = PS, or -PS when the reverse of PS flips its sign.
+		return (((GAGrade(PS) * (GAGrade(PS)-1)) / 2) % 2 == 0 ? 1 : -1) * GAProductMultiplyBy(b, PS);
+	}
+};
+
+
+//! The undual, b _| PS (undoes GA_Dual)
+struct GA_Undual
+{
+	static constexpr int sign(const GABasis PS, const GABasis b)
+	{ return GAProductMultiplyBy(b, PS); }
+};
+
+
+//! The right complement, such that b ^ complement(b) = PS
+struct GA_RightComplement
+{
+	static constexpr int sign(const GABasis PS, const GABasis b)
+	{ return GAProductMultiplyBy(b, PS ^ b); }
+};
+
+
+//! The left complement, such that complement(b) ^ b = PS
+struct GA_LeftComplement
+{
+	static constexpr int sign(const GABasis PS, const GABasis b)
+	{ return GAProductMultiplyBy(PS ^ b, b); }
+};
+
+
+//! -PS | b, used by Cross
+struct GA_CrossComplement
+{
+	static constexpr int sign(const GABasis PS, const GABasis b)
+	{ return -GAProductMultiplyBy(PS, b); }
+};
+
+
+//! x or -x, with the sign known at compile time
+template<int S, class T>
+constexpr T GASigned(const T &x)
+{
+	return S < 0 ? -x : x;
+}
+
+
+//! Reads (or writes) a blade layout as its complement within PS.
+/*!	The i-th blade is the complement of the i-th blade of LAYOUT, and is
+	stored where that blade is.  As an output, a blade lands where its
+	complement is stored.  The sign comes from the operation
+	(GA_ComplementLeft, GA_ComplementResult, GA_RegressiveProduct).
+ */
+template<class LAYOUT, GABasis PS>
+struct GAComplementLayout
+{
+	static constexpr int count = LAYOUT::count;
+	
+	static constexpr unsigned int mask(int i) { return LAYOUT::mask(i) ^ (unsigned int)PS; }
+	
+	static constexpr int slot(int i) { return LAYOUT::slot(i); }
+	
+	static constexpr int find(unsigned int m)
+	{ return (m & ~(unsigned int)PS) == 0 ? LAYOUT::find(m ^ (unsigned int)PS) : -1; }
+	
+	static constexpr unsigned int span() { return PS; }
+};
+
+
+//! Layout of the complement of a GATuple, read from the tuple's storage.
+template<GABasis PS>
+using GAComplementBlades = GAComplementLayout<GADenseBlades<PS>, PS>;
+
+
+//! OP where the left-hand side is read through GAComplementBlades<PS>
+template<class OP, class MAP, GABasis PS>
+struct GA_ComplementLeft
+{
+	static constexpr int sign(const GABasis left, const GABasis right)
+	{ return MAP::sign(PS, left ^ PS) * OP::sign(left, right); }
+};
+
+
+//! OP where the result is written through GAComplementBlades<PS>
+template<class OP, class MAP, GABasis PS>
+struct GA_ComplementResult
+{
+	static constexpr int sign(const GABasis left, const GABasis right)
+	{ return OP::sign(left, right) * MAP::sign(PS, left ^ right); }
+};
+
+
+//! The regressive product (vee) within PS, l v r = Dual(l) _| r
+/*!	Only the pairs of blades that together span PS contribute.  The blade
+	produced is l ^ r ^ PS, so the result is written through
+	GAComplementLayout.
+ */
+template<GABasis PS>
+struct GA_RegressiveProduct
+{
+	static constexpr int sign(const GABasis left, const GABasis right)
+	{
+		return ((unsigned int)left | (unsigned int)right) == (unsigned int)PS
+				? GA_Dual::sign(PS, left) * GA_InnerProduct::sign(left ^ PS, right) : 0;
+	}
+};
+
+
+//! Marks the complements within PS of the blades of a layout.
+template<class L, GABasis PS>
+struct GAComplementMarks
+{
+	static constexpr unsigned int span = PS;
+	
+	static constexpr int bound = L::count;
+	
+	template<class C>
+	static constexpr void mark(C &hit)
+	{
+		for (int i=0; i<L::count; i++)
+			hit.add(L::mask(i) ^ (unsigned int)PS);
+	}
+};
+
+
+//! The exact set of blades that the regressive product of L and R can produce.
+template<class L, class R, GABasis PS>
+using GARegressiveBlades = GAMaskSet<GAComplementMarks<typename GAProductBlades<L, R, GA_RegressiveProduct<PS>>::type, PS>>;
+
+
+//! The complements within PS of the blades of a layout.
+template<class L, GABasis PS>
+using GAComplementSet = GAMaskSet<GAComplementMarks<L, PS>>;
+
+
+//! Utility to permute the coefficients of a tuple, see GAComplement.
+template<class MAP, GABasis PS, class T, std::size_t... I>
+GATuple<PS, T> GAComplement(const GATuple<PS, T> &in_, std::index_sequence<I...>)
+{
+	GATuple<PS, T> toRet;
+	
+	using expand = int[];
+	(void)expand{0, (toRet._data[GADeposit(I, PS) ^ PS] =
+					 GASigned<MAP::sign(PS, GABasis(GADeposit(I, PS)))>(in_._data[GADeposit(I, PS)]), 0)...};
+	
+	return toRet;
+}
+
+
+//! Apply a complement (GA_Dual, GA_Undual...) to every blade of a tuple.
+template<class MAP, GABasis PS, class T>
+GATuple<PS, T> GAComplement(const GATuple<PS, T> &in_)
+{
+	return GAComplement<MAP>(in_, std::make_index_sequence<1 << GAGrade(PS)>());
+}
+
+
+//! Utility to permute the coefficients of a view, see GAComplement.
+template<class MAP, GABasis PS, class BO, class B, class T, class S, std::size_t... I>
+GASparseTuple<BO, typename std::remove_const<T>::type> GAComplement(const GATupleView<B, T, S> &in_, std::index_sequence<I...>)
+{
+	GASparseTuple<BO, typename std::remove_const<T>::type> toRet;
+	
+	using expand = int[];
+	(void)expand{0, (toRet._data[BO::find(B::mask(I) ^ PS)] =
+					 GASigned<MAP::sign(PS, GABasis(B::mask(I)))>(in_.data()[B::slot(I)]), 0)...};
+	
+	return toRet;
+}
+
+
+//! Apply a complement within PS to every blade of a view.
+/*!	The result only stores the complements of the blades of the view, so
+	the 4 vectors of a point give the 4 trivectors of 3-space.
+ */
+template<class MAP, GABasis PS, class B, class T, class S>
+GASparseTuple<typename GAComplementSet<B, PS>::type, typename std::remove_const<T>::type> GAComplement(const GATupleView<B, T, S> &in_)
+{
+	static_assert((B::span() & ~(unsigned int)PS) == 0, "The view is not within PS");
+	return GAComplement<MAP, PS, typename GAComplementSet<B, PS>::type>(in_, std::make_index_sequence<B::count>());
+}
+
+
+//! A complement of a tuple, read in place.
+/*!	Nothing is copied: the coefficients are read from the tuple, and the
+	products below fold the permutation into their tables.
+	
+	@warning	The view holds a reference, it must not outlive the tuple.
+ */
+template<class MAP, GABasis PS, class T>
+class GATupleComplement
+{
+public:
+	explicit GATupleComplement(const GATuple<PS, T> &in_) : _tuple(in_) {}
+	
+	//! Fetch - use templates to force computations
+	template<GABasis I>
+	GA<I, T> at() const
+	{
+		static_assert((I & ~PS) == 0, "range check");
+		return GA<I, T>(GASigned<MAP::sign(PS, I ^ PS)>(_tuple._data[I ^ PS]));
+	}
+	
+	//! Copy the complement into a tuple.
+	operator GATuple<PS, T>() const { return GAComplement<MAP>(_tuple); }
+	
+	//! The tuple being read.
+	const GATuple<PS, T> &_tuple;
+};
+
+
+//! Run a product of a complement by a tuple
+template<class OP, class MAP, class T, GABasis M1, GABasis M2>
+GATuple<M1|M2, T> GATupleMultiply(const GATupleComplement<MAP, M1, T> &l, const GATuple<M2, T> &r)
+{
+	GATuple<M1|M2, T> toRet;
+	GAProduct<GAComplementBlades<M1>, GADenseBlades<M2>, GADenseBlades<M1|M2>, GA_ComplementLeft<OP, MAP, M1>>(toRet._data, l._tuple._data, r._data);
+	
+	return toRet;
+}
+
+
+template<class MAP, class T, GABasis M1, GABasis M2>
+GATuple<M1|M2, T> operator|(const GATupleComplement<MAP, M1, T> &l, const GATuple<M2, T> &r)
+{
+	return GATupleMultiply<GA_GeometricProduct>(l, r);
+}
+
+template<class MAP, class T, GABasis M1, GABasis M2>
+GATuple<M1|M2, T> operator^(const GATupleComplement<MAP, M1, T> &l, const GATuple<M2, T> &r)
+{
+	return GATupleMultiply<GA_OuterProduct>(l, r);
+}
+
+template<class MAP, class T, GABasis M1, GABasis M2>
+GATuple<M1|M2, T> operator*(const GATupleComplement<MAP, M1, T> &l, const GATuple<M2, T> &r)
+{
+	return GATupleMultiply<GA_InnerProduct>(l, r);
+}
+
 
 /*!	@brief	Computes the dual of a given multivector
  
@@ -18,15 +273,139 @@
 				is the multivector.
  */
 template<GABasis MV, class T>
-GATuple<MV, T> Dual(GATuple<MV, T> in_)
+GATuple<MV, T> Dual(const GATuple<MV, T> &in_)
+{
+	return GAComplement<GA_Dual>(in_);
+}
+
+
+//! Undoes Dual, Undual(Dual(x)) == x
+template<GABasis MV, class T>
+GATuple<MV, T> Undual(const GATuple<MV, T> &in_)
+{
+	return GAComplement<GA_Undual>(in_);
+}
+
+
+//! Right complement, such that b ^ RightComplement(b) is the pseudo-scalar
+template<GABasis MV, class T>
+GATuple<MV, T> RightComplement(const GATuple<MV, T> &in_)
+{
+	return GAComplement<GA_RightComplement>(in_);
+}
+
+
+//! Left complement, such that LeftComplement(b) ^ b is the pseudo-scalar
+template<GABasis MV, class T>
+GATuple<MV, T> LeftComplement(const GATuple<MV, T> &in_)
+{
+	return GAComplement<GA_LeftComplement>(in_);
+}
+
+
+//! Dual of a view, within the span of its layout.
+/*!	Use GAComplement<GA_Dual, PS>(in_) for a wider pseudo-scalar. */
+template<class B, class T, class S>
+GASparseTuple<typename GAComplementSet<B, GABasis(B::span())>::type, typename std::remove_const<T>::type> Dual(const GATupleView<B, T, S> &in_)
+{
+	return GAComplement<GA_Dual, GABasis(B::span())>(in_);
+}
+
+
+//! Undual of a view, within the span of its layout.
+template<class B, class T, class S>
+GASparseTuple<typename GAComplementSet<B, GABasis(B::span())>::type, typename std::remove_const<T>::type> Undual(const GATupleView<B, T, S> &in_)
+{
+	return GAComplement<GA_Undual, GABasis(B::span())>(in_);
+}
+
+
+//! Right complement of a view, within the span of its layout.
+template<class B, class T, class S>
+GASparseTuple<typename GAComplementSet<B, GABasis(B::span())>::type, typename std::remove_const<T>::type> RightComplement(const GATupleView<B, T, S> &in_)
+{
+	return GAComplement<GA_RightComplement, GABasis(B::span())>(in_);
+}
+
+
+//! Left complement of a view, within the span of its layout.
+template<class B, class T, class S>
+GASparseTuple<typename GAComplementSet<B, GABasis(B::span())>::type, typename std::remove_const<T>::type> LeftComplement(const GATupleView<B, T, S> &in_)
+{
+	return GAComplement<GA_LeftComplement, GABasis(B::span())>(in_);
+}
+
+
+//! The dual, read in place (see GATupleComplement)
+/*!	@code
+		auto p = DualView(plane) * line;	// Same as Dual(plane) * line
+	@endcode
+ */
+template<GABasis MV, class T>
+GATupleComplement<GA_Dual, MV, T> DualView(const GATuple<MV, T> &in_)
+{
+	return GATupleComplement<GA_Dual, MV, T>(in_);
+}
+
+
+//! Regressive product, the dual of the outer product of the duals.
+/*!	Regressive(l, r) == Dual(l) * r, within the pseudo-scalar M1|M2.  Only
+	the pairs of blades that span the pseudo-scalar are visited.
+ */
+template<class T, GABasis M1, GABasis M2>
+GATuple<M1|M2, T> Regressive(const GATuple<M1, T> &l, const GATuple<M2, T> &r)
+{
+	GATuple<M1|M2, T> toRet;
+	GAProduct<GADenseBlades<M1>, GADenseBlades<M2>, GAComplementBlades<M1|M2>, GA_RegressiveProduct<M1|M2>>(toRet._data, l._data, r._data);
+	
+	return toRet;
+}
+
+
+//! Regressive product of two sparse tuples, within the pseudo-scalar PS.
+/*!	The result only stores the blades that can be produced, so the product
+	of a grade 2 and a grade 3 sparse tuple in 4D is 12 multiply-adds.
+ 
+	@code
+		auto p = Regressive<e1^e2^e3^e4>(Grade<2>(line), Grade<3>(plane));
+	@endcode
+ */
+template<GABasis PS, class T, class B1, class B2>
+inline GASparseTuple<typename GARegressiveBlades<B1, B2, PS>::type, T> Regressive(const GASparseTuple<B1, T> &l, const GASparseTuple<B2, T> &r)
+{
+	typedef typename GARegressiveBlades<B1, B2, PS>::type BO;
+	
+	GASparseTuple<BO, T> toRet;
+	GAProduct<B1, B2, GAComplementLayout<BO, PS>, GA_RegressiveProduct<PS>>(toRet._data, l._data, r._data);
+	
+	return toRet;
+}
+
+
+//! Regressive product of two views, within the pseudo-scalar PS.
+/*!	Same as for sparse tuples, read from the buffers in place:
+	@code
+		GATupleArrayView<GAGradeBlades<e1^e2^e3^e4, 2>::type, const float> lines(...);
+		auto p = Regressive<e1^e2^e3^e4>(lines[i], planes[i]);
+	@endcode
+ */
+template<GABasis PS, class B1, class T1, class S, class B2, class T2>
+inline GASparseTuple<typename GARegressiveBlades<B1, B2, PS>::type, typename std::remove_const<T1>::type> Regressive(const GATupleView<B1, T1, S> &l, const GATupleView<B2, T2, S> &r)
 {
-	// Compute the exponent
-	CompilerEval<(GAGrade(MV) * (GAGrade(MV)-1)) / 2> grade;
+	typedef typename GARegressiveBlades<B1, B2, PS>::type BO;
 	
-	// -1 to an even number is positive, else negative.
-	GA<MV,T> inverse(grade.result()%2 == 0 ? 1.0 : -1.0);
+	GASparseTuple<BO, typename std::remove_const<T1>::type> toRet;
+	GAProduct<B1, B2, GAComplementLayout<BO, PS>, GA_RegressiveProduct<PS>>(toRet._data, l.data(), r.data());
 	
-	return in_ * inverse;
+	return toRet;
+}
+
+
+//! Regressive product of two views, within the span of their layouts.
+template<class B1, class T1, class S, class B2, class T2>
+inline GASparseTuple<typename GARegressiveBlades<B1, B2, GABasis(B1::span() | B2::span())>::type, typename std::remove_const<T1>::type> Regressive(const GATupleView<B1, T1, S> &l, const GATupleView<B2, T2, S> &r)
+{
+	return Regressive<GABasis(B1::span() | B2::span())>(l, r);
 }
 
 
@@ -37,12 +416,30 @@ GATuple<MV, T> Dual(GATuple<MV, T> in_)
  
 	@return				The cross product
  
-	@warning	We define cross product in terms of the geometric product.
+	@warning	We define cross product in terms of the geometric product,
+				- pseudoscalar | (left_ ^ right_).
  */
 template<GABasis MV, class T>
-GATuple<MV, T> Cross(const GATuple<MV,T> left_, const GATuple<MV,T> right_)
+GATuple<MV, T> Cross(const GATuple<MV,T> &left_, const GATuple<MV,T> &right_)
+{
+	GATuple<MV, T> toRet;
+	GAProduct<GADenseBlades<MV>, GADenseBlades<MV>, GAComplementBlades<MV>,
+			  GA_ComplementResult<GA_OuterProduct, GA_CrossComplement, MV>>(toRet._data, left_._data, right_._data);
+	
+	return toRet;
+}
+
+
+//! Cross product of two views, within the span of their layouts.
+template<class B1, class T1, class S, class B2, class T2>
+auto Cross(const GATupleView<B1, T1, S> &left_, const GATupleView<B2, T2, S> &right_)
 {
-	GA<MV, T> psuedoscalar(1);
+	constexpr GABasis PS = GABasis(B1::span() | B2::span());
+	typedef typename GAComplementSet<typename GAProductBlades<B1, B2, GA_OuterProduct>::type, PS>::type BO;
+	
+	GASparseTuple<BO, typename std::remove_const<T1>::type> toRet;
+	GAProduct<B1, B2, GAComplementLayout<BO, PS>,
+			  GA_ComplementResult<GA_OuterProduct, GA_CrossComplement, PS>>(toRet._data, left_.data(), right_.data());
 	
-	return - psuedoscalar | (left_ ^ right_);
+	return toRet;
 }
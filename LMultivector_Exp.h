@@ -0,0 +1,895 @@
+#pragma once//
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "LMultivector.h"
+#include "LMultivector_Dual.h"
+#include "LMultivector_Sparse.h"
+#include "LMultivector_Batch.h"
+#include "LMultivector_Versor.h"
+
+/*!	@file	LMultivector_Exp.h		Inverse, exponential and logarithm
+	
+	Inverse(x) uses the closed forms of Hitzer and Sangwine up to 5
+	dimensions: a few products by involutions of x, divided by a scalar.
+	Above, the matrix of y -> x | y is solved.
+	
+	Exp(B) of a bivector is the rotor e^B, and Log(R) of a rotor is its
+	bivector.  In 3 dimensions (or less) every bivector squares to a scalar,
+	so e^B = cos|B| + sin|B| B / |B|.  In 4 dimensions B | B has a scalar
+	and a pseudo-scalar part, and the idempotents (1 -+ I) / 2 split B into
+	two planes that each behave as in 3D.  Both are a fixed sequence of
+	multiply-adds with two sines and cosines (or arc tangents), with no
+	branch, so the lanes of a batch are vectorized.  Above 4 dimensions a
+	series is used (scaling and squaring, or repeated square roots).
+	
+	@code
+		GATuple<e1^e2^e3> b;
+		b = GA<e1^e2>(0.35f);
+		
+		auto r = Exp(b);			// Rotation<e1^e2>(-0.7f)
+		auto l = Log(r);			// 0.35 e1^e2
+		auto i = Inverse(x);		// x | i == 1
+	@endcode
+ */
+
+
+//! The sign that the grade involution multiplies a blade by, -1 on odd grades.
+struct GA_GradeInvolution
+{
+	static constexpr int sign(const GABasis b) { return GAGrade(b) % 2 == 0 ? 1 : -1; }
+};
+
+
+//! The reverse as an involution (see Reverse in LMultivector_Versor.h).
+struct GA_Reversion
+{
+	static constexpr int sign(const GABasis b) { return GAReverseSign(b); }
+};
+
+
+//! The Clifford conjugate, the reverse of the grade involution.
+struct GA_CliffordConjugate
+{
+	static constexpr int sign(const GABasis b) { return GAReverseSign(b) * GA_GradeInvolution::sign(b); }
+};
+
+
+//! Negates the grades whose bit is set in GRADES.
+template<unsigned int GRADES>
+struct GA_NegateGrades
+{
+	static constexpr int sign(const GABasis b) { return (GRADES >> GAGrade(b)) & 1 ? -1 : 1; }
+};
+
+
+//! Utility to apply an involution to every blade of a tuple.
+template<class MAP, GABasis PS, class T, std::size_t... I>
+GATuple<PS, T> GAInvolution(const GATuple<PS, T> &in_, std::index_sequence<I...>)
+{
+	GATuple<PS, T> toRet;
+	
+	using expand = int[];
+	(void)expand{0, (toRet._data[GADeposit(I, PS)] =
+					 GASigned<MAP::sign(GABasis(GADeposit(I, PS)))>(in_._data[GADeposit(I, PS)]), 0)...};
+	
+	return toRet;
+}
+
+
+//! Apply an involution (GA_GradeInvolution, GA_CliffordConjugate...) to a tuple.
+template<class MAP, GABasis PS, class T>
+GATuple<PS, T> GAInvolution(const GATuple<PS, T> &in_)
+{
+	return GAInvolution<MAP>(in_, std::make_index_sequence<1 << GAGrade(PS)>());
+}
+
+
+//! Apply an involution to every tuple of a batch.
+template<class MAP, GABasis PS, class T, int N>
+GATupleBatch<PS, T, N> GAInvolution(const GATupleBatch<PS, T, N> &in_)
+{
+	GATupleBatch<PS, T, N> toRet;
+	for (int i=0; i<GADenseBlades<PS>::count; i++)
+	{
+		const unsigned int b = GADenseBlades<PS>::mask(i);
+		const T sign = T(MAP::sign(GABasis(b)));
+		
+		LGA_IVDEP
+		for (int n=0; n<N; n++)
+			toRet._data[b][n] = sign * in_._data[b][n];
+	}
+	return toRet;
+}
+
+
+//! The grade involution, odd grades negated.
+template<GABasis PS, class T>
+GATuple<PS, T> GradeInvolution(const GATuple<PS, T> &in_)
+{
+	return GAInvolution<GA_GradeInvolution>(in_);
+}
+
+
+//! The Clifford conjugate, the reverse with odd grades negated.
+template<GABasis PS, class T>
+GATuple<PS, T> Conjugate(const GATuple<PS, T> &in_)
+{
+	return GAInvolution<GA_CliffordConjugate>(in_);
+}
+
+
+//! The grade involution of every tuple of a batch.
+template<GABasis PS, class T, int N>
+GATupleBatch<PS, T, N> GradeInvolution(const GATupleBatch<PS, T, N> &in_)
+{
+	return GAInvolution<GA_GradeInvolution>(in_);
+}
+
+
+//! The Clifford conjugate of every tuple of a batch.
+template<GABasis PS, class T, int N>
+GATupleBatch<PS, T, N> Conjugate(const GATupleBatch<PS, T, N> &in_)
+{
+	return GAInvolution<GA_CliffordConjugate>(in_);
+}
+
+
+//! The reverse of every tuple of a batch.
+template<GABasis PS, class T, int N>
+GATupleBatch<PS, T, N> Reverse(const GATupleBatch<PS, T, N> &in_)
+{
+	return GAInvolution<GA_Reversion>(in_);
+}
+
+
+//! c ? a : b, as a blend of a and b (which must both be finite).
+/*!	Compilers keep a select on a floating point comparison as a branch, a
+	blend lets the lanes be vectorized. */
+template<class T>
+inline T GASelect(const bool c, const T a, const T b)
+{
+	return b + T(c) * (a - b);
+}
+
+
+//! n / d, or z when d is 0.
+/*!	Blended, and the divide is not conditional (see GASelect). */
+template<class T>
+inline T GADivide(const T n, const T d, const T z)
+{
+	const T zero = T(d == T(0));
+	const T q = n / (d + zero);
+	return q + zero * (z - q);
+}
+
+
+//! Square roots, sines, cosines and arc tangents from <cmath>.
+struct GA_Math
+{
+	template<class T>
+	static T sqrt(const T x) { return T(std::sqrt(x)); }
+	
+	template<class T>
+	static void sincos(const T x, T &s, T &c) { s = T(std::sin(x)); c = T(std::cos(x)); }
+	
+	template<class T>
+	static T atan2(const T y, const T x) { return T(std::atan2(y, x)); }
+};
+
+
+//! Square roots, sines, cosines and arc tangents for floats, within 3e-7.
+/*!	Without a call or a branch (the range reduction and the quadrants are
+	selects), so the lanes of a batch are vectorized.  The square root is
+	x / sqrt(x) from GA_FastRsqrt, with a third Newton step, and the
+	polynomials are those of Cephes.  Other types use GA_Math.
+ */
+struct GA_FastMath
+{
+	static float sqrt(const float x)
+	{
+		const float y = GA_FastRsqrt::apply(x);
+		return x * y * (1.5f - 0.5f * x * y * y);
+	}
+	
+	static void sincos(const float x, float &s, float &c)
+	{
+		// x = j pi / 2 + r, |r| <= pi / 4, pi / 2 in three parts.
+		const float j = std::nearbyint(x * 0.636619772f);
+		const int quadrant = (int)j;
+		const float r = ((x - j * 1.5703125f) - j * 4.837512969970703125e-4f) - j * 7.54978995489188216e-8f;
+		const float r2 = r * r;
+		
+		const float sr = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+		const float cr = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+		
+		const bool swap = (quadrant & 1) != 0;
+		const float sx = swap ? cr : sr;
+		const float cx = swap ? sr : cr;
+		s = (quadrant & 2) != 0 ? -sx : sx;
+		c = ((quadrant + 1) & 2) != 0 ? -cx : cx;
+	}
+	
+	static float atan2(const float y, const float x)
+	{
+		const float ax = std::fabs(x);
+		const float ay = std::fabs(y);
+		
+		// atan(t), t in [0, 1], reduced around tan(pi / 8).
+		const float t = GADivide(std::min(ax, ay), std::max(ax, ay), 0.0f);
+		const bool shift = t > 0.414213562f;
+		const float u = GASelect(shift, (t - 1.0f) / (t + 1.0f), t);
+		const float z = u * u;
+		float a = (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f) * z * u + u;
+		a += GASelect(shift, 0.785398163f, 0.0f);
+		
+		a = GASelect(ay > ax, 1.570796327f - a, a);
+		a = GASelect(x < 0.0f, 3.141592654f - a, a);
+		return std::copysign(a, y);
+	}
+	
+	template<class T>
+	static T sqrt(const T x) { return GA_Math::sqrt(x); }
+	
+	template<class T>
+	static void sincos(const T x, T &s, T &c) { GA_Math::sincos(x, s, c); }
+	
+	template<class T>
+	static T atan2(const T y, const T x) { return GA_Math::atan2(y, x); }
+};
+
+
+//! Layout of the bivectors of a GATuple, read from the tuple's storage.
+template<GABasis PS>
+using GABivectorBlades = GAScatteredBlades<typename GAGradeBlades<PS, 2>::type>;
+
+
+//! x, or 0 when x is negative (rounding can make a sum of squares negative).
+template<class T>
+inline T GAPositive(const T x)
+{
+	using std::fabs;
+	return (x + fabs(x)) / 2;
+}
+
+
+//! sin(x) / x, from sin(x), for x >= 0.
+template<class T>
+inline T GASinc(const T x, const T s)
+{
+	return GADivide(s, x, T(1));
+}
+
+
+//! Utility to compute the scalar (and pseudo-scalar) of b | b on every lane, for a bivector b.
+template<GABasis PS, class O, int N, class T, class X>
+inline void GABivectorSquare(T (*o)[N], X b)
+{
+	for (int n=0; n<N; n++)
+		o[0][n] = T(0);
+	GABatchProduct<GABivectorBlades<PS>, GABivectorBlades<PS>, O, GA_GeometricProduct>(o, b, b);
+}
+
+
+//! e^B from the bivector blades of x, on every lane, in 3 dimensions or less.
+/*!	B | B = -|B|^2, so e^B = cos|B| + sin|B| B / |B|. */
+template<class MATH, GABasis PS, int N, class T>
+inline void GAExp(T (*o)[N], const T (*x)[N], std::integral_constant<int, 3>)
+{
+	typedef GABivectorBlades<PS> B;
+	
+	alignas(64) T b2[1][N];
+	GABivectorSquare<PS, GABlades<scalar>>(b2, x);
+	
+	alignas(64) T c[N];
+	alignas(64) T k[N];
+	LGA_IVDEP
+	for (int n=0; n<N; n++)
+	{
+		const T angle = MATH::sqrt(GAPositive(-b2[0][n]));
+		T s;
+		MATH::sincos(angle, s, c[n]);
+		k[n] = GASinc(angle, s);
+	}
+	
+	for (int b=0; b<=PS; b++)
+		for (int n=0; n<N; n++)
+			o[b][n] = T(0);
+	for (int n=0; n<N; n++)
+		o[scalar][n] = c[n];
+	for (int i=0; i<B::count; i++)
+	{
+		LGA_IVDEP
+		for (int n=0; n<N; n++)
+			o[B::slot(i)][n] = k[n] * x[B::slot(i)][n];
+	}
+}
+
+
+//! e^B from the bivector blades of x, on every lane, in 4 dimensions.
+/*!	B | B = -m + c I.  With the idempotents P = (1 - I) / 2 and Q = (1 + I) / 2,
+	B P squares to -(m + c) P and B Q to -(m - c) Q, so
+	e^B = P (cos p + sin p B / p) + Q (cos q + sin q B / q),
+	where p^2 = m + c and q^2 = m - c.
+ */
+template<class MATH, GABasis PS, int N, class T>
+inline void GAExp(T (*o)[N], const T (*x)[N], std::integral_constant<int, 4>)
+{
+	typedef GABivectorBlades<PS> B;
+	
+	alignas(64) T b2[1][N];
+	alignas(64) T c[1][N];
+	GABivectorSquare<PS, GABlades<scalar>>(b2, x);
+	GABivectorSquare<PS, GABlades<PS>>(c, x);
+	
+	// The scalar, the pseudo-scalar, and the factors of B and B I.
+	alignas(64) T s[N];
+	alignas(64) T i[N];
+	alignas(64) T k[N];
+	alignas(64) T dual[1][N];
+	LGA_IVDEP
+	for (int n=0; n<N; n++)
+	{
+		const T p = MATH::sqrt(GAPositive(c[0][n] - b2[0][n]));
+		const T q = MATH::sqrt(GAPositive(-c[0][n] - b2[0][n]));
+		T sp, cp, sq, cq;
+		MATH::sincos(p, sp, cp);
+		MATH::sincos(q, sq, cq);
+		
+		const T sincp = GASinc(p, sp);
+		const T sincq = GASinc(q, sq);
+		s[n] = (cp + cq) / 2;
+		i[n] = (cq - cp) / 2;
+		k[n] = (sincp + sincq) / 2;
+		dual[0][n] = (sincq - sincp) / 2;
+	}
+	
+	for (int b=0; b<=PS; b++)
+		for (int n=0; n<N; n++)
+			o[b][n] = T(0);
+	for (int n=0; n<N; n++)
+	{
+		o[scalar][n] = s[n];
+		o[PS][n] = i[n];
+	}
+	for (int j=0; j<B::count; j++)
+	{
+		LGA_IVDEP
+		for (int n=0; n<N; n++)
+			o[B::slot(j)][n] = k[n] * x[B::slot(j)][n];
+	}
+	GABatchProduct<B, GABlades<PS>, B, GA_GeometricProduct>(o, x, (const T (*)[N])dual);
+}
+
+
+//! The square root of the sum of the squares of the coefficients.
+template<GABasis PS, class T>
+T GACoefficientNorm(const GATuple<PS, T> &in_)
+{
+	T toRet = T(0);
+	for (int b=0; b<=PS; b++)
+		toRet += in_._data[b] * in_._data[b];
+	
+	using std::sqrt;
+	return T(sqrt(toRet));
+}
+
+
+//! Above 4 dimensions, e^B by scaling and squaring.
+/*!	B is divided by 2^k so its coefficients are within 1/2, the series
+	is summed to the 12th power, then squared k times.
+ */
+template<GABasis PS, class T>
+GATuple<PS, T> GAExpSeries(const GATuple<PS, T> &in_)
+{
+	GATuple<PS, T> bivector;
+	GAScale<GABivectorBlades<PS>>(bivector._data, in_._data, T(1), std::make_index_sequence<GABivectorBlades<PS>::count>());
+	
+	using std::frexp;
+	int k = 0;
+	frexp(GACoefficientNorm(bivector), &k);
+	k = k + 1 > 0 ? k + 1 : 0;
+	GAScale<GADenseBlades<PS>>(bivector._data, bivector._data, T(std::ldexp(1.0, -k)), std::make_index_sequence<GADenseBlades<PS>::count>());
+	
+	// 1 + b (1 + b / 2 (1 + b / 3 (...)))
+	GATuple<PS, T> toRet;
+	toRet._data[scalar] = T(1);
+	for (int j=12; j>=1; j--)
+	{
+		const GATuple<PS, T> be = bivector | toRet;
+		GAScale<GADenseBlades<PS>>(toRet._data, be._data, T(1) / T(j), std::make_index_sequence<GADenseBlades<PS>::count>());
+		toRet._data[scalar] += T(1);
+	}
+	
+	for (int j=0; j<k; j++)
+		toRet = Square(toRet);
+	return toRet;
+}
+
+
+//! The bivector of the rotor x, on every lane, in 3 dimensions or less.
+/*!	x = cos a + sin a B / |B|, |x| does not need to be 1. */
+template<class MATH, GABasis PS, int N, class T>
+inline void GALog(T (*o)[N], const T (*x)[N], std::integral_constant<int, 3>)
+{
+	typedef GABivectorBlades<PS> B;
+	
+	alignas(64) T b2[1][N];
+	GABivectorSquare<PS, GABlades<scalar>>(b2, x);
+	
+	alignas(64) T k[N];
+	LGA_IVDEP
+	for (int n=0; n<N; n++)
+	{
+		const T s = MATH::sqrt(GAPositive(-b2[0][n]));
+		k[n] = GADivide(MATH::atan2(s, x[scalar][n]), s, GADivide(T(1), x[scalar][n], T(0)));
+	}
+	
+	for (int b=0; b<=PS; b++)
+		for (int n=0; n<N; n++)
+			o[b][n] = T(0);
+	for (int i=0; i<B::count; i++)
+	{
+		LGA_IVDEP
+		for (int n=0; n<N; n++)
+			o[B::slot(i)][n] = k[n] * x[B::slot(i)][n];
+	}
+}
+
+
+//! The bivector of the rotor x, on every lane, in 4 dimensions.
+/*!	Undoes GAExp: x P = P (cos p + sin p B / p), so the angle p comes from
+	the scalars of x P and of (x P)^2, and likewise for Q.
+ */
+template<class MATH, GABasis PS, int N, class T>
+inline void GALog(T (*o)[N], const T (*x)[N], std::integral_constant<int, 4>)
+{
+	typedef GABivectorBlades<PS> B;
+	
+	// B I, then B P and B Q.
+	alignas(64) T dual[PS+1][N] = {};
+	const T one = T(1);
+	GABatchProduct<B, GABlades<PS>, B, GA_GeometricProduct>(dual, x, &one);
+	
+	alignas(64) T bp[PS+1][N];
+	alignas(64) T bq[PS+1][N];
+	for (int i=0; i<B::count; i++)
+	{
+		const int b = B::slot(i);
+		LGA_IVDEP
+		for (int n=0; n<N; n++)
+		{
+			bp[b][n] = (x[b][n] - dual[b][n]) / 2;
+			bq[b][n] = (x[b][n] + dual[b][n]) / 2;
+		}
+	}
+	
+	alignas(64) T p2[1][N];
+	alignas(64) T q2[1][N];
+	GABivectorSquare<PS, GABlades<scalar>>(p2, (const T (*)[N])bp);
+	GABivectorSquare<PS, GABlades<scalar>>(q2, (const T (*)[N])bq);
+	
+	alignas(64) T kp[N];
+	alignas(64) T kq[N];
+	LGA_IVDEP
+	for (int n=0; n<N; n++)
+	{
+		const T sp = MATH::sqrt(GAPositive(-2 * p2[0][n]));
+		const T sq = MATH::sqrt(GAPositive(-2 * q2[0][n]));
+		const T cp = x[scalar][n] - x[PS][n];
+		const T cq = x[scalar][n] + x[PS][n];
+		kp[n] = GADivide(MATH::atan2(sp, cp), sp, GADivide(T(1), cp, T(0)));
+		kq[n] = GADivide(MATH::atan2(sq, cq), sq, GADivide(T(1), cq, T(0)));
+	}
+	
+	for (int b=0; b<=PS; b++)
+		for (int n=0; n<N; n++)
+			o[b][n] = T(0);
+	for (int i=0; i<B::count; i++)
+	{
+		const int b = B::slot(i);
+		LGA_IVDEP
+		for (int n=0; n<N; n++)
+			o[b][n] = kp[n] * bp[b][n] + kq[n] * bq[b][n];
+	}
+}
+
+
+template<GABasis PS, class T>
+GATuple<PS, T> Inverse(const GATuple<PS, T> &in_);
+
+
+//! The square root of x, by the iteration of Denman and Beavers.
+template<GABasis PS, class T>
+GATuple<PS, T> GASqrt(const GATuple<PS, T> &in_)
+{
+	GATuple<PS, T> y = in_;
+	GATuple<PS, T> z;
+	z._data[scalar] = T(1);
+	
+	for (int j=0; j<16; j++)
+	{
+		const GATuple<PS, T> yi = Inverse(y);
+		const GATuple<PS, T> zi = Inverse(z);
+		
+		T change = T(0);
+		for (int b=0; b<=PS; b++)
+		{
+			const T next = (y._data[b] + zi._data[b]) / 2;
+			change += (next - y._data[b]) * (next - y._data[b]);
+			y._data[b] = next;
+			z._data[b] = (z._data[b] + yi._data[b]) / 2;
+		}
+		
+		const T norm = GACoefficientNorm(y);
+		if (change <= T(1e-12) * norm * norm)
+			break;
+	}
+	return y;
+}
+
+
+//! Above 4 dimensions, the bivector of the rotor x by inverse scaling and squaring.
+/*!	Square roots are taken until x is within 1/4 of 1, then the series of
+	log(1 + z) is summed to the 16th power and scaled back.
+ */
+template<GABasis PS, class T>
+GATuple<PS, T> GALogSeries(const GATuple<PS, T> &in_)
+{
+	// log(x) = log|x| + log(x / |x|), the scalar is dropped.
+	GATuple<PS, T> y = Normalize(in_);
+	
+	int k = 0;
+	for (; k<32; k++)
+	{
+		GATuple<PS, T> z = y;
+		z._data[scalar] -= T(1);
+		if (GACoefficientNorm(z) <= T(0.25))
+			break;
+		y = GASqrt(y);
+	}
+	
+	// z - z^2 / 2 + z^3 / 3 ...
+	GATuple<PS, T> z = y;
+	z._data[scalar] -= T(1);
+	
+	GATuple<PS, T> power = z;
+	GATuple<PS, T> sum;
+	for (int j=1; j<=16; j++)
+	{
+		const T s = T(j % 2 == 1 ? 1 : -1) / T(j);
+		for (int b=0; b<=PS; b++)
+			sum._data[b] += s * power._data[b];
+		power = power | z;
+	}
+	
+	GATuple<PS, T> toRet;
+	GAScale<GABivectorBlades<PS>>(toRet._data, sum._data, T(std::ldexp(1.0, k)), std::make_index_sequence<GABivectorBlades<PS>::count>());
+	return toRet;
+}
+
+
+//! Above 4 dimensions, the series on every lane.
+template<class MATH, GABasis PS, int N, class T>
+inline void GAExp(T (*o)[N], const T (*x)[N], std::integral_constant<int, 5>)
+{
+	for (int n=0; n<N; n++)
+	{
+		GATuple<PS, T> in_;
+		for (int b=0; b<=PS; b++)
+			in_._data[b] = x[b][n];
+		
+		const GATuple<PS, T> toRet = GAExpSeries(in_);
+		for (int b=0; b<=PS; b++)
+			o[b][n] = toRet._data[b];
+	}
+}
+
+
+template<class MATH, GABasis PS, int N, class T>
+inline void GALog(T (*o)[N], const T (*x)[N], std::integral_constant<int, 5>)
+{
+	for (int n=0; n<N; n++)
+	{
+		GATuple<PS, T> in_;
+		for (int b=0; b<=PS; b++)
+			in_._data[b] = x[b][n];
+		
+		const GATuple<PS, T> toRet = GALogSeries(in_);
+		for (int b=0; b<=PS; b++)
+			o[b][n] = toRet._data[b];
+	}
+}
+
+
+//! Which of the closed forms (or the series) applies to PS.
+template<GABasis PS>
+using GAExpCase = std::integral_constant<int, GAGrade(PS) <= 3 ? 3 : GAGrade(PS) == 4 ? 4 : 5>;
+
+
+//! Runs GAExp or GALog on every lane of batches (or a tuple, as one lane).
+template<GABasis PS, class MATH, bool LOG>
+struct GAExpKernel
+{
+	template<int N, class T>
+	static void apply(T (*o)[N], const T (*x)[N], std::true_type) { GALog<MATH, PS>(o, x, GAExpCase<PS>()); }
+	
+	template<int N, class T>
+	static void apply(T (*o)[N], const T (*x)[N], std::false_type) { GAExp<MATH, PS>(o, x, GAExpCase<PS>()); }
+	
+	template<class T>
+	static GATuple<PS, T> run(const GATuple<PS, T> &in_)
+	{
+		T x[PS+1][1];
+		T o[PS+1][1];
+		for (int b=0; b<=PS; b++)
+			x[b][0] = in_._data[b];
+		
+		apply(o, (const T (*)[1])x, std::integral_constant<bool, LOG>());
+		
+		GATuple<PS, T> toRet;
+		for (int b=0; b<=PS; b++)
+			toRet._data[b] = o[b][0];
+		return toRet;
+	}
+	
+	template<class T, int N>
+	static void run(GATupleBatch<PS, T, N> *o, const GATupleBatch<PS, T, N> *in_, std::ptrdiff_t count)
+	{
+		for (std::ptrdiff_t i=0; i<count; i++)
+		{
+			alignas(64) T acc[PS+1][N];
+			apply(acc, in_[i]._data, std::integral_constant<bool, LOG>());
+			
+			for (int b=0; b<=PS; b++)
+				for (int n=0; n<N; n++)
+					o[i]._data[b][n] = acc[b][n];
+		}
+	}
+};
+
+
+//! Exp wins up to AVX2, Log only with AVX2 (AVX-512 runs both no faster than scalar).
+template<GABasis PS, class MATH, int LEVEL>
+struct GASIMDWins<GAExpKernel<PS, MATH, false>, LEVEL>
+: public std::integral_constant<bool, LEVEL <= LGA_SIMD_AVX2>
+{};
+
+template<GABasis PS, class MATH>
+struct GASIMDWins<GAExpKernel<PS, MATH, true>, LGA_SIMD_AVX2>
+: public std::true_type
+{};
+
+
+//! The rotor e^B, for the bivector blades of x (the other blades are ignored).
+/*!	@tparam	MATH	GA_Math, or GA_FastMath for the polynomial sines.
+	
+	@code
+		auto r = Exp(GA<e1^e2>(0.5f) + GA<e3^e4>(0.25f));	// GATuple<e1^e2^e3^e4>
+	@endcode
+ */
+template<class MATH = GA_Math, GABasis PS, class T>
+GATuple<PS, T> Exp(const GATuple<PS, T> &in_)
+{
+	return GAExpKernel<PS, MATH, false>::run(in_);
+}
+
+
+//! The rotor e^B of a sparse bivector.
+template<class MATH = GA_Math, class B, class T>
+GASparseTuple<typename GAEvenBlades<GABasis(B::span())>::type, T> Exp(const GASparseTuple<B, T> &in_)
+{
+	constexpr GABasis PS = GABasis(B::span());
+	static_assert(GASelectGrade<B, 2>::count == B::count, "Exp takes a bivector");
+	
+	return GASparseTuple<typename GAEvenBlades<PS>::type, T>(Exp<MATH>(in_.template tuple<PS>()));
+}
+
+
+//! The bivector B of a rotor, such that Exp(B) is the rotor.
+/*!	Only the even blades of x are read.  The rotor does not need to be
+	normalized, and the angles are within [0, pi] (the rotor -1 has no
+	logarithm).
+ */
+template<class MATH = GA_Math, GABasis PS, class T>
+GATuple<PS, T> Log(const GATuple<PS, T> &in_)
+{
+	return GAExpKernel<PS, MATH, true>::run(in_);
+}
+
+
+//! The bivector of a sparse rotor.
+template<class MATH = GA_Math, class B, class T>
+GASparseTuple<typename GAGradeBlades<GABasis(B::span()), 2>::type, T> Log(const GASparseTuple<B, T> &in_)
+{
+	constexpr GABasis PS = GABasis(B::span());
+	return GASparseTuple<typename GAGradeBlades<PS, 2>::type, T>(Log<MATH>(in_.template tuple<PS>()));
+}
+
+
+//! Utility to divide the numerator of an inverse by x | n (a scalar).
+template<GABasis PS, class T>
+GATuple<PS, T> GAInverseDivide(const GATuple<PS, T> &n, const GATuple<PS, T> &x)
+{
+	T d = T(0);
+	GAProduct<GADenseBlades<PS>, GADenseBlades<PS>, GABlades<scalar>, GA_GeometricProduct>(&d, x._data, n._data);
+	
+	GATuple<PS, T> toRet;
+	GAScale<GADenseBlades<PS>>(toRet._data, n._data, T(1) / d, std::make_index_sequence<GADenseBlades<PS>::count>());
+	return toRet;
+}
+
+
+//! Utility to divide the numerators of a batch by x | n, lane by lane.
+template<GABasis PS, class T, int N>
+GATupleBatch<PS, T, N> GAInverseDivide(const GATupleBatch<PS, T, N> &n, const GATupleBatch<PS, T, N> &x)
+{
+	alignas(64) T d[1][N] = {};
+	GABatchProduct<GADenseBlades<PS>, GADenseBlades<PS>, GABlades<scalar>, GA_GeometricProduct>(d, x._data, n._data);
+	
+	LGA_IVDEP
+	for (int i=0; i<N; i++)
+		d[0][i] = T(1) / d[0][i];
+	
+	GATupleBatch<PS, T, N> toRet;
+	for (int b=0; b<=PS; b++)
+	{
+		LGA_IVDEP
+		for (int i=0; i<N; i++)
+			toRet._data[b][i] = n._data[b][i] * d[0][i];
+	}
+	return toRet;
+}
+
+
+//! Up to 2 dimensions, x^-1 = Conjugate(x) / (x Conjugate(x)).
+template<class X>
+X GAInverse(const X &x, std::integral_constant<int, 2>)
+{
+	return GAInverseDivide(Conjugate(x), x);
+}
+
+
+//! In 3 dimensions, the numerator is Conjugate(x) GradeInvolution(x) Reverse(x).
+template<class X>
+X GAInverse(const X &x, std::integral_constant<int, 3>)
+{
+	return GAInverseDivide((Conjugate(x) | GradeInvolution(x)) | Reverse(x), x);
+}
+
+
+//! In 4 dimensions, with c = x Conjugate(x), the numerator is Conjugate(x) c', grades 3 and 4 of c' negated.
+template<class X>
+X GAInverse(const X &x, std::integral_constant<int, 4>)
+{
+	const X conjugate = Conjugate(x);
+	return GAInverseDivide(conjugate | GAInvolution<GA_NegateGrades<(1 << 3) | (1 << 4)>>(x | conjugate), x);
+}
+
+
+//! In 5 dimensions, with c = Conjugate(x) GradeInvolution(x) Reverse(x), the numerator is c (x c)', grades 1 and 4 of (x c)' negated.
+template<class X>
+X GAInverse(const X &x, std::integral_constant<int, 5>)
+{
+	const X c = (Conjugate(x) | GradeInvolution(x)) | Reverse(x);
+	return GAInverseDivide(c | GAInvolution<GA_NegateGrades<(1 << 1) | (1 << 4)>>(x | c), x);
+}
+
+
+//! Above 5 dimensions, solve x | y = 1 (Gaussian elimination).
+template<GABasis PS, class T>
+GATuple<PS, T> GAInverse(const GATuple<PS, T> &x, std::integral_constant<int, 6>)
+{
+	typedef typename GAAllBlades<PS>::type A;
+	const int n = A::count;
+	
+	// m[o][r] is the coefficient of x | e_r on e_o, the last column is 1.
+	typedef GAProductTable<A, A, A, GA_GeometricProduct> TABLE;
+	std::vector<T> m(n * (n + 1), T(0));
+	for (int i=0; i<TABLE::count; i++)
+	{
+		const GAProductTerm &t = TABLE::value.term[i];
+		m[t.o * (n + 1) + t.r] += T(t.sign) * x._data[A::mask(t.l)];
+	}
+	m[A::find(scalar) * (n + 1) + n] = T(1);
+	
+	using std::fabs;
+	for (int c=0; c<n; c++)
+	{
+		int pivot = c;
+		for (int r=c+1; r<n; r++)
+			if (fabs(m[r * (n + 1) + c]) > fabs(m[pivot * (n + 1) + c]))
+				pivot = r;
+		for (int k=c; k<=n; k++)
+			std::swap(m[c * (n + 1) + k], m[pivot * (n + 1) + k]);
+		
+		const T inverse = T(1) / m[c * (n + 1) + c];
+		for (int r=0; r<n; r++)
+		{
+			const T f = m[r * (n + 1) + c] * inverse;
+			if (r == c || f == T(0))
+				continue;
+			for (int k=c; k<=n; k++)
+				m[r * (n + 1) + k] -= f * m[c * (n + 1) + k];
+		}
+	}
+	
+	GATuple<PS, T> toRet;
+	for (int i=0; i<n; i++)
+		toRet._data[A::mask(i)] = m[i * (n + 1) + n] / m[i * (n + 1) + i];
+	return toRet;
+}
+
+
+//! Above 5 dimensions, every lane on its own.
+template<GABasis PS, class T, int N>
+GATupleBatch<PS, T, N> GAInverse(const GATupleBatch<PS, T, N> &x, std::integral_constant<int, 6>)
+{
+	GATupleBatch<PS, T, N> toRet;
+	for (int n=0; n<N; n++)
+		toRet.set(n, GAInverse(x.get(n), std::integral_constant<int, 6>()));
+	return toRet;
+}
+
+
+//! Which of the inverse formulas applies to PS.
+template<GABasis PS>
+using GAInverseCase = std::integral_constant<int, GAGrade(PS) <= 2 ? 2 : GAGrade(PS) <= 5 ? GAGrade(PS) : 6>;
+
+
+//! The inverse, x | Inverse(x) == 1.
+/*!	A multivector that is not invertible gives infinities (or NaN). */
+template<GABasis PS, class T>
+GATuple<PS, T> Inverse(const GATuple<PS, T> &in_)
+{
+	return GAInverse(in_, GAInverseCase<PS>());
+}
+
+
+//! The inverse of every tuple of a batch.
+template<GABasis PS, class T, int N>
+GATupleBatch<PS, T, N> Inverse(const GATupleBatch<PS, T, N> &in_)
+{
+	return GAInverse(in_, GAInverseCase<PS>());
+}
+
+
+//! e^B for the bivector of every tuple of count batches, out may be in_.
+/*!	Uses GA_FastMath by default, so the lanes are vectorized. */
+template<class MATH = GA_FastMath, GABasis PS, class T, int N>
+void Exp(GATupleBatch<PS, T, N> *out_, const GATupleBatch<PS, T, N> *in_, std::ptrdiff_t count)
+{
+	typedef GATupleBatch<PS, T, N> Batch;
+	GADispatch<GAExpKernel<PS, MATH, false>, Batch *, const Batch *, std::ptrdiff_t>::apply(out_, in_, count);
+}
+
+
+//! The bivector of the rotor of every tuple of count batches, out may be in_.
+template<class MATH = GA_FastMath, GABasis PS, class T, int N>
+void Log(GATupleBatch<PS, T, N> *out_, const GATupleBatch<PS, T, N> *in_, std::ptrdiff_t count)
+{
+	typedef GATupleBatch<PS, T, N> Batch;
+	GADispatch<GAExpKernel<PS, MATH, true>, Batch *, const Batch *, std::ptrdiff_t>::apply(out_, in_, count);
+}
+
+
+//! e^B for the bivector of every tuple of a batch.
+template<class MATH = GA_FastMath, GABasis PS, class T, int N>
+GATupleBatch<PS, T, N> Exp(const GATupleBatch<PS, T, N> &in_)
+{
+	GATupleBatch<PS, T, N> toRet;
+	Exp<MATH>(&toRet, &in_, 1);
+	return toRet;
+}
+
+
+//! The bivector of the rotor of every tuple of a batch.
+template<class MATH = GA_FastMath, GABasis PS, class T, int N>
+GATupleBatch<PS, T, N> Log(const GATupleBatch<PS, T, N> &in_)
+{
+	GATupleBatch<PS, T, N> toRet;
+	Log<MATH>(&toRet, &in_, 1);
+	return toRet;
+}
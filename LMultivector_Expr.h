@@ -0,0 +1,525 @@
+#pragma once//
+
+#include "LMultivector.h"
+#include "LMultivector_Sparse.h"
+
+/*!	@file	LMultivector_Expr.h		Lazy expressions over tuples
+	
+	Every operator on a GATuple returns a new dense tuple, so p1 ^ p2 ^ p3
+	builds an intermediate for p1 ^ p2 before the second product is done.
+	
+	Wrapping an operand with Lazy() makes the operators build an expression
+	instead.  Nothing is computed until the expression is stored in a tuple
+	(or a sparse tuple), and then only the blades that are stored are
+	evaluated:
+	
+	@code
+		GATuple<e1^e2^e3^e4> p1, p2, p3;
+		
+		// Only the four trivectors of the plane are computed, and the
+		// bivectors of p1 ^ p2 that they need.
+		GASparseTuple<GAGradeBlades<e1^e2^e3^e4, 3>::type> plane = Lazy(p1) ^ p2 ^ p3;
+		
+		// Sums are fused into a single pass.
+		GATuple<e1^e2^e3> s = Lazy(a) + b - c;
+	@endcode
+	
+	Each node of an expression knows the blades it can produce at compile
+	time (like a GASparseTuple), and accumulates only the blades it is asked
+	for.  A product works out which blades of its operands reach the blades
+	asked for, evaluates only those (once), and runs the product table on
+	them.
+	
+	@warning	Expressions keep references to the tuples they are built from.
+				Do not keep an expression (auto) beyond the lifetime of its
+				tuples.
+ */
+
+
+//! Marks the blades found in both L and R.
+template<class L, class R>
+struct GAIntersectMarks
+{
+	static constexpr unsigned int span = L::span() & R::span();
+	
+	static constexpr int bound = L::count;
+	
+	template<class C>
+	static constexpr void mark(C &hit)
+	{
+		for (int i=0; i<L::count; i++)
+			if (R::find(L::mask(i)) >= 0)
+				hit.add(L::mask(i));
+	}
+};
+
+
+//! Marks the blades of A that reach a blade of D through a product with B.
+/*!	@tparam	LEFT	A is the left-hand side of the product (else the right). */
+template<class A, class B, class D, class OP, bool LEFT>
+struct GADemandMarks
+{
+	static constexpr unsigned int span = A::span();
+	
+	static constexpr int bound = A::count;
+	
+	template<class C>
+	static constexpr void mark(C &hit)
+	{
+		for (int i=0; i<A::count; i++)
+		{
+			for (int j=0; j<B::count; j++)
+			{
+				const unsigned int am = A::mask(i);
+				const unsigned int bm = B::mask(j);
+				const int sign = LEFT ? OP::sign(GABasis(am), GABasis(bm)) : OP::sign(GABasis(bm), GABasis(am));
+				
+				if (sign != 0 && D::find(am ^ bm) >= 0)
+					hit.add(am);
+			}
+		}
+	}
+};
+
+
+//! Layout of the blades of D that are also in the set B.
+/*!	The blades keep their slots within D, so a sub-expression writes
+	straight into the storage of its parent. */
+template<class D, class B>
+struct GAFilteredBlades
+{
+	typedef typename GAMaskSet<GAIntersectMarks<D, B>>::type Blades;
+	
+	static constexpr int count = Blades::count;
+	
+	static constexpr unsigned int mask(int i) { return Blades::mask(i); }
+	
+	static constexpr int slot(int i) { return D::find(mask(i)); }
+	
+	static constexpr int find(unsigned int m)
+	{ return Blades::find(m) >= 0 ? D::find(m) : -1; }
+	
+	static constexpr unsigned int span() { return Blades::span(); }
+};
+
+
+//! Base of every node of an expression
+/*!	A node E provides:
+	- Type, the type of the coefficients,
+	- Blades, a GABlades of the blades it can produce,
+	- accumulate<D>(o, s), which adds s times each blade of the layout D
+	  into o (blades of D it cannot produce are left alone).
+ */
+template<class E>
+struct GAExpr
+{
+	const E &self() const { return static_cast<const E &>(*this); }
+	
+	//! Evaluate every blade the expression can produce.
+	auto eval() const
+	{
+		GASparseTuple<typename E::Blades, typename E::Type> toRet;
+		self().template accumulate<typename E::Blades>(toRet._data, typename E::Type(1));
+		return toRet;
+	}
+	
+	//! Evaluate into a tuple.
+	template<GABasis PS, class T>
+	operator GATuple<PS, T>() const
+	{
+		static_assert(std::is_same<T, typename E::Type>::value, "Mixed types");
+		static_assert((E::Blades::span() & ~(unsigned int)PS) == 0, "Data loss would ensue");
+		
+		GATuple<PS, T> toRet;
+		self().template accumulate<GADenseBlades<PS>>(toRet._data, T(1));
+		return toRet;
+	}
+	
+	//! Evaluate into a sparse tuple, only its blades are computed.
+	template<class B, class T>
+	operator GASparseTuple<B, T>() const
+	{
+		static_assert(std::is_same<T, typename E::Type>::value, "Mixed types");
+		
+		GASparseTuple<B, T> toRet;
+		self().template accumulate<B>(toRet._data, T(1));
+		return toRet;
+	}
+};
+
+
+//! Leaf referring to a tuple.
+template<GABasis PS, class T>
+class GAExprTuple : public GAExpr<GAExprTuple<PS, T>>
+{
+public:
+	typedef T Type;
+	typedef typename GAAllBlades<PS>::type Blades;
+	
+	explicit GAExprTuple(const GATuple<PS, T> &in_) : _t(in_) {}
+	
+	template<class D>
+	void accumulate(T *o, T s) const
+	{
+		typedef GAFilteredBlades<D, Blades> F;
+		accumulate<F>(o, s, std::make_index_sequence<F::count>());
+	}
+	
+private:
+	template<class F, std::size_t... I>
+	void accumulate(T *o, T s, std::index_sequence<I...>) const
+	{
+		(void)o; (void)s;
+		
+		using expand = int[];
+		(void)expand{0, (o[F::slot(I)] += s * _t._data[F::mask(I)], 0)...};
+	}
+	
+	const GATuple<PS, T> &_t;
+};
+
+
+//! Leaf referring to a sparse tuple.
+template<class B, class T>
+class GAExprSparse : public GAExpr<GAExprSparse<B, T>>
+{
+public:
+	typedef T Type;
+	typedef B Blades;
+	
+	explicit GAExprSparse(const GASparseTuple<B, T> &in_) : _t(in_) {}
+	
+	template<class D>
+	void accumulate(T *o, T s) const
+	{
+		typedef GAFilteredBlades<D, Blades> F;
+		accumulate<F>(o, s, std::make_index_sequence<F::count>());
+	}
+	
+private:
+	template<class F, std::size_t... I>
+	void accumulate(T *o, T s, std::index_sequence<I...>) const
+	{
+		(void)o; (void)s;
+		
+		using expand = int[];
+		(void)expand{0, (o[F::slot(I)] += s * _t._data[B::find(F::mask(I))], 0)...};
+	}
+	
+	const GASparseTuple<B, T> &_t;
+};
+
+
+//! Leaf holding a GA object (by value).
+template<GABasis I, class T>
+class GAExprBlade : public GAExpr<GAExprBlade<I, T>>
+{
+public:
+	typedef T Type;
+	typedef GABlades<I> Blades;
+	
+	explicit GAExprBlade(GA<I, T> in_g) : _v(in_g) {}
+	
+	template<class D>
+	void accumulate(T *o, T s) const
+	{
+		typedef GAFilteredBlades<D, Blades> F;
+		accumulate<F>(o, s, std::make_index_sequence<F::count>());
+	}
+	
+private:
+	template<class F, std::size_t... X>
+	void accumulate(T *o, T s, std::index_sequence<X...>) const
+	{
+		(void)o; (void)s;
+		
+		using expand = int[];
+		(void)expand{0, (o[F::slot(X)] += s * _v, 0)...};
+	}
+	
+	T _v;
+};
+
+
+//! Product of two expressions.
+template<class OP, class L, class R>
+class GAExprProduct : public GAExpr<GAExprProduct<OP, L, R>>
+{
+public:
+	typedef typename L::Type Type;
+	typedef typename GAProductBlades<typename L::Blades, typename R::Blades, OP>::type Blades;
+	
+	static_assert(std::is_same<Type, typename R::Type>::value, "Mixed types");
+	
+	GAExprProduct(const L &l, const R &r) : _l(l), _r(r) {}
+	
+	//! Evaluate the blades of l and r that reach D (once), then multiply.
+	template<class D>
+	void accumulate(Type *o, Type s) const
+	{
+		typedef typename GAMaskSet<GADemandMarks<typename L::Blades, typename R::Blades, D, OP, true>>::type DL;
+		typedef typename GAMaskSet<GADemandMarks<typename R::Blades, typename L::Blades, D, OP, false>>::type DR;
+		
+		Type l[DL::count > 0 ? DL::count : 1] = {};
+		Type r[DR::count > 0 ? DR::count : 1] = {};
+		
+		_l.template accumulate<DL>(l, s);	// The scale is folded in the left-hand side.
+		_r.template accumulate<DR>(r, Type(1));
+		
+		GAProduct<DL, DR, D, OP>(o, l, r);
+	}
+	
+private:
+	L _l;
+	R _r;
+};
+
+
+//! Sum (SIGN = 1) or difference (SIGN = -1) of two expressions.
+template<int SIGN, class L, class R>
+class GAExprSum : public GAExpr<GAExprSum<SIGN, L, R>>
+{
+public:
+	typedef typename L::Type Type;
+	typedef typename GAUnionBlades<typename L::Blades, typename R::Blades>::type Blades;
+	
+	static_assert(std::is_same<Type, typename R::Type>::value, "Mixed types");
+	
+	GAExprSum(const L &l, const R &r) : _l(l), _r(r) {}
+	
+	template<class D>
+	void accumulate(Type *o, Type s) const
+	{
+		_l.template accumulate<D>(o, s);
+		_r.template accumulate<D>(o, Type(SIGN) * s);
+	}
+	
+private:
+	L _l;
+	R _r;
+};
+
+
+//! Negation of an expression.
+template<class E>
+class GAExprNegate : public GAExpr<GAExprNegate<E>>
+{
+public:
+	typedef typename E::Type Type;
+	typedef typename E::Blades Blades;
+	
+	explicit GAExprNegate(const E &e) : _e(e) {}
+	
+	template<class D>
+	void accumulate(Type *o, Type s) const
+	{
+		_e.template accumulate<D>(o, -s);
+	}
+	
+private:
+	E _e;
+};
+
+
+//! Blades of grade K of an expression.
+template<int K, class E>
+class GAExprGrade : public GAExpr<GAExprGrade<K, E>>
+{
+public:
+	typedef typename E::Type Type;
+	typedef typename GASelectGrade<typename E::Blades, K>::type Blades;
+	
+	explicit GAExprGrade(const E &e) : _e(e) {}
+	
+	template<class D>
+	void accumulate(Type *o, Type s) const
+	{
+		_e.template accumulate<GAFilteredBlades<D, Blades>>(o, s);
+	}
+	
+private:
+	E _e;
+};
+
+
+//! Turns an operand into a node of an expression.
+/*!	Only defined for GA, GATuple and GASparseTuple, so the operators below
+	do not match anything else. */
+template<class X>
+struct GAExprOperand;
+
+template<GABasis PS, class T>
+struct GAExprOperand<GATuple<PS, T>>
+{
+	typedef GAExprTuple<PS, T> type;
+	static type wrap(const GATuple<PS, T> &in_) { return type(in_); }
+};
+
+template<class B, class T>
+struct GAExprOperand<GASparseTuple<B, T>>
+{
+	typedef GAExprSparse<B, T> type;
+	static type wrap(const GASparseTuple<B, T> &in_) { return type(in_); }
+};
+
+template<GABasis I, class T>
+struct GAExprOperand<GA<I, T>>
+{
+	typedef GAExprBlade<I, T> type;
+	static type wrap(GA<I, T> in_) { return type(in_); }
+};
+
+
+//! Start a lazy expression from a tuple.
+template<GABasis PS, class T>
+GAExprTuple<PS, T> Lazy(const GATuple<PS, T> &in_)
+{
+	return GAExprTuple<PS, T>(in_);
+}
+
+
+//! Start a lazy expression from a sparse tuple.
+template<class B, class T>
+GAExprSparse<B, T> Lazy(const GASparseTuple<B, T> &in_)
+{
+	return GAExprSparse<B, T>(in_);
+}
+
+
+//! Start a lazy expression from a GA object.
+template<GABasis I, class T>
+GAExprBlade<I, T> Lazy(GA<I, T> in_g)
+{
+	return GAExprBlade<I, T>(in_g);
+}
+
+
+//! Geometric product within an expression.
+template<class L, class R>
+GAExprProduct<GA_GeometricProduct, L, R> operator|(const GAExpr<L> &l, const GAExpr<R> &r)
+{
+	return GAExprProduct<GA_GeometricProduct, L, R>(l.self(), r.self());
+}
+
+template<class L, class X>
+GAExprProduct<GA_GeometricProduct, L, typename GAExprOperand<X>::type> operator|(const GAExpr<L> &l, const X &r)
+{
+	return GAExprProduct<GA_GeometricProduct, L, typename GAExprOperand<X>::type>(l.self(), GAExprOperand<X>::wrap(r));
+}
+
+template<class X, class R>
+GAExprProduct<GA_GeometricProduct, typename GAExprOperand<X>::type, R> operator|(const X &l, const GAExpr<R> &r)
+{
+	return GAExprProduct<GA_GeometricProduct, typename GAExprOperand<X>::type, R>(GAExprOperand<X>::wrap(l), r.self());
+}
+
+
+//! Outer product within an expression.
+template<class L, class R>
+GAExprProduct<GA_OuterProduct, L, R> operator^(const GAExpr<L> &l, const GAExpr<R> &r)
+{
+	return GAExprProduct<GA_OuterProduct, L, R>(l.self(), r.self());
+}
+
+template<class L, class X>
+GAExprProduct<GA_OuterProduct, L, typename GAExprOperand<X>::type> operator^(const GAExpr<L> &l, const X &r)
+{
+	return GAExprProduct<GA_OuterProduct, L, typename GAExprOperand<X>::type>(l.self(), GAExprOperand<X>::wrap(r));
+}
+
+template<class X, class R>
+GAExprProduct<GA_OuterProduct, typename GAExprOperand<X>::type, R> operator^(const X &l, const GAExpr<R> &r)
+{
+	return GAExprProduct<GA_OuterProduct, typename GAExprOperand<X>::type, R>(GAExprOperand<X>::wrap(l), r.self());
+}
+
+
+//! Inner product within an expression.
+template<class L, class R>
+GAExprProduct<GA_InnerProduct, L, R> operator*(const GAExpr<L> &l, const GAExpr<R> &r)
+{
+	return GAExprProduct<GA_InnerProduct, L, R>(l.self(), r.self());
+}
+
+template<class L, class X>
+GAExprProduct<GA_InnerProduct, L, typename GAExprOperand<X>::type> operator*(const GAExpr<L> &l, const X &r)
+{
+	return GAExprProduct<GA_InnerProduct, L, typename GAExprOperand<X>::type>(l.self(), GAExprOperand<X>::wrap(r));
+}
+
+template<class X, class R>
+GAExprProduct<GA_InnerProduct, typename GAExprOperand<X>::type, R> operator*(const X &l, const GAExpr<R> &r)
+{
+	return GAExprProduct<GA_InnerProduct, typename GAExprOperand<X>::type, R>(GAExprOperand<X>::wrap(l), r.self());
+}
+
+
+//! Sum within an expression.
+template<class L, class R>
+GAExprSum<1, L, R> operator+(const GAExpr<L> &l, const GAExpr<R> &r)
+{
+	return GAExprSum<1, L, R>(l.self(), r.self());
+}
+
+template<class L, class X>
+GAExprSum<1, L, typename GAExprOperand<X>::type> operator+(const GAExpr<L> &l, const X &r)
+{
+	return GAExprSum<1, L, typename GAExprOperand<X>::type>(l.self(), GAExprOperand<X>::wrap(r));
+}
+
+template<class X, class R>
+GAExprSum<1, typename GAExprOperand<X>::type, R> operator+(const X &l, const GAExpr<R> &r)
+{
+	return GAExprSum<1, typename GAExprOperand<X>::type, R>(GAExprOperand<X>::wrap(l), r.self());
+}
+
+
+//! Difference within an expression.
+template<class L, class R>
+GAExprSum<-1, L, R> operator-(const GAExpr<L> &l, const GAExpr<R> &r)
+{
+	return GAExprSum<-1, L, R>(l.self(), r.self());
+}
+
+template<class L, class X>
+GAExprSum<-1, L, typename GAExprOperand<X>::type> operator-(const GAExpr<L> &l, const X &r)
+{
+	return GAExprSum<-1, L, typename GAExprOperand<X>::type>(l.self(), GAExprOperand<X>::wrap(r));
+}
+
+template<class X, class R>
+GAExprSum<-1, typename GAExprOperand<X>::type, R> operator-(const X &l, const GAExpr<R> &r)
+{
+	return GAExprSum<-1, typename GAExprOperand<X>::type, R>(GAExprOperand<X>::wrap(l), r.self());
+}
+
+
+//! Negation within an expression.
+template<class E>
+GAExprNegate<E> operator-(const GAExpr<E> &in_)
+{
+	return GAExprNegate<E>(in_.self());
+}
+
+
+//! Grade projection within an expression, only the blades of grade K are evaluated.
+template<int K, class E>
+GAExprGrade<K, E> Grade(const GAExpr<E> &in_)
+{
+	return GAExprGrade<K, E>(in_.self());
+}
+
+
+//! Add an expression to a tuple.
+/*!	The leaves may read dst, so the expression is evaluated into a
+	temporary before it is added.
+ */
+template<GABasis PS, class T, class E>
+GATuple<PS, T> &operator+=(GATuple<PS, T> &dst, const GAExpr<E> &in_)
+{
+	static_assert((E::Blades::span() & ~(unsigned int)PS) == 0, "Data loss would ensue");
+	
+	GATuple<PS, T> sum;
+	in_.self().template accumulate<GADenseBlades<PS>>(sum._data, T(1));
+	return dst += sum;
+}
@@ -0,0 +1,546 @@
+#pragma once//
+
+#include "LMultivector.h"
+#include "LMultivector_View.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+	#define LGA_FILE_MMAP
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+/*!	@file	LMultivector_File.h		Binary files of multivectors, read in place
+	
+	A file stores count records of one blade set, in one scalar type and one
+	signature, as recorded by its header (GAFileHeader).  The records are
+	either packed one after the other (GAFileAoS, read as a
+	GATupleArrayView), or interleaved by blocks of lanes records, one row of
+	lanes coefficients per blade (GAFileSoA, the rows of GABatchProduct).
+	The data starts LGA_FILE_ALIGN bytes aligned, and SoA blocks are padded
+	to keep that alignment.
+	
+	GAFileReader maps the file: open() only reads the header, the records
+	are paged in when they are touched, and nothing is parsed or copied.
+	
+	@code
+		typedef GAGradeBlades<e1^e2^e3^e4, 2>::type LineBlades;
+		
+		GAFileWriter<LineBlades> out("lines.lga");
+		for (const auto &l : lines)
+			out.write(l);					// a GATuple, GASparseTuple or view
+		out.close();
+		
+		GAFileReader in_("lines.lga");
+		if (in_.holds<LineBlades>())
+		{
+			GATupleArrayView<LineBlades, const float> read = in_.records<LineBlades>();
+			auto p = Plucker::MeetLinePlane(read[i], plane);
+		}
+	@endcode
+	
+	@warning	The coefficients are stored in the byte order of the writer,
+				a reader of the other order refuses the file.
+ */
+
+
+#ifndef LGA_FILE_ALIGN
+//! Alignment of the data and of the SoA blocks, in bytes.
+#define LGA_FILE_ALIGN	64
+#endif
+
+
+//! How the records are laid out.
+enum GAFileLayout
+{
+	GAFileAoS = 0,		//!< Records one after the other
+	GAFileSoA = 1		//!< Blocks of lanes records, one row per blade
+};
+
+
+//! Code of a scalar type within the header.
+template<class T> struct GAFileScalar;
+template<> struct GAFileScalar<float>		{ enum { value = 1 }; };
+template<> struct GAFileScalar<double>		{ enum { value = 2 }; };
+
+
+//! The header, at the start of every file.
+/*!	Followed by bladeCount masks (std::uint32_t), then the data at
+	dataOffset.
+ */
+struct GAFileHeader
+{
+	//! "LGAMV" and the version of the format, the 8 bytes of magic.
+	static const char *signature() { return "LGAMV\r\n\x01"; }
+	
+	//! Written as is, reads differently in the other byte order.
+	enum { kByteOrder = 0x01020304 };
+	
+	char magic[8];
+	std::uint32_t byteOrder;
+	std::uint32_t scalar;			//!< GAFileScalar<T>::value
+	std::uint32_t scalarSize;		//!< sizeof(T)
+	std::uint32_t pseudoScalar;		//!< Basis vectors of the algebra
+	std::uint32_t neg;				//!< Basis vectors that square to -1 (GASignature)
+	std::uint32_t zero;				//!< Basis vectors that square to 0
+	std::uint32_t bladeCount;		//!< Blades of a record
+	std::uint32_t layout;			//!< GAFileLayout
+	std::uint32_t lanes;			//!< Records per block (1 for AoS)
+	std::uint32_t reserved;
+	std::uint64_t count;			//!< Records in the file, or GAFileUnknownCount()
+	std::uint64_t stride;			//!< Bytes from a record (AoS) or block (SoA) to the next
+	std::uint64_t dataOffset;		//!< Bytes from the start of the file to the first record
+};
+
+//! The count of a file that was never closed, or written to a pipe.
+/*!	The records then run up to the end of the file. */
+constexpr std::uint64_t GAFileUnknownCount()
+{
+	return ~std::uint64_t(0);
+}
+
+
+//! Round up to a multiple of LGA_FILE_ALIGN.
+constexpr std::uint64_t GAFileAlign(std::uint64_t bytes)
+{
+	return (bytes + LGA_FILE_ALIGN - 1) / LGA_FILE_ALIGN * LGA_FILE_ALIGN;
+}
+
+
+//! The header is of this format and byte order, and consistent.
+inline bool GAFileHeaderValid(const GAFileHeader &h)
+{
+	if (std::memcmp(h.magic, GAFileHeader::signature(), sizeof(h.magic)) != 0 || h.byteOrder != (std::uint32_t)GAFileHeader::kByteOrder)
+		return false;
+	
+	// A block holds lanes records: stride >= record * lanes, by division so it can not overflow.
+	// An AoS file is read a record at a stride, so it has one lane.
+	return h.layout <= GAFileSoA && h.lanes != 0 && (h.layout == GAFileSoA || h.lanes == 1)
+		&& h.dataOffset % LGA_FILE_ALIGN == 0
+		&& h.stride / h.lanes >= std::uint64_t(h.scalarSize) * h.bladeCount
+		&& h.dataOffset >= sizeof(GAFileHeader) + sizeof(std::uint32_t) * std::uint64_t(h.bladeCount);
+}
+
+
+//! The header says the records are the blades B, as T, in the signature S.
+/*!	@param	in_masks	The bladeCount masks that follow the header.
+ */
+template<class B, class T, class S>
+bool GAFileHolds(const GAFileHeader &h, const char *in_masks)
+{
+	if (h.scalar != (std::uint32_t)GAFileScalar<T>::value || h.scalarSize != sizeof(T)
+		|| h.neg != S::neg || h.zero != S::zero || h.bladeCount != (std::uint32_t)B::count)
+		return false;
+	
+	for (int i=0; i<B::count; i++)
+	{
+		std::uint32_t m;
+		std::memcpy(&m, in_masks + sizeof(std::uint32_t) * i, sizeof(m));
+		if (m != B::mask(i))
+			return false;
+	}
+	return true;
+}
+
+
+//! Writes records of the blades B to a file.
+/*!	@tparam	B	The blades of a record (a GABlades)
+	@tparam	T	The scalar type (float or double)
+	@tparam	S	The signature recorded in the header
+	
+	The records are appended as they come, the count is written in the
+	header by close().  A file that can not seek back (a pipe) keeps
+	GAFileUnknownCount(), and is read up to its end.
+ */
+template<class B, class T = float, class S = GAEuclidean>
+class GAFileWriter
+{
+public:
+	GAFileWriter() {}
+	
+	//! Create the file, see open().
+	explicit GAFileWriter(const char *in_path, GAFileLayout in_layout = GAFileAoS, int in_lanes = 8)
+	{
+		open(in_path, in_layout, in_lanes);
+	}
+	
+	GAFileWriter(const GAFileWriter &) = delete;
+	GAFileWriter &operator=(const GAFileWriter &) = delete;
+	
+	~GAFileWriter() { close(); }
+	
+	//! Create (or truncate) the file.
+	/*!	@param	in_lanes	Records per block of a SoA file.
+		@return				False when the file can not be created.
+	 */
+	bool open(const char *in_path, GAFileLayout in_layout = GAFileAoS, int in_lanes = 8)
+	{
+		close();
+		
+		std::FILE *f = std::fopen(in_path, "wb");
+		if (!f)
+			return false;
+		
+		return start(f, true, in_layout, in_lanes);
+	}
+	
+	//! Write to an open stream (stdout, a pipe...), close() does not close it.
+	bool open(std::FILE *in_file, GAFileLayout in_layout = GAFileAoS, int in_lanes = 8)
+	{
+		close();
+		return in_file && start(in_file, false, in_layout, in_lanes);
+	}
+	
+	//! Append a record, the blades of B in in_ (a GATuple, GASparseTuple or view).
+	template<class X>
+	void write(const X &in_)
+	{
+		assert(_file);
+		
+		if (_layout == GAFileAoS)
+		{
+			GATupleView<B, T, S> record(_block.data());
+			record = in_;
+			_ok = _ok && std::fwrite(_block.data(), sizeof(T), B::count, _file) == std::size_t(B::count);
+		}
+		else
+		{
+			// Gather the record, then scatter it into its lane of the rows.
+			T gathered[B::count > 0 ? B::count : 1];
+			GATupleView<B, T, S> record(gathered);
+			record = in_;
+			
+			const int lane = int(_count % _lanes);
+			for (int i=0; i<B::count; i++)
+				_block[std::size_t(i) * _lanes + lane] = gathered[i];
+			
+			if (lane == _lanes - 1)
+				flushBlock();
+		}
+		_count++;
+	}
+	
+	//! Append every record of an array view.
+	/*!	Packed records of B, as T, are written in one go. */
+	template<class B2, class T2>
+	void write(const GATupleArrayView<B2, T2, S> &in_)
+	{
+		typedef typename std::remove_const<T2>::type Scalar;
+		write(in_, std::integral_constant<bool, std::is_same<B, B2>::value && std::is_same<T, Scalar>::value>());
+	}
+	
+	//! Append every record of an array view, copying the bytes when they are packed.
+	template<class T2>
+	void write(const GATupleArrayView<B, T2, S> &in_, std::true_type)
+	{
+		static_assert(std::is_same<T, typename std::remove_const<T2>::type>::value, "The records are copied as bytes");
+		
+		if (_layout == GAFileAoS && in_.stride() == std::ptrdiff_t(sizeof(T) * B::count))
+		{
+			const std::size_t n = std::size_t(in_.size());
+			_ok = _ok && std::fwrite(in_.data(), sizeof(T) * B::count, n, _file) == n;
+			_count += n;
+			return;
+		}
+		
+		write(in_, std::false_type());
+	}
+	
+	//! Append every record of an array view, one at a time.
+	template<class B2, class T2>
+	void write(const GATupleArrayView<B2, T2, S> &in_, std::false_type)
+	{
+		for (std::ptrdiff_t i=0; i<in_.size(); i++)
+			write(in_[i]);
+	}
+	
+	//! Write the last block and the count, then close the file.
+	/*!	@return		False if any write failed. */
+	bool close()
+	{
+		if (!_file)
+			return _ok;
+		
+		if (_layout == GAFileSoA && _count % _lanes != 0)
+			flushBlock();
+		
+		// A pipe can not seek, its header keeps GAFileUnknownCount().
+		if (std::fflush(_file) != 0)
+			_ok = false;
+		else if (std::fseek(_file, 0, SEEK_SET) == 0)
+			_ok = writeHeader(_count) && _ok;
+		
+		_ok = (_owned ? std::fclose(_file) : std::fflush(_file)) == 0 && _ok;
+		_file = nullptr;
+		
+		return _ok;
+	}
+	
+	//! Records written so far.
+	std::uint64_t size() const { return _count; }
+	
+	//! No write has failed.
+	bool ok() const { return _ok; }
+	
+private:
+	bool start(std::FILE *in_file, bool in_owned, GAFileLayout in_layout, int in_lanes)
+	{
+		_file = in_file;
+		_owned = in_owned;
+		_layout = in_layout;
+		_lanes = in_layout == GAFileSoA ? in_lanes : 1;
+		_count = 0;
+		_block.assign(std::size_t(B::count) * _lanes, T(0));
+		_ok = writeHeader(GAFileUnknownCount());
+		
+		// Pad up to the data.
+		static const char zeros[LGA_FILE_ALIGN] = {};
+		const std::uint64_t header = sizeof(GAFileHeader) + sizeof(std::uint32_t) * B::count;
+		_ok = _ok && std::fwrite(zeros, 1, GAFileAlign(header) - header, _file) == GAFileAlign(header) - header;
+		
+		return _ok;
+	}
+	
+	bool writeHeader(std::uint64_t in_count)
+	{
+		GAFileHeader h;
+		std::memset(&h, 0, sizeof(h));
+		std::memcpy(h.magic, GAFileHeader::signature(), sizeof(h.magic));
+		h.byteOrder = GAFileHeader::kByteOrder;
+		h.scalar = GAFileScalar<T>::value;
+		h.scalarSize = sizeof(T);
+		h.pseudoScalar = B::span() | S::neg | S::zero;
+		h.neg = S::neg;
+		h.zero = S::zero;
+		h.bladeCount = B::count;
+		h.layout = _layout;
+		h.lanes = _lanes;
+		h.count = in_count;
+		h.stride = _layout == GAFileSoA ? GAFileAlign(sizeof(T) * B::count * _lanes) : sizeof(T) * B::count;
+		h.dataOffset = GAFileAlign(sizeof(GAFileHeader) + sizeof(std::uint32_t) * B::count);
+		
+		std::uint32_t masks[B::count > 0 ? B::count : 1];
+		for (int i=0; i<B::count; i++)
+			masks[i] = B::mask(i);
+		
+		return std::fwrite(&h, sizeof(h), 1, _file) == 1
+			&& std::fwrite(masks, sizeof(std::uint32_t), B::count, _file) == std::size_t(B::count);
+	}
+	
+	void flushBlock()
+	{
+		static const char zeros[LGA_FILE_ALIGN] = {};
+		const std::size_t bytes = sizeof(T) * _block.size();
+		const std::size_t pad = std::size_t(GAFileAlign(bytes) - bytes);
+		
+		_ok = _ok && std::fwrite(_block.data(), 1, bytes, _file) == bytes;
+		_ok = _ok && std::fwrite(zeros, 1, pad, _file) == pad;
+		std::fill(_block.begin(), _block.end(), T(0));
+	}
+	
+	std::FILE *_file = nullptr;
+	bool _owned = true;
+	GAFileLayout _layout = GAFileAoS;
+	int _lanes = 1;
+	std::uint64_t _count = 0;
+	std::vector<T> _block;		// The record (AoS) or the block being filled (SoA)
+	bool _ok = true;
+};
+
+
+//! Maps a file written by GAFileWriter, and reads its records in place.
+/*!	open() reads the header and maps the rest of the file without touching
+	it, so opening costs the same for any size.  Check holds<B, T, S>()
+	before reading the records as B.
+	
+	Without mmap (LGA_FILE_MMAP), the file is read into memory by open().
+ */
+class GAFileReader
+{
+public:
+	GAFileReader() {}
+	
+	//! Map the file, see open().
+	explicit GAFileReader(const char *in_path) { open(in_path); }
+	
+	GAFileReader(const GAFileReader &) = delete;
+	GAFileReader &operator=(const GAFileReader &) = delete;
+	
+	~GAFileReader() { close(); }
+	
+	//! Map the file and check its header.
+	/*!	@return		False when the file can not be read, is not a file of
+					multivectors, is of the other byte order, or is shorter
+					than its header says.
+	 */
+	bool open(const char *in_path)
+	{
+		close();
+
+#ifdef LGA_FILE_MMAP
+		const int fd = ::open(in_path, O_RDONLY);
+		if (fd < 0)
+			return false;
+		
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(GAFileHeader))
+		{
+			void *p = mmap(nullptr, std::size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+			if (p != MAP_FAILED)
+			{
+				_base = static_cast<const char *>(p);
+				_bytes = std::size_t(st.st_size);
+			}
+		}
+		::close(fd);	// The mapping holds the file
+#else
+		std::FILE *f = std::fopen(in_path, "rb");
+		if (!f)
+			return false;
+		
+		if (std::fseek(f, 0, SEEK_END) == 0)
+		{
+			const long bytes = std::ftell(f);
+			if (bytes >= (long)sizeof(GAFileHeader) && std::fseek(f, 0, SEEK_SET) == 0)
+			{
+				// Aligned like a mapping, so the SoA blocks are LGA_FILE_ALIGN aligned.
+				_copy.reset(new char[std::size_t(bytes) + LGA_FILE_ALIGN]);
+				char *aligned = _copy.get() + (LGA_FILE_ALIGN - reinterpret_cast<std::uintptr_t>(_copy.get()) % LGA_FILE_ALIGN) % LGA_FILE_ALIGN;
+				if (std::fread(aligned, 1, std::size_t(bytes), f) == std::size_t(bytes))
+				{
+					_base = aligned;
+					_bytes = std::size_t(bytes);
+				}
+			}
+		}
+		std::fclose(f);
+#endif
+		
+		if (!_base || !valid())
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+	
+	//! Unmap the file, the views of its records can no longer be used.
+	void close()
+	{
+#ifdef LGA_FILE_MMAP
+		if (_base)
+			munmap(const_cast<char *>(_base), _bytes);
+#else
+		_copy.reset();
+#endif
+		_base = nullptr;
+		_bytes = 0;
+		_count = 0;
+	}
+	
+	bool is_open() const { return _base != nullptr; }
+	
+	//! The header of the file (open() must have succeeded).
+	const GAFileHeader &header() const
+	{
+		assert(_base);
+		return *reinterpret_cast<const GAFileHeader *>(_base);
+	}
+	
+	//! The i-th blade of a record.
+	GABasis blade(int i) const
+	{
+		assert(i >= 0 && i < (int)header().bladeCount);
+		
+		std::uint32_t m;
+		std::memcpy(&m, _base + sizeof(GAFileHeader) + sizeof(std::uint32_t) * i, sizeof(m));
+		return GABasis(m);
+	}
+	
+	//! Number of records (up to the end of the file when the header does not say).
+	std::uint64_t size() const { return _count; }
+	
+	//! The file stores the blades B, as T, in the signature S.
+	template<class B, class T = float, class S = GAEuclidean>
+	bool holds() const
+	{
+		return GAFileHolds<B, T, S>(header(), _base + sizeof(GAFileHeader));
+	}
+	
+	//! The records of an AoS file, as views of the mapping.
+	template<class B, class T = float, class S = GAEuclidean>
+	GATupleArrayView<B, const T, S> records() const
+	{
+		assert((holds<B, T, S>() && header().layout == GAFileAoS));
+		return GATupleArrayView<B, const T, S>(data<T>(), std::ptrdiff_t(_count), std::ptrdiff_t(header().stride));
+	}
+	
+	//! Number of blocks of a SoA file (the last one may be partly filled).
+	std::uint64_t blocks() const
+	{
+		return (_count + header().lanes - 1) / header().lanes;
+	}
+	
+	//! The k-th block of a SoA file of N lanes, B::count rows of N coefficients.
+	/*!	The rows are in the form GABatchProduct<B, ...> reads. */
+	template<class B, int N, class T = float, class S = GAEuclidean>
+	const T (*block(std::uint64_t k) const)[N]
+	{
+		assert((holds<B, T, S>() && header().layout == GAFileSoA && header().lanes == (std::uint32_t)N));
+		assert(k < blocks());
+		return reinterpret_cast<const T (*)[N]>(reinterpret_cast<const char *>(data<T>()) + k * header().stride);
+	}
+	
+	//! The i-th record of a SoA file of N lanes, as a view of its lane.
+	template<class B, int N, class T = float, class S = GAEuclidean>
+	GATupleView<GALaneBlades<B, N>, const T, S> record(std::uint64_t i) const
+	{
+		return GATupleView<GALaneBlades<B, N>, const T, S>(&block<B, N, T, S>(i / N)[0][i % N]);
+	}
+	
+private:
+	template<class T>
+	const T *data() const
+	{
+		return reinterpret_cast<const T *>(_base + header().dataOffset);
+	}
+	
+	//! Check the header, and find the number of records.
+	bool valid()
+	{
+		const GAFileHeader &h = header();
+		if (!GAFileHeaderValid(h) || h.dataOffset > _bytes)
+			return false;
+		
+		// Whole records (or blocks) up to the end of the file.
+		const std::uint64_t fit = h.stride == 0 ? 0 : (_bytes - h.dataOffset) / h.stride;
+		if (h.count == GAFileUnknownCount())
+		{
+			_count = fit * h.lanes;
+			return true;
+		}
+		
+		// count * stride <= bytes, as a division (count can be anything).
+		_count = h.count;
+		if (h.stride == 0)
+			return true;
+		if (h.layout == GAFileAoS)
+			return h.count <= fit;
+		return h.count / h.lanes + (h.count % h.lanes != 0) <= fit;
+	}
+	
+	const char *_base = nullptr;
+	std::size_t _bytes = 0;
+	std::uint64_t _count = 0;
+
+#ifndef LGA_FILE_MMAP
+	std::unique_ptr<char[]> _copy;
+#endif
+};
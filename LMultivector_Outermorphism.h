@@ -0,0 +1,325 @@
+#pragma once//
+
+#include "LMultivector.h"
+#include "LMultivector_Sparse.h"
+#include "LMultivector_Batch.h"
+#include "LMultivector_Versor.h"
+
+/*!	@file	LMultivector_Outermorphism.h		Linear maps on every grade
+	
+	A linear map f of the vectors extends to every blade as
+	f(a ^ b ^ ...) = f(a) ^ f(b) ^ ..., so on the blades of grade k it is the
+	k-th compound of the matrix of f (the minors of size k).  GAOutermorphism
+	computes those once, then a tuple is moved by one matrix product per
+	grade: a plane of 3-space is a grade 3 tuple of e1^e2^e3^e4, moved by a
+	single 4x4 product instead of rebuilding it from three moved points.
+	
+	@code
+		const float m[4][4] = {...};				// m[r][c], column c is f(e_c)
+		const GAOutermorphism<e1^e2^e3^e4> f(m);
+		
+		auto plane = f(Grade<3>(Plucker::Plane(p1, p2, p3)));
+		f.Transform<2>(lines, lines, count);		// Only the grade 2 part
+	@endcode
+ */
+
+
+//! Position of a blade among the blades of PS of the same grade (in increasing order).
+constexpr int GAGradeRank(const GABasis PS, const unsigned int m)
+{
+	// The combinatorial number system: the i-th vector of the blade, at bit p,
+	// comes after the C(p, i) blades whose i-th vector is lower.
+	const unsigned int bits = GAExtract(m, PS);
+	int toRet = 0;
+	int i = 1;
+	for (int p=0; p<GAGrade(PS); p++)
+	{
+		if (bits & (1u << p))
+		{
+			toRet += GABinomial(p, i);
+			i++;
+		}
+	}
+	return toRet;
+}
+
+
+//! Where the compound matrix of grade k of PS starts, within GAOutermorphism.
+constexpr int GACompoundOffset(const GABasis PS, const int k)
+{
+	int toRet = 0;
+	for (int g=0; g<k; g++)
+		toRet += GABinomial(GAGrade(PS), g) * GABinomial(GAGrade(PS), g);
+	return toRet;
+}
+
+
+//! Where the coefficient of blade I in f(J) is stored, within GAOutermorphism.
+constexpr int GACompoundIndex(const GABasis PS, const unsigned int I, const unsigned int J)
+{
+	return GACompoundOffset(PS, GAGrade(GABasis(I)))
+		 + GAGradeRank(PS, I) * GABinomial(GAGrade(PS), GAGrade(GABasis(I))) + GAGradeRank(PS, J);
+}
+
+
+//! Count the terms of an outermorphism from the blades of X to those of O.
+template<GABasis PS, class X, class O>
+constexpr int GAOutermorphismTermCount()
+{
+	int n = 0;
+	for (int i=0; i<O::count; i++)
+		for (int j=0; j<X::count; j++)
+			if (GAGrade(GABasis(O::mask(i))) == GAGrade(GABasis(X::mask(j))))
+				n++;
+	return n;
+}
+
+
+//! Build the terms of an outermorphism, out[o] += c[l] * x[r].
+/*!	The terms are those of a product table (see GAProductTerm) where the
+	left-hand side is the coefficients of the compound matrices. */
+template<GABasis PS, class X, class O, int N>
+constexpr GAProductTerms<N> GAOutermorphismTermBuild()
+{
+	GAProductTerms<N> t{};
+	int n = 0;
+	for (int i=0; i<O::count; i++)
+	{
+		for (int j=0; j<X::count; j++)
+		{
+			if (GAGrade(GABasis(O::mask(i))) == GAGrade(GABasis(X::mask(j))))
+			{
+				t.term[n].l = GACompoundIndex(PS, O::mask(i), X::mask(j));
+				t.term[n].r = X::slot(j);
+				t.term[n].o = O::slot(i);
+				t.term[n].sign = 1;
+				n++;
+			}
+		}
+	}
+	return t;
+}
+
+
+//! Compile-time table of an outermorphism of PS, from X to O.
+template<GABasis PS, class X, class O>
+struct GAOutermorphismTable
+{
+	static_assert(((X::span() | O::span()) & ~(unsigned int)PS) == 0, "Data loss would ensue");
+	
+	static constexpr int count = GAOutermorphismTermCount<PS, X, O>();
+	
+	static constexpr GAProductTerms<count> value = GAOutermorphismTermBuild<PS, X, O, count>();
+};
+
+template<GABasis PS, class X, class O>
+constexpr GAProductTerms<GAOutermorphismTable<PS, X, O>::count> GAOutermorphismTable<PS, X, O>::value;
+
+
+//! Accumulate f(x) into o, c being the compound matrices of f (see GAOutermorphism).
+template<GABasis PS, class X, class O, class T>
+inline void GAOutermorphismApply(T *o, const T *c, const T *x)
+{
+	typedef GAOutermorphismTable<PS, X, O> TABLE;
+	GAProductApply<TABLE>(o, c, x, std::integral_constant<bool, TABLE::count <= LGA_UNROLL_LIMIT>());
+}
+
+
+//! Accumulate f(x) into the lanes of o.
+template<GABasis PS, class X, class O, int N, class T>
+inline void GAOutermorphismApply(T (*o)[N], const T *c, const T (*x)[N])
+{
+	typedef GAOutermorphismTable<PS, X, O> TABLE;
+	GABatchProductApply<TABLE>(o, c, x, std::integral_constant<bool, TABLE::count <= LGA_UNROLL_LIMIT>());
+}
+
+
+template<GABasis PS, class T>
+class GAOutermorphism;
+
+
+//! Applies GAOutermorphism to an array of tuples, reading the blades of X.
+/*!	Scalar on purpose, like GAVersorMatrixKernel: no SIMD level beat the
+	portable loops, so there is no GASIMDWins for it. */
+template<GABasis PS, class X>
+struct GAOutermorphismKernel
+{
+	template<class T>
+	static void run(GATuple<PS, T> *o, const GATuple<PS, T> *in_, const GAOutermorphism<PS, T> *f, std::ptrdiff_t count)
+	{
+		for (std::ptrdiff_t i=0; i<count; i++)
+		{
+			GATuple<PS, T> toRet;
+			GAOutermorphismApply<PS, X, X>(toRet._data, f->_c, in_[i]._data);
+			o[i] = toRet;
+		}
+	}
+	
+	template<class T, int N>
+	static void run(GATupleBatch<PS, T, N> *o, const GATupleBatch<PS, T, N> *in_, const GAOutermorphism<PS, T> *f, std::ptrdiff_t count)
+	{
+		for (std::ptrdiff_t i=0; i<count; i++)
+		{
+			alignas(64) T acc[PS+1][N] = {};
+			GAOutermorphismApply<PS, X, X>(acc, f->_c, (const T (*)[N])in_[i]._data);
+			
+			for (int b=0; b<=PS; b++)
+				for (int n=0; n<N; n++)
+					o[i]._data[b][n] = acc[b][n];
+		}
+	}
+};
+
+
+//! A linear map of the vectors of PS, extended to every grade.
+/*!	Stores the compound matrix of each grade: the coefficient of the blade
+	I in f(J) is the minor of the rows of I and the columns of J.  Building
+	it is done once, each compound is the previous one extended by a
+	vector, f(J ^ e_j) = f(J) ^ f(e_j).
+	
+	@tparam	PS	The pseudo-scalar
+	@tparam	T	The type (default float)
+ */
+template<GABasis PS, class T = float>
+class GAOutermorphism
+{
+public:
+	static constexpr int dim = GAGrade(PS);
+	
+	//! Number of coefficients, over every grade.
+	static constexpr int size = GACompoundOffset(PS, GAGrade(PS) + 1);
+	
+	//! The identity.
+	GAOutermorphism()
+	{
+		T m[dim > 0 ? dim : 1][dim > 0 ? dim : 1];
+		for (int r=0; r<dim; r++)
+			for (int c=0; c<dim; c++)
+				m[r][c] = r == c ? T(1) : T(0);
+		build(m);
+	}
+	
+	//! From the matrix of f on the vectors, m[r][c] is the r-th vector of f(e_c).
+	explicit GAOutermorphism(const T (&m)[dim > 0 ? dim : 1][dim > 0 ? dim : 1])
+	{
+		build(m);
+	}
+	
+	//! The outermorphism of a versor (see GAVersor::Matrix).
+	explicit GAOutermorphism(const GAVersorMatrix<PS, T> &in_)
+	{
+		build(in_._m);
+	}
+	
+	//! The coefficient of blade I in f(J), 0 unless they share a grade.
+	T at(GABasis I, GABasis J) const
+	{
+		return GAGrade(I) == GAGrade(J) ? _c[GACompoundIndex(PS, I, J)] : T(0);
+	}
+	
+	//! The determinant of f, f(PS) = det PS.
+	T Determinant() const { return _c[size - 1]; }
+	
+	//! Move every grade of a tuple.
+	GATuple<PS, T> operator()(const GATuple<PS, T> &in_) const
+	{
+		GATuple<PS, T> toRet;
+		GAOutermorphismApply<PS, GADenseBlades<PS>, GADenseBlades<PS>>(toRet._data, _c, in_._data);
+		return toRet;
+	}
+	
+	//! Move a sparse tuple, only its grades are computed.
+	/*!	A plane of e1^e2^e3^e4 (Grade<3>) is 16 multiply-adds. */
+	template<class B>
+	GASparseTuple<typename GAMaskSet<GAGradeSetMarks<B, (unsigned int)PS>>::type, T> operator()(const GASparseTuple<B, T> &in_) const
+	{
+		typedef typename GAMaskSet<GAGradeSetMarks<B, (unsigned int)PS>>::type BO;
+		
+		GASparseTuple<BO, T> toRet;
+		GAOutermorphismApply<PS, B, BO>(toRet._data, _c, in_._data);
+		return toRet;
+	}
+	
+	//! Move count tuples, out may be in_.
+	void Transform(GATuple<PS, T> *out_, const GATuple<PS, T> *in_, std::ptrdiff_t count) const
+	{
+		typedef GATuple<PS, T> Tuple;
+		GADispatch<GAOutermorphismKernel<PS, GADenseBlades<PS>>, Tuple *, const Tuple *, const GAOutermorphism *, std::ptrdiff_t>
+			::apply(out_, in_, this, count);
+	}
+	
+	//! Move the grade K part of count tuples, the other blades of out are 0.
+	template<int K>
+	void Transform(GATuple<PS, T> *out_, const GATuple<PS, T> *in_, std::ptrdiff_t count) const
+	{
+		typedef GATuple<PS, T> Tuple;
+		typedef GAScatteredBlades<typename GAGradeBlades<PS, K>::type> X;
+		GADispatch<GAOutermorphismKernel<PS, X>, Tuple *, const Tuple *, const GAOutermorphism *, std::ptrdiff_t>
+			::apply(out_, in_, this, count);
+	}
+	
+	//! Move count batches, out may be in_.
+	template<int N>
+	void Transform(GATupleBatch<PS, T, N> *out_, const GATupleBatch<PS, T, N> *in_, std::ptrdiff_t count) const
+	{
+		typedef GATupleBatch<PS, T, N> Batch;
+		GADispatch<GAOutermorphismKernel<PS, GADenseBlades<PS>>, Batch *, const Batch *, const GAOutermorphism *, std::ptrdiff_t>
+			::apply(out_, in_, this, count);
+	}
+	
+	//! Move the grade K part of count batches, the other blades of out are 0.
+	template<int K, int N>
+	void Transform(GATupleBatch<PS, T, N> *out_, const GATupleBatch<PS, T, N> *in_, std::ptrdiff_t count) const
+	{
+		typedef GATupleBatch<PS, T, N> Batch;
+		typedef GAScatteredBlades<typename GAGradeBlades<PS, K>::type> X;
+		GADispatch<GAOutermorphismKernel<PS, X>, Batch *, const Batch *, const GAOutermorphism *, std::ptrdiff_t>
+			::apply(out_, in_, this, count);
+	}
+	
+public:
+	//! The compound matrices, grade by grade, see GACompoundIndex.
+	T _c[size];
+	
+private:
+	//! Compute the compound matrices from the matrix of the vectors.
+	void build(const T (&m)[dim > 0 ? dim : 1][dim > 0 ? dim : 1])
+	{
+		for (int i=0; i<size; i++)
+			_c[i] = T(0);
+		
+		_c[0] = T(1);
+		
+		// Grade k + 1 from grade k: f(J ^ e_j) = f(J) ^ f(e_j), where e_j is
+		// the highest vector of the blade.
+		for (int k=0; k<dim; k++)
+		{
+			for (unsigned int i=0; i<(1u << dim); i++)
+			{
+				const unsigned int J = GADeposit(i, PS);
+				if (GAGrade(GABasis(J)) != k + 1)
+					continue;
+				
+				int column = dim - 1;
+				while ((i & (1u << column)) == 0)
+					column--;
+				const unsigned int low = J ^ GADeposit(1u << column, PS);
+				
+				for (unsigned int l=0; l<(1u << dim); l++)
+				{
+					const unsigned int I = GADeposit(l, PS);
+					if (GAGrade(GABasis(I)) != k)
+						continue;
+					
+					const T a = _c[GACompoundIndex(PS, I, low)];
+					for (int r=0; r<dim; r++)
+					{
+						const unsigned int v = GADeposit(1u << r, PS);
+						if ((I & v) == 0)
+							_c[GACompoundIndex(PS, I ^ v, J)] += T(GAProductMultiplyBy(GABasis(I), GABasis(v))) * a * m[r][column];
+					}
+				}
+			}
+		}
+	}
+};
@@ -0,0 +1,518 @@
+#pragma once//
+
+#include "LMultivector.h"
+#include "LMultivector_View.h"
+#include "LMultivector_Batch.h"
+#include "LMultivector_Versor.h"
+#include "LMultivector_Plucker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+/*!	@file	LMultivector_Parallel.h		Bulk operations over arrays of tuples, on every core
+	
+	The arrays are cut in chunks that fit in the cache, and the chunks are
+	run by an executor: by default a small pool of threads that steal work
+	from each other, so chunks of uneven costs (intersections that miss and
+	leave early...) still keep every thread busy.
+	
+	@code
+		GAParallelArray<GATuple<e1^e2^e3^e4>> points(count);		// First touched by the threads that use it
+		
+		GAParallelApply(rotor.Matrix<e1^e2^e3^e4>(), points.data(), points.data(), count);
+		GAParallelNormalize(points.data(), count);
+		Plucker::ParallelIntersectPairs(points.data(), hit, lines, planes, count);
+		GAParallelTransform(out, points.data(), count, [&](const GATuple<e1^e2^e3^e4> &p) { return p ^ plane; });
+	@endcode
+	
+	To run the chunks on another scheduler (TBB, the job system of an
+	engine...), implement GAExecutor and pass it in GAParallelOptions.
+ */
+
+
+//! Bytes of the records of a chunk, about half of a L2 cache.
+#ifndef LGA_PARALLEL_CHUNK_BYTES
+#define LGA_PARALLEL_CHUNK_BYTES (128 * 1024)
+#endif
+
+//! Chunks per thread, when the arrays are too small to fill the chunks.
+/*!	A few chunks each leave something to steal at the end of a run. */
+#ifndef LGA_PARALLEL_CHUNKS_PER_THREAD
+#define LGA_PARALLEL_CHUNKS_PER_THREAD 4
+#endif
+
+
+//! Runs the chunks of the GAParallel functions.
+class GAExecutor
+{
+public:
+	virtual ~GAExecutor() {}
+	
+	//! Threads that may run tasks at once, to size the chunks.
+	virtual int concurrency() const = 0;
+	
+	//! Call task(0) to task(count - 1), on any thread and in any order, and return once they are all done.
+	/*!	Task k should preferably run on the same thread from a call to the
+		next, for the same count: that is where its part of the arrays is
+		in the cache (and in the memory of its NUMA node, see GAParallelArray).
+		The tasks do not throw.
+	 */
+	virtual void run(std::size_t count, const std::function<void(std::size_t)> &task) = 0;
+};
+
+
+//! Runs the tasks in order, on the calling thread.
+class GASerialExecutor : public GAExecutor
+{
+public:
+	int concurrency() const override { return 1; }
+	
+	void run(std::size_t count, const std::function<void(std::size_t)> &task) override
+	{
+		for (std::size_t k=0; k<count; k++)
+			task(k);
+	}
+};
+
+
+//! A pool of threads that steal tasks from each other.
+/*!	run() deals the tasks to the threads (the calling thread is one of
+	them) in contiguous runs: thread w gets the tasks from w * count / n to
+	(w + 1) * count / n.  Each thread takes its tasks from the front, and
+	once out of them steals from the back of the others.  Without stealing,
+	each thread touches the same part of the arrays at every call.
+	
+	run() is called from one thread at a time (others wait).  A task that
+	calls run() again runs the new tasks itself.
+ */
+class GAThreadPool : public GAExecutor
+{
+public:
+	//! Start in_threads - 1 threads, or one per core for 0.
+	explicit GAThreadPool(int in_threads = 0)
+	{
+		if (in_threads <= 0)
+			in_threads = std::max(1, int(std::thread::hardware_concurrency()));
+		
+		_queues = std::vector<Queue>(in_threads);
+		for (int w=1; w<in_threads; w++)
+			_threads.emplace_back([this, w]() { Loop(w); });
+	}
+	
+	GAThreadPool(const GAThreadPool &) = delete;
+	GAThreadPool &operator=(const GAThreadPool &) = delete;
+	
+	~GAThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_quit = true;
+		}
+		_wake.notify_all();
+		for (std::thread &t : _threads)
+			t.join();
+	}
+	
+	int concurrency() const override { return int(_queues.size()); }
+	
+	void run(std::size_t count, const std::function<void(std::size_t)> &task) override
+	{
+		if (count == 0)
+			return;
+		if (count == 1 || _queues.size() == 1 || Depth() > 0)
+		{
+			for (std::size_t k=0; k<count; k++)
+				task(k);
+			return;
+		}
+		
+		std::lock_guard<std::mutex> running(_running);
+		
+		_pending = count;
+		const std::size_t n = _queues.size();
+		for (std::size_t w=0; w<n; w++)
+		{
+			std::lock_guard<std::mutex> lock(_queues[w].mutex);
+			_queues[w].begin = w * count / n;
+			_queues[w].end = (w + 1) * count / n;
+			_queues[w].task = &task;
+		}
+		
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_generation++;
+		}
+		_wake.notify_all();
+		
+		Work(0);
+		
+		std::unique_lock<std::mutex> lock(_mutex);
+		_done.wait(lock, [&]() { return _pending == 0; });
+	}
+	
+	//! The pool of the GAParallel functions, of $LGA_THREADS threads (one per core by default).
+	static GAThreadPool &global()
+	{
+		static GAThreadPool pool(std::getenv("LGA_THREADS") ? std::atoi(std::getenv("LGA_THREADS")) : 0);
+		return pool;
+	}
+	
+private:
+	//! Tasks [begin, end) of a thread.
+	struct Queue
+	{
+		std::mutex mutex;
+		std::size_t begin = 0, end = 0;
+		const std::function<void(std::size_t)> *task = nullptr;
+	};
+	
+	//! Tasks the current thread runs inside.
+	static int &Depth()
+	{
+		thread_local int depth = 0;
+		return depth;
+	}
+	
+	void Loop(int w)
+	{
+		for (std::uint64_t seen = 0; ; )
+		{
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_wake.wait(lock, [&]() { return _quit || _generation != seen; });
+				if (_quit)
+					return;
+				seen = _generation;
+			}
+			Work(w);
+		}
+	}
+	
+	//! Run the tasks of queue w, then steal the others'.
+	void Work(std::size_t w)
+	{
+		const std::size_t n = _queues.size();
+		
+		Depth()++;
+		for (;;)
+		{
+			std::size_t k = 0;
+			const std::function<void(std::size_t)> *task = nullptr;
+			
+			for (std::size_t v=0; v<n && !task; v++)
+			{
+				Queue &q = _queues[(w + v) % n];
+				std::lock_guard<std::mutex> lock(q.mutex);
+				if (q.begin < q.end)
+				{
+					k = v == 0 ? q.begin++ : --q.end;
+					task = q.task;
+				}
+			}
+			if (!task)
+				break;
+			
+			(*task)(k);
+			
+			if (--_pending == 0)
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_done.notify_all();
+			}
+		}
+		Depth()--;
+	}
+	
+	std::vector<Queue> _queues;
+	std::vector<std::thread> _threads;
+	
+	std::mutex _running;				// Held by the thread in run()
+	std::mutex _mutex;
+	std::condition_variable _wake, _done;
+	std::uint64_t _generation = 0;		// Calls to run(), wakes the threads
+	std::atomic<std::size_t> _pending{0};	// Tasks of the current run() not done yet
+	bool _quit = false;
+};
+
+
+//! How the GAParallel functions cut and run their work.
+struct GAParallelOptions
+{
+	GAExecutor *executor = nullptr;		//!< GAThreadPool::global() when null
+	std::size_t grain = 0;				//!< Records per chunk, 0 to size them for the cache
+};
+
+
+//! Records per chunk, for records of in_bytes bytes.
+/*!	As many records as fit in LGA_PARALLEL_CHUNK_BYTES, fewer when that
+	leaves less than LGA_PARALLEL_CHUNKS_PER_THREAD chunks to each thread,
+	but never less than a sixteenth of that (smaller chunks cost more to
+	hand out than they balance).
+ */
+inline std::size_t GAParallelGrain(std::size_t in_count, std::size_t in_bytes, int in_threads)
+{
+	const std::size_t most = std::max<std::size_t>(1, LGA_PARALLEL_CHUNK_BYTES / std::max<std::size_t>(1, in_bytes));
+	const std::size_t least = std::max<std::size_t>(1, most / 16);
+	const std::size_t chunks = std::size_t(std::max(1, in_threads)) * LGA_PARALLEL_CHUNKS_PER_THREAD;
+	
+	return std::min(most, std::max(least, (in_count + chunks - 1) / chunks));
+}
+
+
+//! The executor of options.
+inline GAExecutor &GAParallelExecutor(const GAParallelOptions &options)
+{
+	return options.executor ? *options.executor : GAThreadPool::global();
+}
+
+
+//! Records per chunk of options (its grain, or sized for the cache).
+inline std::size_t GAParallelGrain(std::size_t in_count, std::size_t in_bytes, const GAParallelOptions &options)
+{
+	return options.grain > 0 ? options.grain : GAParallelGrain(in_count, in_bytes, GAParallelExecutor(options).concurrency());
+}
+
+
+//! Call f(begin, end) on chunks covering [0, in_count), in parallel.
+/*!	@param	in_bytes	Bytes read and written per record, to size the chunks.
+	
+	The chunks are in order, chunk k covering k * grain to (k + 1) * grain,
+	and are spread over the threads in contiguous runs (see GAThreadPool).
+ */
+template<class F>
+void GAParallelFor(std::ptrdiff_t in_count, std::size_t in_bytes, F f, const GAParallelOptions &options = GAParallelOptions())
+{
+	assert(in_count >= 0);
+	
+	GAExecutor &executor = GAParallelExecutor(options);
+	const std::size_t count = std::size_t(in_count);
+	const std::size_t grain = GAParallelGrain(count, in_bytes, options);
+	const std::size_t chunks = (count + grain - 1) / grain;
+	
+	if (chunks <= 1)
+	{
+		if (count > 0)
+			f(std::ptrdiff_t(0), in_count);
+		return;
+	}
+	
+	executor.run(chunks, [&](std::size_t k)
+	{
+		f(std::ptrdiff_t(k * grain), std::ptrdiff_t(std::min(count, (k + 1) * grain)));
+	});
+}
+
+
+//! out[i] = f(in_[i]) for count records, in parallel.
+template<class O, class I, class F>
+void GAParallelTransform(O *out, const I *in_, std::ptrdiff_t count, F f, const GAParallelOptions &options = GAParallelOptions())
+{
+	GAParallelFor(count, sizeof(O) + sizeof(I), [&](std::ptrdiff_t begin, std::ptrdiff_t end)
+	{
+		for (std::ptrdiff_t i=begin; i<end; i++)
+			out[i] = f(in_[i]);
+	}, options);
+}
+
+
+//! out[i] = f(in_[i]) over strided buffers, for in_.size() records.
+/*!	f is given a GATupleView, and returns anything a view can be assigned. */
+template<class BO, class TO, class BI, class TI, class S, class F>
+void GAParallelTransform(GATupleArrayView<BO, TO, S> out, GATupleArrayView<BI, TI, S> in_, F f, const GAParallelOptions &options = GAParallelOptions())
+{
+	assert(out.size() >= in_.size());
+	
+	GAParallelFor(in_.size(), std::size_t(out.stride() + in_.stride()), [&](std::ptrdiff_t begin, std::ptrdiff_t end)
+	{
+		for (std::ptrdiff_t i=begin; i<end; i++)
+			out[i] = f(in_[i]);
+	}, options);
+}
+
+
+//! out[i] = in_[i] OP right, for count tuples and a constant right (a GA or a tuple).
+/*!	@code
+		GAParallelProduct<GA_OuterProduct>(planes, lines, count, point);
+	@endcode
+ */
+template<class OP, class O, GABasis M1, class T, class S, class R>
+void GAParallelProduct(O *out, const GATuple<M1, T, S> *in_, std::ptrdiff_t count, const R &right, const GAParallelOptions &options = GAParallelOptions())
+{
+	GAParallelTransform(out, in_, count, [&](const GATuple<M1, T, S> &x) { return GATupleMultiply<OP>(x, right); }, options);
+}
+
+
+//! out[i] = left OP in_[i], for a constant left (a GA or a tuple) and count tuples.
+template<class OP, class O, class L, GABasis M2, class T, class S>
+void GAParallelProduct(O *out, const L &left, const GATuple<M2, T, S> *in_, std::ptrdiff_t count, const GAParallelOptions &options = GAParallelOptions())
+{
+	GAParallelTransform(out, in_, count, [&](const GATuple<M2, T, S> &x) { return GATupleMultiply<OP>(left, x); }, options);
+}
+
+
+//! m.Transform(out, in_, count) in parallel, for a GAVersorMatrix, a GAOutermorphism...
+/*!	The product by a constant versor or linear map, as one matrix built
+	once for all the chunks.  out may be in_; works on tuples and batches.
+ */
+template<class M, class O, class I>
+void GAParallelApply(const M &m, O *out, const I *in_, std::ptrdiff_t count, const GAParallelOptions &options = GAParallelOptions())
+{
+	GAParallelFor(count, sizeof(O) + sizeof(I), [&](std::ptrdiff_t begin, std::ptrdiff_t end)
+	{
+		m.Transform(out + begin, in_ + begin, end - begin);
+	}, options);
+}
+
+
+//! Normalize count tuples in place, in parallel (see Normalize).
+template<class RSQRT = GA_Rsqrt, GABasis PS, class T>
+void GAParallelNormalize(GATuple<PS, T> *io, std::ptrdiff_t count, const GAParallelOptions &options = GAParallelOptions())
+{
+	GAParallelFor(count, 2 * sizeof(GATuple<PS, T>), [&](std::ptrdiff_t begin, std::ptrdiff_t end)
+	{
+		for (std::ptrdiff_t i=begin; i<end; i++)
+			io[i] = Normalize<RSQRT>(io[i]);
+	}, options);
+}
+
+
+//! Normalize count batches in place, in parallel.
+template<class RSQRT = GA_Rsqrt, GABasis PS, class T, int N>
+void GAParallelNormalize(GATupleBatch<PS, T, N> *io, std::ptrdiff_t count, const GAParallelOptions &options = GAParallelOptions())
+{
+	GAParallelFor(count, 2 * sizeof(GATupleBatch<PS, T, N>), [&](std::ptrdiff_t begin, std::ptrdiff_t end)
+	{
+		Normalize<RSQRT>(io + begin, end - begin);
+	}, options);
+}
+
+
+namespace Plucker
+{
+	//! IntersectPairs, on chunks run in parallel.
+	/*!	Pairs that miss leave early, so the chunks cost more or less: the
+		threads done first steal the chunks of the others.
+	 */
+	template<GABasis MV1, class TYPE>
+	void ParallelIntersectPairs(GATuple<MV1, TYPE> *points, bool *hit, const GATuple<MV1, TYPE> *lines, const GATuple<MV1, TYPE> *planes, std::ptrdiff_t count, TYPE epsilon = TYPE(0), const GAParallelOptions &options = GAParallelOptions())
+	{
+		GAParallelFor(count, 3 * sizeof(GATuple<MV1, TYPE>) + sizeof(bool), [&](std::ptrdiff_t begin, std::ptrdiff_t end)
+		{
+			IntersectPairs(points + begin, hit + begin, lines + begin, planes + begin, end - begin, epsilon);
+		}, options);
+	}
+	
+	
+	//! IntersectPlane, on chunks run in parallel.
+	template<GABasis MV1, class TYPE>
+	void ParallelIntersectPlane(GATuple<MV1, TYPE> *points, bool *hit, const GATuple<MV1, TYPE> *lines, const GATuple<MV1, TYPE> &plane, std::ptrdiff_t count, TYPE epsilon = TYPE(0), const GAParallelOptions &options = GAParallelOptions())
+	{
+		GAParallelFor(count, 2 * sizeof(GATuple<MV1, TYPE>) + sizeof(bool), [&](std::ptrdiff_t begin, std::ptrdiff_t end)
+		{
+			IntersectPlane(points + begin, hit + begin, lines + begin, plane, end - begin, epsilon);
+		}, options);
+	}
+	
+	
+	//! IntersectPairs over strided buffers, on chunks run in parallel.
+	template<class B0, class TYPE, class B1, class T1, class B2, class T2>
+	void ParallelIntersectPairs(GATupleArrayView<B0, TYPE> points, bool *hit, GATupleArrayView<B1, T1> lines, GATupleArrayView<B2, T2> planes, TYPE epsilon = TYPE(0), const GAParallelOptions &options = GAParallelOptions())
+	{
+		const std::size_t bytes = std::size_t(points.stride() + lines.stride() + planes.stride()) + sizeof(bool);
+		GAParallelFor(lines.size(), bytes, [&](std::ptrdiff_t begin, std::ptrdiff_t end)
+		{
+			IntersectPairs(points.slice(begin, end - begin), hit + begin,
+						   lines.slice(begin, end - begin), planes.slice(begin, end - begin), epsilon);
+		}, options);
+	}
+	
+	
+	//! IntersectPairs on batches, on chunks run in parallel.
+	template<GABasis MV1, class TYPE, int N>
+	void ParallelIntersectPairs(GATupleBatch<MV1, TYPE, N> *points, bool *hit, const GATupleBatch<MV1, TYPE, N> *lines, const GATupleBatch<MV1, TYPE, N> *planes, std::ptrdiff_t count, TYPE epsilon = TYPE(0), const GAParallelOptions &options = GAParallelOptions())
+	{
+		GAParallelFor(count, 3 * sizeof(GATupleBatch<MV1, TYPE, N>) + N * sizeof(bool), [&](std::ptrdiff_t begin, std::ptrdiff_t end)
+		{
+			IntersectPairs(points + begin, hit + begin * N, lines + begin, planes + begin, end - begin, epsilon);
+		}, options);
+	}
+}
+
+
+//! An array whose pages are first touched by the threads that will use them.
+/*!	The records are constructed by GAParallelFor, so on a NUMA machine
+	each part of the array lands in the memory of the node of the thread
+	that later runs the same part (the threads get the same contiguous
+	runs of chunks at every call, see GAThreadPool).  Allocated aligned on
+	pages, so the parts of two threads do not share one.
+ */
+template<class T>
+class GAParallelArray
+{
+public:
+	GAParallelArray() {}
+	
+	//! in_count records T(), constructed in parallel.
+	explicit GAParallelArray(std::size_t in_count, const GAParallelOptions &options = GAParallelOptions())
+	{
+		const std::size_t align = std::max<std::size_t>(alignof(T), kPage);
+		_block = ::operator new(in_count * sizeof(T) + align);
+		
+		_data = reinterpret_cast<T *>((reinterpret_cast<std::uintptr_t>(_block) + align - 1) / align * align);
+		_count = in_count;
+		
+		T *data = _data;
+		GAParallelFor(std::ptrdiff_t(in_count), sizeof(T), [data](std::ptrdiff_t begin, std::ptrdiff_t end)
+		{
+			for (std::ptrdiff_t i=begin; i<end; i++)
+				new (data + i) T();
+		}, options);
+	}
+	
+	GAParallelArray(const GAParallelArray &) = delete;
+	GAParallelArray &operator=(const GAParallelArray &) = delete;
+	
+	GAParallelArray(GAParallelArray &&in_) { swap(in_); }
+	GAParallelArray &operator=(GAParallelArray &&in_) { GAParallelArray(std::move(in_)).swap(*this); return *this; }
+	
+	~GAParallelArray()
+	{
+		for (std::size_t i=0; i<_count; i++)
+			_data[i].~T();
+		::operator delete(_block);
+	}
+	
+	void swap(GAParallelArray &in_)
+	{
+		std::swap(_block, in_._block);
+		std::swap(_data, in_._data);
+		std::swap(_count, in_._count);
+	}
+	
+	T &operator[](std::size_t i) { return _data[i]; }
+	const T &operator[](std::size_t i) const { return _data[i]; }
+	
+	T *data() { return _data; }
+	const T *data() const { return _data; }
+	std::size_t size() const { return _count; }
+	
+	T *begin() { return _data; }
+	T *end() { return _data + _count; }
+	const T *begin() const { return _data; }
+	const T *end() const { return _data + _count; }
+	
+private:
+	enum { kPage = 4096 };
+	
+	void *_block = nullptr;
+	T *_data = nullptr;
+	std::size_t _count = 0;
+};
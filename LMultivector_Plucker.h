@@ -1,6 +1,12 @@
 #pragma once//
 
+#include <algorithm>
+
 #include "LMultivector.h"
+#include "LMultivector_Dual.h"
+#include "LMultivector_Sparse.h"
+#include "LMultivector_Batch.h"
+#include "LMultivector_View.h"
 
 /*! @file LMultivector_Plucker.h	Rudimentary support for Plucker coordinates
 	
@@ -9,10 +15,16 @@
 	This file is primarily a wrapper around the GATuple providing, for most
 	cases, a wrapper for 3-space support.
  
-	Methods in this file occur in homogeneous space.  Conformal space will be
-	looked at later as space requirements go up and do not add what we need...
+	Methods in this file occur in homogeneous space.  Conformal space (and its
+	metric) is in LMultivector_Conformal.h.
  */
 
+
+//! Planes of a tile of IntersectAll, kept in the L1 cache while every line visits them.
+#ifndef LGA_PLUCKER_TILE
+#define LGA_PLUCKER_TILE 256
+#endif
+
 namespace Plucker
 {
 	//!	Generates a point in 3-space.
@@ -31,32 +43,634 @@ namespace Plucker
 		@param	u		First homogeneous coordinate where e1 is basis at infinity
 		@param	v		Second homogeneous coordinate where e1 is basis at infinity
 	 
-		@warning		Use the Plucker::Point method for both u and v.
+		@warning		Use the Plucker::Point method for both u and v.  Only
+						the vector part of u and v is read.
 	 */
 	template<GABasis MV1, class TYPE=float>
-	constexpr GATuple<MV1, TYPE> Line(GATuple<MV1, TYPE> u, GATuple<MV1, TYPE> v)
+	constexpr GATuple<MV1, TYPE> Line(const GATuple<MV1, TYPE> &u, const GATuple<MV1, TYPE> &v)
 	{
-		return (u ^ v);
+		return (Grade<1>(u) ^ Grade<1>(v)).template tuple<MV1>();
 	}
 	
 	
 	//! Generates the representation of a plane using Plucker coordinates
 	/*!	The plane is generated from the 3 points, p1, p2, and p3.
 	 
-		@warning	Use Plucker::Point to generate the points.
+		@warning	Use Plucker::Point to generate the points.  Only the vector
+					part of the points is read.
 	 */
 	template<GABasis MV1, class TYPE>
-	constexpr GATuple<MV1, TYPE> Plane(GATuple<MV1, TYPE> p1, GATuple<MV1, TYPE> p2, GATuple<MV1, TYPE> p3)
+	constexpr GATuple<MV1, TYPE> Plane(const GATuple<MV1, TYPE> &p1, const GATuple<MV1, TYPE> &p2, const GATuple<MV1, TYPE> &p3)
 	{
-		return (p1 ^ p2 ^ p3);
+		return (Grade<1>(p1) ^ Grade<1>(p2) ^ Grade<1>(p3)).template tuple<MV1>();
 	}
 	
 	
 	//! Meet - collide two objects.
-	/*! The meet will result in the intersection.  Like a line and plane for a point. */
+	/*! The meet will result in the intersection.  Like a line and plane for a point.
+		
+		This is the regressive product, Dual(o1) * o2.  When the grades of the
+		objects are known, MeetLinePlane, MeetPlanes and MeetLines only do the
+		multiply-adds of that case.
+	 */
+	template<GABasis MV1, class TYPE>
+	constexpr GATuple<MV1, TYPE> Meet(const GATuple<MV1, TYPE> &o1, const GATuple<MV1, TYPE> &o2)
+	{
+		return Regressive(o1, o2);
+	}
+	
+	
+	//! Join - the smallest object holding both objects.
+	/*!	Point and point give the line through them, line and point give the
+		plane through them (see Line and Plane).
+	 
+		@warning	The objects must not share a direction, the join is then
+					the outer product.  Two equal points join to 0.
+	 */
+	template<GABasis MV1, class TYPE>
+	constexpr GATuple<MV1, TYPE> Join(const GATuple<MV1, TYPE> &o1, const GATuple<MV1, TYPE> &o2)
+	{
+		return o1 ^ o2;
+	}
+	
+	
+	//! Point where a line crosses a plane, Meet(line, plane)
+	/*!	12 multiply-adds.  The point is at infinity (e4 is 0) when the line is
+		parallel to the plane.
+	 
+		@warning	Only the grade 2 part of line and the grade 3 part of plane
+					are read.
+	 */
+	template<GABasis MV1, class TYPE>
+	GATuple<MV1, TYPE> MeetLinePlane(const GATuple<MV1, TYPE> &line, const GATuple<MV1, TYPE> &plane)
+	{
+		return Regressive<MV1>(Grade<2>(line), Grade<3>(plane)).template tuple<MV1>();
+	}
+	
+	
+	//! Line where two planes cross, Meet(p1, p2)
+	/*!	12 multiply-adds.
+	 
+		@warning	Only the grade 3 part of the planes is read.
+	 */
 	template<GABasis MV1, class TYPE>
-	constexpr GATuple<MV1, TYPE> Meet(GATuple<MV1, TYPE> o1, GATuple<MV1, TYPE> o2)
+	GATuple<MV1, TYPE> MeetPlanes(const GATuple<MV1, TYPE> &p1, const GATuple<MV1, TYPE> &p2)
+	{
+		return Regressive<MV1>(Grade<3>(p1), Grade<3>(p2)).template tuple<MV1>();
+	}
+	
+	
+	//! Meet of two lines, Meet(l1, l2), a scalar that is 0 when they cross.
+	/*!	6 multiply-adds.  The sign tells on which side l2 passes l1.
+	 
+		@warning	Only the grade 2 part of the lines is read.
+	 */
+	template<GABasis MV1, class TYPE>
+	GATuple<MV1, TYPE> MeetLines(const GATuple<MV1, TYPE> &l1, const GATuple<MV1, TYPE> &l2)
+	{
+		return Regressive<MV1>(Grade<2>(l1), Grade<2>(l2)).template tuple<MV1>();
+	}
+	
+	
+	//! The pseudo-scalar spanned by the layouts of views.
+	template<class B1, class B2, class B3 = GABlades<>>
+	constexpr GABasis ViewSpan()
+	{
+		return GABasis(B1::span() | B2::span() | B3::span());
+	}
+	
+	
+	//! Line through two points read from views (see Line).
+	/*!	The result is a tuple, assign it to a view to write it in place:
+		@code
+			GATupleArrayView<GAGradeBlades<e1^e2^e3^e4, 2>::type> lines(&out[0].line[0], count, sizeof(Record));
+			lines[i] = Plucker::Line(points[2*i], points[2*i+1]);
+		@endcode
+	 */
+	template<class B1, class T1, class B2, class T2>
+	GATuple<ViewSpan<B1, B2>(), typename std::remove_const<T1>::type> Line(const GATupleView<B1, T1> &u, const GATupleView<B2, T2> &v)
+	{
+		return (Grade<1>(u) ^ Grade<1>(v)).template tuple<ViewSpan<B1, B2>()>();
+	}
+	
+	
+	//! Plane through three points read from views (see Plane).
+	template<class B1, class T1, class B2, class T2, class B3, class T3>
+	GATuple<ViewSpan<B1, B2, B3>(), typename std::remove_const<T1>::type> Plane(const GATupleView<B1, T1> &p1, const GATupleView<B2, T2> &p2, const GATupleView<B3, T3> &p3)
+	{
+		return (Grade<1>(p1) ^ Grade<1>(p2) ^ Grade<1>(p3)).template tuple<ViewSpan<B1, B2, B3>()>();
+	}
+	
+	
+	//! Meet of two objects read from views (see Meet).
+	template<class B1, class T1, class B2, class T2>
+	GATuple<ViewSpan<B1, B2>(), typename std::remove_const<T1>::type> Meet(const GATupleView<B1, T1> &o1, const GATupleView<B2, T2> &o2)
+	{
+		return Regressive<ViewSpan<B1, B2>()>(o1, o2).template tuple<ViewSpan<B1, B2>()>();
+	}
+	
+	
+	//! Join of two objects read from views (see Join).
+	template<class B1, class T1, class B2, class T2>
+	GATuple<ViewSpan<B1, B2>(), typename std::remove_const<T1>::type> Join(const GATupleView<B1, T1> &o1, const GATupleView<B2, T2> &o2)
+	{
+		return View(o1 ^ o2).template tuple<ViewSpan<B1, B2>()>();
+	}
+	
+	
+	//! Point where a line crosses a plane, read from views (see MeetLinePlane).
+	template<class B1, class T1, class B2, class T2>
+	GATuple<ViewSpan<B1, B2>(), typename std::remove_const<T1>::type> MeetLinePlane(const GATupleView<B1, T1> &line, const GATupleView<B2, T2> &plane)
+	{
+		return Regressive<ViewSpan<B1, B2>()>(Grade<2>(line), Grade<3>(plane)).template tuple<ViewSpan<B1, B2>()>();
+	}
+	
+	
+	//! Line where two planes cross, read from views (see MeetPlanes).
+	template<class B1, class T1, class B2, class T2>
+	GATuple<ViewSpan<B1, B2>(), typename std::remove_const<T1>::type> MeetPlanes(const GATupleView<B1, T1> &p1, const GATupleView<B2, T2> &p2)
+	{
+		return Regressive<ViewSpan<B1, B2>()>(Grade<3>(p1), Grade<3>(p2)).template tuple<ViewSpan<B1, B2>()>();
+	}
+	
+	
+	//! Meet of two lines, read from views (see MeetLines).
+	template<class B1, class T1, class B2, class T2>
+	GATuple<ViewSpan<B1, B2>(), typename std::remove_const<T1>::type> MeetLines(const GATupleView<B1, T1> &l1, const GATupleView<B2, T2> &l2)
+	{
+		return Regressive<ViewSpan<B1, B2>()>(Grade<2>(l1), Grade<2>(l2)).template tuple<ViewSpan<B1, B2>()>();
+	}
+	
+	
+	//! Vector part of a homogeneous tuple, where it is stored in the tuple.
+	template<GABasis MV1>
+	using PointBlades = GAScatteredBlades<typename GAGradeBlades<MV1, 1>::type>;
+	
+	
+	//! Bivector part of a homogeneous tuple (lines), where it is stored in the tuple.
+	template<GABasis MV1>
+	using LineBlades = GAScatteredBlades<typename GAGradeBlades<MV1, 2>::type>;
+	
+	
+	//! Trivector part of a homogeneous tuple (planes), where it is stored in the tuple.
+	template<GABasis MV1>
+	using PlaneBlades = GAScatteredBlades<typename GAGradeBlades<MV1, 3>::type>;
+	
+	
+	//! Line of every pair of points within two batches (see Line).
+	template<GABasis MV1>
+	struct LineKernel
+	{
+		template<int N, class TYPE>
+		static void run(TYPE (*o)[N], const TYPE (*u)[N], const TYPE (*v)[N])
+		{
+			GABatchProduct<PointBlades<MV1>, PointBlades<MV1>, GADenseBlades<MV1>, GA_OuterProduct>(o, u, v);
+		}
+	};
+	
+	
+	//! Plane of every triplet of points within three batches (see Plane).
+	template<GABasis MV1>
+	struct PlaneKernel
+	{
+		template<int N, class TYPE>
+		static void run(TYPE (*o)[N], const TYPE (*p1)[N], const TYPE (*p2)[N], const TYPE (*p3)[N])
+		{
+			alignas(64) TYPE line[MV1+1][N] = {};
+			
+			GABatchProduct<PointBlades<MV1>, PointBlades<MV1>, LineBlades<MV1>, GA_OuterProduct>(line, p1, p2);
+			GABatchProduct<LineBlades<MV1>, PointBlades<MV1>, GADenseBlades<MV1>, GA_OuterProduct>(o, (const TYPE (*)[N])line, p3);
+		}
+	};
+	
+	
+	//! Line through every pair of points within two batches.
+	/*!	@warning	Only the vector part of u and v is read. */
+	template<GABasis MV1, class TYPE, int N>
+	GATupleBatch<MV1, TYPE, N> Line(const GATupleBatch<MV1, TYPE, N> &u, const GATupleBatch<MV1, TYPE, N> &v)
+	{
+		GATupleBatch<MV1, TYPE, N> toRet;
+		GADispatch<LineKernel<MV1>, TYPE (*)[N], const TYPE (*)[N], const TYPE (*)[N]>::apply(toRet._data, u._data, v._data);
+		return toRet;
+	}
+	
+	
+	//! Plane through every triplet of points within three batches.
+	/*!	@warning	Only the vector part of the points is read. */
+	template<GABasis MV1, class TYPE, int N>
+	GATupleBatch<MV1, TYPE, N> Plane(const GATupleBatch<MV1, TYPE, N> &p1, const GATupleBatch<MV1, TYPE, N> &p2, const GATupleBatch<MV1, TYPE, N> &p3)
+	{
+		GATupleBatch<MV1, TYPE, N> toRet;
+		GADispatch<PlaneKernel<MV1>, TYPE (*)[N], const TYPE (*)[N], const TYPE (*)[N], const TYPE (*)[N]>::apply(toRet._data, p1._data, p2._data, p3._data);
+		return toRet;
+	}
+	
+	
+	//! Meet of every pair of objects within two batches.
+	template<GABasis MV1, class TYPE, int N>
+	GATupleBatch<MV1, TYPE, N> Meet(const GATupleBatch<MV1, TYPE, N> &o1, const GATupleBatch<MV1, TYPE, N> &o2)
+	{
+		return Regressive(o1, o2);
+	}
+	
+	
+	//! Join of every pair of objects within two batches.
+	template<GABasis MV1, class TYPE, int N>
+	GATupleBatch<MV1, TYPE, N> Join(const GATupleBatch<MV1, TYPE, N> &o1, const GATupleBatch<MV1, TYPE, N> &o2)
+	{
+		return o1 ^ o2;
+	}
+	
+	
+	//! The homogeneous coordinate of a point (e4 in 3-space).
+	template<GABasis MV1>
+	constexpr GABasis Homogeneous()
+	{
+		return GABasis(GADeposit(1u << (GAGrade(MV1) - 1), MV1));
+	}
+	
+	
+	//! Divide every point of a batch by its homogeneous coordinate.
+	template<GABasis MV1>
+	struct DivideKernel
+	{
+		template<int N, class TYPE>
+		static void run(TYPE (*o)[N], bool *hit, TYPE epsilon)
+		{
+			constexpr GABasis H = Homogeneous<MV1>();
+			
+			alignas(64) TYPE inverse[N];
+			alignas(64) TYPE one[N];
+			
+			// Branch free, so the lanes are vectorized.
+			LGA_IVDEP
+			for (int n=0; n<N; n++)
+			{
+				const TYPE w = o[H][n];
+				const bool h = w > epsilon || w < -epsilon;
+				
+				inverse[n] = h ? TYPE(1) / (h ? w : TYPE(1)) : TYPE(0);
+				one[n] = h ? TYPE(1) : TYPE(0);
+			}
+			
+			for (int i=0; i<PointBlades<MV1>::count; i++)
+			{
+				const int b = PointBlades<MV1>::slot(i);
+				
+				LGA_IVDEP
+				for (int n=0; n<N; n++)
+					o[b][n] *= inverse[n];
+			}
+			
+			for (int n=0; n<N; n++)
+			{
+				o[H][n] = one[n];
+				hit[n] = one[n] != TYPE(0);
+			}
+		}
+	};
+	
+	
+	//! Divide every point of a batch by its homogeneous coordinate (e4 = 1).
+	/*!	Points at infinity, |e4| <= epsilon, are set to 0 and flagged false
+		in hit (N entries).  Only the vector part is divided.
+	 */
+	template<GABasis MV1, class TYPE, int N>
+	void HomogeneousDivide(GATupleBatch<MV1, TYPE, N> &points, bool *hit, TYPE epsilon = TYPE(0))
+	{
+		GADispatch<DivideKernel<MV1>, TYPE (*)[N], bool *, TYPE>::apply(points._data, hit, epsilon);
+	}
+	
+	
+	//! Body of Intersect, for tuples and views.
+	/*!	point is assigned a GATuple<MV1>, line and plane are read through
+		Grade and Regressive.
+	 */
+	template<GABasis MV1, class TYPE, class P, class L, class Q>
+	inline bool IntersectInto(P &point, const L &line, const Q &plane, TYPE epsilon)
+	{
+		constexpr GABasis H = Homogeneous<MV1>();
+		
+		const auto m = Regressive<MV1>(Grade<2>(line), Grade<3>(plane));
+		typedef typename decltype(m)::Blades Blades;
+		
+		const TYPE w = m._data[Blades::find(H)];
+		const bool hit = w > epsilon || w < -epsilon;
+		const TYPE inverse = hit ? TYPE(1) / w : TYPE(0);
+		
+		GATuple<MV1, TYPE> toRet;
+		for (int i=0; i<Blades::count; i++)
+			toRet._data[Blades::mask(i)] = m._data[i] * inverse;
+		toRet._data[H] = hit ? TYPE(1) : TYPE(0);
+		
+		point = toRet;
+		return hit;
+	}
+	
+	
+	//! Point where a line crosses a plane, divided (see IntersectPairs).
+	/*!	@return		False when the line is parallel to the plane.
+	 */
+	template<GABasis MV1, class TYPE>
+	inline bool Intersect(GATuple<MV1, TYPE> &point, const GATuple<MV1, TYPE> &line, const GATuple<MV1, TYPE> &plane, TYPE epsilon = TYPE(0))
+	{
+		return IntersectInto<MV1>(point, line, plane, epsilon);
+	}
+	
+	
+	//! Point where a line crosses a plane, read from views and written into the view point.
+	/*!	Only the blades of the layout of point are written (the vectors, e4 = 1).
+	 
+		@return		False when the line is parallel to the plane.
+	 */
+	template<class B0, class TYPE, class B1, class T1, class B2, class T2>
+	inline bool Intersect(GATupleView<B0, TYPE> point, const GATupleView<B1, T1> &line, const GATupleView<B2, T2> &plane, TYPE epsilon = TYPE(0))
+	{
+		return IntersectInto<ViewSpan<B1, B2>()>(point, line, plane, epsilon);
+	}
+	
+	
+	//! Kernel of IntersectPairs.
+	struct IntersectPairsKernel
+	{
+		template<GABasis MV1, class TYPE>
+		static void run(GATuple<MV1, TYPE> *points, bool *hit, const GATuple<MV1, TYPE> *lines, const GATuple<MV1, TYPE> *planes, std::ptrdiff_t count, TYPE epsilon)
+		{
+			for (std::ptrdiff_t i=0; i<count; i++)
+				hit[i] = Intersect(points[i], lines[i], planes[i], epsilon);
+		}
+		
+		template<class B0, class B1, class B2, class TYPE>
+		static void run(GATupleArrayView<B0, TYPE> points, bool *hit, GATupleArrayView<B1, const TYPE> lines, GATupleArrayView<B2, const TYPE> planes, std::ptrdiff_t count, TYPE epsilon)
+		{
+			for (std::ptrdiff_t i=0; i<count; i++)
+				hit[i] = Intersect(points[i], lines[i], planes[i], epsilon);
+		}
+	};
+	
+	
+	//! Kernel of IntersectPlane.
+	struct IntersectPlaneKernel
+	{
+		template<GABasis MV1, class TYPE>
+		static void run(GATuple<MV1, TYPE> *points, bool *hit, const GATuple<MV1, TYPE> *lines, const GATuple<MV1, TYPE> *plane, std::ptrdiff_t count, TYPE epsilon)
+		{
+			const GATuple<MV1, TYPE> p = *plane;
+			for (std::ptrdiff_t i=0; i<count; i++)
+				hit[i] = Intersect(points[i], lines[i], p, epsilon);
+		}
+		
+		template<class B0, class B1, class B2, class TYPE>
+		static void run(GATupleArrayView<B0, TYPE> points, bool *hit, GATupleArrayView<B1, const TYPE> lines, GATupleView<B2, const TYPE> plane, std::ptrdiff_t count, TYPE epsilon)
+		{
+			const auto p = plane.sparse();
+			for (std::ptrdiff_t i=0; i<count; i++)
+				hit[i] = Intersect(points[i], lines[i], View(p), epsilon);
+		}
+	};
+	
+	
+	//! Run f(i, j) for every line i and plane j, LGA_PLUCKER_TILE planes at a time.
+	/*!	Every line visits a tile of planes while it is in cache, so the
+		planes are read from memory once rather than once per line. */
+	template<class F>
+	inline void ForEachTile(std::ptrdiff_t lineCount, std::ptrdiff_t planeCount, F f)
+	{
+		for (std::ptrdiff_t j0=0; j0<planeCount; j0+=LGA_PLUCKER_TILE)
+		{
+			const std::ptrdiff_t j1 = std::min<std::ptrdiff_t>(j0 + LGA_PLUCKER_TILE, planeCount);
+			for (std::ptrdiff_t i=0; i<lineCount; i++)
+				for (std::ptrdiff_t j=j0; j<j1; j++)
+					f(i, j);
+		}
+	}
+	
+	
+	//! Kernel of IntersectAll.
+	struct IntersectAllKernel
+	{
+		template<GABasis MV1, class TYPE>
+		static void run(GATuple<MV1, TYPE> *points, bool *hit, const GATuple<MV1, TYPE> *lines, std::ptrdiff_t lineCount, const GATuple<MV1, TYPE> *planes, std::ptrdiff_t planeCount, TYPE epsilon)
+		{
+			ForEachTile(lineCount, planeCount, [&](std::ptrdiff_t i, std::ptrdiff_t j)
+			{
+				hit[i * planeCount + j] = Intersect(points[i * planeCount + j], lines[i], planes[j], epsilon);
+			});
+		}
+		
+		template<class B0, class B1, class B2, class TYPE>
+		static void run(GATupleArrayView<B0, TYPE> points, bool *hit, GATupleArrayView<B1, const TYPE> lines, std::ptrdiff_t lineCount, GATupleArrayView<B2, const TYPE> planes, std::ptrdiff_t planeCount, TYPE epsilon)
+		{
+			ForEachTile(lineCount, planeCount, [&](std::ptrdiff_t i, std::ptrdiff_t j)
+			{
+				hit[i * planeCount + j] = Intersect(points[i * planeCount + j], lines[i], planes[j], epsilon);
+			});
+		}
+	};
+	
+	
+	//! Points where N lines cross N planes (or one plane), into a batch.
+	/*!	The blades of o that are not vectors are 0. */
+	template<GABasis MV1, class TYPE, int N, class Y>
+	inline void IntersectLanes(GATupleBatch<MV1, TYPE, N> &o, bool *hit, const TYPE (*lines)[N], Y planes, TYPE epsilon)
+	{
+		alignas(64) TYPE acc[MV1+1][N];
+		
+		for (int i=0; i<PointBlades<MV1>::count; i++)
+			for (int n=0; n<N; n++)
+				acc[PointBlades<MV1>::slot(i)][n] = 0;
+		
+		GABatchProduct<LineBlades<MV1>, PlaneBlades<MV1>, GAComplementBlades<MV1>, GA_RegressiveProduct<MV1>>(acc, lines, planes);
+		DivideKernel<MV1>::run(acc, hit, epsilon);
+		
+		// Clearing every blade, then writing the vectors, is cheaper than
+		// picking the blades that are not vectors.
+		for (int b=0; b<=MV1; b++)
+			for (int n=0; n<N; n++)
+				o._data[b][n] = 0;
+		
+		for (int i=0; i<PointBlades<MV1>::count; i++)
+			for (int n=0; n<N; n++)
+				o._data[PointBlades<MV1>::slot(i)][n] = acc[PointBlades<MV1>::slot(i)][n];
+	}
+	
+	
+	//! Kernel of IntersectPairs, on batches.
+	struct IntersectBatchPairsKernel
+	{
+		template<GABasis MV1, class TYPE, int N>
+		static void run(GATupleBatch<MV1, TYPE, N> *points, bool *hit, const GATupleBatch<MV1, TYPE, N> *lines, const GATupleBatch<MV1, TYPE, N> *planes, std::ptrdiff_t count, TYPE epsilon)
+		{
+			for (std::ptrdiff_t i=0; i<count; i++)
+				IntersectLanes(points[i], hit + i * N, lines[i]._data, planes[i]._data, epsilon);
+		}
+	};
+	
+	
+	//! Kernel of IntersectPlane, on batches.
+	struct IntersectBatchPlaneKernel
+	{
+		template<GABasis MV1, class TYPE, int N>
+		static void run(GATupleBatch<MV1, TYPE, N> *points, bool *hit, const GATupleBatch<MV1, TYPE, N> *lines, const GATuple<MV1, TYPE> *plane, std::ptrdiff_t count, TYPE epsilon)
+		{
+			for (std::ptrdiff_t i=0; i<count; i++)
+				IntersectLanes(points[i], hit + i * N, lines[i]._data, plane->_data, epsilon);
+		}
+	};
+	
+	
+	//! Kernel of IntersectAll, on batches.
+	struct IntersectBatchAllKernel
+	{
+		template<GABasis MV1, class TYPE, int N>
+		static void run(GATupleBatch<MV1, TYPE, N> *points, bool *hit, const GATupleBatch<MV1, TYPE, N> *lines, std::ptrdiff_t lineCount, const GATuple<MV1, TYPE> *planes, std::ptrdiff_t planeCount, TYPE epsilon)
+		{
+			ForEachTile(lineCount, planeCount, [&](std::ptrdiff_t i, std::ptrdiff_t j)
+			{
+				IntersectLanes(points[i * planeCount + j], hit + (i * planeCount + j) * N, lines[i]._data, planes[j]._data, epsilon);
+			});
+		}
+	};
+	
+	
+	//! Intersect lines[i] with planes[i], for count pairs.
+	/*!	@param	points	The count points where the lines cross the planes,
+						divided so e4 is 1 (see HomogeneousDivide).
+		@param	hit		False where the line is parallel to the plane,
+						|e4| <= epsilon before the divide (the point is 0).
+		@param	lines	Lines (see Line), only the grade 2 part is read.
+		@param	planes	Planes (see Plane), only the grade 3 part is read.
+	 
+		Each pair is 12 multiply-adds (see MeetLinePlane), so moving tuples
+		into SIMD lanes costs more than it saves: they are run one at a time.
+		The Plucker kernels are scalar on purpose, as no SIMD level beat the
+		portable code (there is no GASIMDWins for them).  Keep the lines and
+		planes in GATupleBatch to let the compiler use the lanes (see the
+		overloads below).
+	 */
+	template<GABasis MV1, class TYPE>
+	void IntersectPairs(GATuple<MV1, TYPE> *points, bool *hit, const GATuple<MV1, TYPE> *lines, const GATuple<MV1, TYPE> *planes, std::ptrdiff_t count, TYPE epsilon = TYPE(0))
+	{
+		typedef GATuple<MV1, TYPE> Tuple;
+		GADispatch<IntersectPairsKernel, Tuple *, bool *, const Tuple *, const Tuple *, std::ptrdiff_t, TYPE>
+			::apply(points, hit, lines, planes, count, epsilon);
+	}
+	
+	
+	//! Intersect count lines with the same plane (see IntersectPairs).
+	template<GABasis MV1, class TYPE>
+	void IntersectPlane(GATuple<MV1, TYPE> *points, bool *hit, const GATuple<MV1, TYPE> *lines, const GATuple<MV1, TYPE> &plane, std::ptrdiff_t count, TYPE epsilon = TYPE(0))
+	{
+		typedef GATuple<MV1, TYPE> Tuple;
+		GADispatch<IntersectPlaneKernel, Tuple *, bool *, const Tuple *, const Tuple *, std::ptrdiff_t, TYPE>
+			::apply(points, hit, lines, &plane, count, epsilon);
+	}
+	
+	
+	//! Intersect every line with every plane (see IntersectPairs).
+	/*!	The result of lines[i] and planes[j] is at points[i * planeCount + j]
+		(and hit[i * planeCount + j]).  The planes are visited in tiles of
+		LGA_PLUCKER_TILE (see ForEachTile).
+	 */
+	template<GABasis MV1, class TYPE>
+	void IntersectAll(GATuple<MV1, TYPE> *points, bool *hit, const GATuple<MV1, TYPE> *lines, std::ptrdiff_t lineCount, const GATuple<MV1, TYPE> *planes, std::ptrdiff_t planeCount, TYPE epsilon = TYPE(0))
+	{
+		typedef GATuple<MV1, TYPE> Tuple;
+		GADispatch<IntersectAllKernel, Tuple *, bool *, const Tuple *, std::ptrdiff_t, const Tuple *, std::ptrdiff_t, TYPE>
+			::apply(points, hit, lines, lineCount, planes, planeCount, epsilon);
+	}
+	
+	
+	//! Intersect lines[i] with planes[i], read from and written to strided buffers.
+	/*!	Same as IntersectPairs on tuples, for lines.size() pairs.  Only the
+		blades of the layout of points are written.
+	 
+		@code
+			// Lines and planes of a record, the points written next to them.
+			struct Record { float line[6]; float plane[4]; float point[4]; };
+			typedef GAGradeBlades<e1^e2^e3^e4, 2>::type LineLayout;
+			typedef GAGradeBlades<e1^e2^e3^e4, 3>::type PlaneLayout;
+			typedef GAGradeBlades<e1^e2^e3^e4, 1>::type PointLayout;
+			
+			Plucker::IntersectPairs(GATupleArrayView<PointLayout>(&r[0].point[0], count, sizeof(Record)), hit,
+									GATupleArrayView<LineLayout, const float>(&r[0].line[0], count, sizeof(Record)),
+									GATupleArrayView<PlaneLayout, const float>(&r[0].plane[0], count, sizeof(Record)));
+		@endcode
+	 */
+	template<class B0, class TYPE, class B1, class T1, class B2, class T2>
+	void IntersectPairs(GATupleArrayView<B0, TYPE> points, bool *hit, GATupleArrayView<B1, T1> lines, GATupleArrayView<B2, T2> planes, TYPE epsilon = TYPE(0))
+	{
+		typedef GATupleArrayView<B0, TYPE> Points;
+		typedef GATupleArrayView<B1, const TYPE> Lines;
+		typedef GATupleArrayView<B2, const TYPE> Planes;
+		GADispatch<IntersectPairsKernel, Points, bool *, Lines, Planes, std::ptrdiff_t, TYPE>
+			::apply(points, hit, lines, planes, lines.size(), epsilon);
+	}
+	
+	
+	//! Intersect the lines of a strided buffer with the same plane.
+	template<class B0, class TYPE, class B1, class T1, class B2, class T2>
+	void IntersectPlane(GATupleArrayView<B0, TYPE> points, bool *hit, GATupleArrayView<B1, T1> lines, const GATupleView<B2, T2> &plane, TYPE epsilon = TYPE(0))
+	{
+		typedef GATupleArrayView<B0, TYPE> Points;
+		typedef GATupleArrayView<B1, const TYPE> Lines;
+		typedef GATupleView<B2, const TYPE> Plane;
+		GADispatch<IntersectPlaneKernel, Points, bool *, Lines, Plane, std::ptrdiff_t, TYPE>
+			::apply(points, hit, lines, plane, lines.size(), epsilon);
+	}
+	
+	
+	//! Intersect every line with every plane of strided buffers.
+	/*!	The result of lines[i] and planes[j] is at points[i * planes.size() + j]. */
+	template<class B0, class TYPE, class B1, class T1, class B2, class T2>
+	void IntersectAll(GATupleArrayView<B0, TYPE> points, bool *hit, GATupleArrayView<B1, T1> lines, GATupleArrayView<B2, T2> planes, TYPE epsilon = TYPE(0))
+	{
+		assert(points.size() >= lines.size() * planes.size());
+		
+		typedef GATupleArrayView<B0, TYPE> Points;
+		typedef GATupleArrayView<B1, const TYPE> Lines;
+		typedef GATupleArrayView<B2, const TYPE> Planes;
+		GADispatch<IntersectAllKernel, Points, bool *, Lines, std::ptrdiff_t, Planes, std::ptrdiff_t, TYPE>
+			::apply(points, hit, lines, lines.size(), planes, planes.size(), epsilon);
+	}
+	
+	
+	//! Intersect the lanes of lines[i] with the lanes of planes[i], for count batches.
+	/*!	Every multiply-add covers the N pairs of a batch, in loops over the
+		lanes that the compiler vectorizes.  The kernel itself is scalar on
+		purpose (see IntersectPairs).  See IntersectPairs above for the
+		results.
+	 
+		@param	hit		N entries per batch.
+	 */
+	template<GABasis MV1, class TYPE, int N>
+	void IntersectPairs(GATupleBatch<MV1, TYPE, N> *points, bool *hit, const GATupleBatch<MV1, TYPE, N> *lines, const GATupleBatch<MV1, TYPE, N> *planes, std::ptrdiff_t count, TYPE epsilon = TYPE(0))
+	{
+		typedef GATupleBatch<MV1, TYPE, N> Batch;
+		GADispatch<IntersectBatchPairsKernel, Batch *, bool *, const Batch *, const Batch *, std::ptrdiff_t, TYPE>
+			::apply(points, hit, lines, planes, count, epsilon);
+	}
+	
+	
+	//! Intersect count batches of lines with the same plane.
+	template<GABasis MV1, class TYPE, int N>
+	void IntersectPlane(GATupleBatch<MV1, TYPE, N> *points, bool *hit, const GATupleBatch<MV1, TYPE, N> *lines, const GATuple<MV1, TYPE> &plane, std::ptrdiff_t count, TYPE epsilon = TYPE(0))
+	{
+		typedef GATupleBatch<MV1, TYPE, N> Batch;
+		GADispatch<IntersectBatchPlaneKernel, Batch *, bool *, const Batch *, const GATuple<MV1, TYPE> *, std::ptrdiff_t, TYPE>
+			::apply(points, hit, lines, &plane, count, epsilon);
+	}
+	
+	
+	//! Intersect every batch of lines with every plane.
+	/*!	The lanes of lines[i] and planes[j] are at points[i * planeCount + j]
+		(and N entries from hit[(i * planeCount + j) * N]).
+	 */
+	template<GABasis MV1, class TYPE, int N>
+	void IntersectAll(GATupleBatch<MV1, TYPE, N> *points, bool *hit, const GATupleBatch<MV1, TYPE, N> *lines, std::ptrdiff_t lineCount, const GATuple<MV1, TYPE> *planes, std::ptrdiff_t planeCount, TYPE epsilon = TYPE(0))
 	{
-		return Dual(o1) * o2;
+		typedef GATupleBatch<MV1, TYPE, N> Batch;
+		GADispatch<IntersectBatchAllKernel, Batch *, bool *, const Batch *, std::ptrdiff_t, const GATuple<MV1, TYPE> *, std::ptrdiff_t, TYPE>
+			::apply(points, hit, lines, lineCount, planes, planeCount, epsilon);
 	}
 }
\ No newline at end of file
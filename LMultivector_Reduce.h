@@ -0,0 +1,447 @@
+#pragma once//
+
+#include "LMultivector.h"
+#include "LMultivector_Batch.h"
+#include "LMultivector_Parallel.h"
+
+#include <type_traits>
+#include <vector>
+
+/*!	@file	LMultivector_Reduce.h		Sums and moments of large arrays, on every core
+	
+	GAParallelReduce gives each chunk of an array its own accumulator and
+	merges them pairwise, in a tree.  The chunk is the unit rather than the
+	thread, so the result does not depend on which thread stole what: the
+	same grain gives the same bits.  Within a chunk, the sums run in the
+	lanes of the widest instruction set (see GADispatch), N independent
+	accumulators instead of one loop-carried add.
+	
+	GA_KahanSum compensates the rounding of each add, for float sums over
+	hundreds of millions of points (-ffast-math removes the compensation).
+	
+	@code
+		const GAMoments<e1^e2^e3^e4> m = GAMomentsOf<GA_KahanSum>(points, count);
+		const GATuple<e1^e2^e3^e4> centroid = m.mean();
+		const float cxy = m.covariance(0, 1);
+		
+		// The plane of a polygon, as the sum of the wedges of its edges with a point.
+		const GATuple<e1^e2^e3^e4> plane = GASumOf(count, [&](std::ptrdiff_t i)
+		{
+			return Plucker::Plane(centroid, p[i], p[(i + 1) % count]);
+		});
+	@endcode
+ */
+
+
+//! Adds without compensation.
+struct GA_PlainSum
+{
+	template<class T>
+	static void add(T &sum, T &, const T x) { sum += x; }
+};
+
+
+//! Kahan's compensated sum, the rounding of each add is carried into the next.
+/*!	The sum is sum - compensation.  Costs three more adds per term. */
+struct GA_KahanSum
+{
+	template<class T>
+	static void add(T &sum, T &compensation, const T x)
+	{
+		const T y = x - compensation;
+		const T t = sum + y;
+		compensation = (t - sum) - y;
+		sum = t;
+	}
+};
+
+
+//! ROWS sums, each spread over N lanes (and their compensations).
+template<int ROWS, class T, int N>
+struct GALaneSums
+{
+	//! Add the lanes of a row, pairwise.
+	T total(int row) const
+	{
+		T lane[N];
+		for (int n=0; n<N; n++)
+			lane[n] = sum[row][n] - compensation[row][n];
+		
+		for (int w=1; w<N; w*=2)
+			for (int n=0; n+w<N; n+=2*w)
+				lane[n] += lane[n + w];
+		return lane[0];
+	}
+	
+	alignas(64) T sum[ROWS][N] = {};
+	alignas(64) T compensation[ROWS][N] = {};
+};
+
+
+//! Lanes of the sums of tuples, one cache line (a register of AVX-512).
+template<class T>
+constexpr int GAReduceLanes()
+{
+	return 64 / sizeof(T) > 0 ? int(64 / sizeof(T)) : 1;
+}
+
+
+//! Kernel of GASum.
+template<class SUM>
+struct GASumKernel
+{
+	template<class A, GABasis PS, class T, int N>
+	static void run(A *acc, const GATupleBatch<PS, T, N> *in_, std::ptrdiff_t count)
+	{
+		for (std::ptrdiff_t i=0; i<count; i++)
+			for (int b=0; b<=PS; b++)
+			{
+				LGA_IVDEP
+				for (int n=0; n<N; n++)
+					SUM::add(acc->sum[b][n], acc->compensation[b][n], in_[i]._data[b][n]);
+			}
+	}
+	
+	//! Tuple i goes to lane i % K, each lane adds the blades of a tuple at once.
+	template<int ROWS, int K, GABasis PS, class T>
+	static void run(GALaneSums<ROWS, T, K> *acc, const GATuple<PS, T> *in_, std::ptrdiff_t count)
+	{
+		alignas(64) T sum[K][PS + 1] = {};
+		alignas(64) T compensation[K][PS + 1] = {};
+		
+		std::ptrdiff_t i = 0;
+		for (; i+K<=count; i+=K)
+			for (int k=0; k<K; k++)
+			{
+				LGA_IVDEP
+				for (int b=0; b<=PS; b++)
+					SUM::add(sum[k][b], compensation[k][b], in_[i + k]._data[b]);
+			}
+		
+		for (int k=0; i+k<count; k++)
+			for (int b=0; b<=PS; b++)
+				SUM::add(sum[k][b], compensation[k][b], in_[i + k]._data[b]);
+		
+		for (int k=0; k<K; k++)
+			for (int b=0; b<=PS; b++)
+			{
+				acc->sum[b][k] = sum[k][b];
+				acc->compensation[b][k] = compensation[k][b];
+			}
+	}
+};
+
+
+//! Reduce [0, in_count) by chunks, each into a copy of identity, then merge the chunks pairwise.
+/*!	@param	in_bytes	Bytes read per record, to size the chunks (see GAParallelFor).
+	@param	f			f(A &acc, begin, end) adds the records [begin, end) to acc.
+	@param	merge		merge(A &l, const A &r) adds r to l.
+	
+	Chunk 2k + 1 is merged into chunk 2k, then 4k + 2 into 4k, and so on:
+	the error grows with the log of the chunks rather than with their count.
+ */
+template<class A, class F, class M>
+A GAParallelReduce(std::ptrdiff_t in_count, std::size_t in_bytes, const A &identity, F f, M merge, const GAParallelOptions &options = GAParallelOptions())
+{
+	assert(in_count >= 0);
+	
+	const std::size_t count = std::size_t(in_count);
+	const std::size_t grain = GAParallelGrain(count, in_bytes, options);
+	const std::size_t chunks = (count + grain - 1) / grain;
+	
+	if (chunks == 0)
+		return identity;
+	
+	std::vector<A> partial(chunks, identity);
+	GAParallelExecutor(options).run(chunks, [&](std::size_t k)
+	{
+		f(partial[k], std::ptrdiff_t(k * grain), std::ptrdiff_t(std::min(count, (k + 1) * grain)));
+	});
+	
+	for (std::size_t w=1; w<chunks; w*=2)
+		for (std::size_t k=0; k+w<chunks; k+=2*w)
+			merge(partial[k], partial[k + w]);
+	return partial[0];
+}
+
+
+//! The sum of count tuples, in parallel.
+/*!	@tparam	SUM		GA_PlainSum, or GA_KahanSum to compensate the rounding. */
+template<class SUM = GA_PlainSum, GABasis PS, class T>
+GATuple<PS, T> GASum(const GATuple<PS, T> *in_, std::ptrdiff_t count, const GAParallelOptions &options = GAParallelOptions())
+{
+	typedef GATuple<PS, T> Tuple;
+	typedef GALaneSums<PS + 1, T, 4> Lanes;		// Enough chains to hide the latency of the adds
+	
+	return GAParallelReduce(count, sizeof(Tuple), Tuple(), [&](Tuple &acc, std::ptrdiff_t begin, std::ptrdiff_t end)
+	{
+		Lanes lanes;
+		GADispatch<GASumKernel<SUM>, Lanes *, const Tuple *, std::ptrdiff_t>::apply(&lanes, in_ + begin, end - begin);
+		
+		for (int b=0; b<=PS; b++)
+			acc._data[b] = lanes.total(b);
+	}, [](Tuple &l, const Tuple &r) { l += r; }, options);
+}
+
+
+//! The sum of every lane of count batches, in parallel.
+template<class SUM = GA_PlainSum, GABasis PS, class T, int N>
+GATuple<PS, T> GASum(const GATupleBatch<PS, T, N> *in_, std::ptrdiff_t count, const GAParallelOptions &options = GAParallelOptions())
+{
+	typedef GATuple<PS, T> Tuple;
+	typedef GATupleBatch<PS, T, N> Batch;
+	typedef GALaneSums<PS + 1, T, N> Lanes;
+	
+	return GAParallelReduce(count, sizeof(Batch), Tuple(), [&](Tuple &acc, std::ptrdiff_t begin, std::ptrdiff_t end)
+	{
+		Lanes lanes;
+		GADispatch<GASumKernel<SUM>, Lanes *, const Batch *, std::ptrdiff_t>::apply(&lanes, in_ + begin, end - begin);
+		
+		for (int b=0; b<=PS; b++)
+			acc._data[b] = lanes.total(b);
+	}, [](Tuple &l, const Tuple &r) { l += r; }, options);
+}
+
+
+//! The sum of f(0) to f(count - 1), in parallel.
+/*!	f returns a GATuple or a GASparseTuple, such as the wedge of two points
+	or the view of a record (View(x).sparse()).
+ */
+template<class SUM = GA_PlainSum, class F>
+auto GASumOf(std::ptrdiff_t count, F f, const GAParallelOptions &options = GAParallelOptions())
+	-> typename std::decay<decltype(f(std::ptrdiff_t(0)))>::type
+{
+	typedef typename std::decay<decltype(f(std::ptrdiff_t(0)))>::type R;
+	const int rows = int(std::extent<decltype(R::_data)>::value);
+	
+	return GAParallelReduce(count, sizeof(R), R(), [&](R &acc, std::ptrdiff_t begin, std::ptrdiff_t end)
+	{
+		R compensation;
+		for (std::ptrdiff_t i=begin; i<end; i++)
+		{
+			const R x = f(i);
+			for (int b=0; b<rows; b++)
+				SUM::add(acc._data[b], compensation._data[b], x._data[b]);
+		}
+		
+		for (int b=0; b<rows; b++)
+			acc._data[b] -= compensation._data[b];
+	}, [rows](R &l, const R &r)
+	{
+		for (int b=0; b<rows; b++)
+			l._data[b] += r._data[b];
+	}, options);
+}
+
+
+//! The first and second moments of points, the vectors of PS.
+/*!	For the points of Plucker::Point (e4 = 1), mean() is the centroid and
+	covariance(r, c), for r and c below 3, their covariance matrix.
+	
+	The sums are of the points moved by -origin (GAMomentsOf takes the
+	first point), so that the covariance of a cloud far from 0 does not
+	cancel out in float.
+ */
+template<GABasis PS, class T = float>
+struct GAMoments
+{
+	static constexpr int dim = GAGrade(PS);
+	
+	//! The i-th vector of PS.
+	static constexpr GABasis vector(int i) { return GABasis(GADeposit(1u << i, PS)); }
+	
+	//! The mean of the points.
+	GATuple<PS, T> mean() const
+	{
+		GATuple<PS, T> toRet;
+		for (int r=0; r<dim && count>0; r++)
+			toRet._data[vector(r)] = origin[r] + sum[r] / T(count);
+		return toRet;
+	}
+	
+	//! The covariance of the coordinates r and c (of the vectors r and c of PS).
+	T covariance(int r, int c) const
+	{
+		assert(r >= 0 && r < dim && c >= 0 && c < dim);
+		if (count == 0)
+			return T(0);
+		
+		const T n = T(count);
+		return outer[r][c] / n - (sum[r] / n) * (sum[c] / n);
+	}
+	
+	//! Add the points of in_, moved to the origin of this.
+	GAMoments &operator+=(const GAMoments &in_)
+	{
+		if (count == 0)
+			return *this = in_;
+		
+		T d[dim > 0 ? dim : 1];
+		for (int r=0; r<dim; r++)
+			d[r] = in_.origin[r] - origin[r];
+		
+		const T n = T(in_.count);
+		for (int r=0; r<dim; r++)
+			for (int c=0; c<dim; c++)
+				outer[r][c] += in_.outer[r][c] + d[r] * in_.sum[c] + d[c] * in_.sum[r] + n * d[r] * d[c];
+		for (int r=0; r<dim; r++)
+			sum[r] += in_.sum[r] + n * d[r];
+		
+		count += in_.count;
+		return *this;
+	}
+	
+	std::ptrdiff_t count = 0;			//!< Points
+	T origin[dim > 0 ? dim : 1] = {};	//!< The point the sums are taken from
+	T sum[dim > 0 ? dim : 1] = {};		//!< sum[r] is the sum of x_r - origin[r]
+	T outer[dim > 0 ? dim : 1][dim > 0 ? dim : 1] = {};		//!< outer[r][c] is the sum of (x_r - origin[r]) (x_c - origin[c])
+};
+
+
+//! Kernel of GAMomentsOf.
+/*!	The rows of the lanes are the sums of the coordinates, then the sums
+	of x_r x_c for c >= r, row by row (of the points moved by -origin).
+ */
+template<class SUM>
+struct GAMomentsKernel
+{
+	template<class A, GABasis PS, class T, int N>
+	static void run(A *acc, const GATupleBatch<PS, T, N> *in_, std::ptrdiff_t count, const T *origin)
+	{
+		typedef GAMoments<PS, T> Moments;
+		const int dim = Moments::dim;
+		
+		for (std::ptrdiff_t i=0; i<count; i++)
+		{
+			alignas(64) T x[dim > 0 ? dim : 1][N];
+			for (int r=0; r<dim; r++)
+			{
+				LGA_IVDEP
+				for (int n=0; n<N; n++)
+					x[r][n] = in_[i]._data[Moments::vector(r)][n] - origin[r];
+			}
+			
+			int row = dim;
+			for (int r=0; r<dim; r++)
+			{
+				LGA_IVDEP
+				for (int n=0; n<N; n++)
+					SUM::add(acc->sum[r][n], acc->compensation[r][n], x[r][n]);
+				
+				for (int c=r; c<dim; c++, row++)
+				{
+					LGA_IVDEP
+					for (int n=0; n<N; n++)
+						SUM::add(acc->sum[row][n], acc->compensation[row][n], x[r][n] * x[c][n]);
+				}
+			}
+		}
+	}
+	
+	//! Gathered into batches, a lane per tuple (the lanes past count at the origin).
+	template<class A, GABasis PS, class T>
+	static void run(A *acc, const GATuple<PS, T> *in_, std::ptrdiff_t count, const T *origin)
+	{
+		typedef GAMoments<PS, T> Moments;
+		constexpr int N = GAReduceLanes<T>();
+		
+		GATupleBatch<PS, T, N> batch;
+		for (std::ptrdiff_t i=0; i<count; i+=N)
+		{
+			const int lanes = int(std::min<std::ptrdiff_t>(N, count - i));
+			batch.gather(in_ + i, lanes);
+			for (int r=0; r<Moments::dim; r++)
+				for (int n=lanes; n<N; n++)
+					batch._data[Moments::vector(r)][n] = origin[r];
+			
+			run(acc, &batch, 1, origin);
+		}
+	}
+};
+
+
+//! The sums and the moments win with AVX2 and AVX-512 (SSE4.1 ties the scalar code).
+template<class SUM, int LEVEL>
+struct GASIMDWins<GASumKernel<SUM>, LEVEL>
+: public std::integral_constant<bool, LEVEL >= LGA_SIMD_AVX2>
+{};
+
+template<class SUM, int LEVEL>
+struct GASIMDWins<GAMomentsKernel<SUM>, LEVEL>
+: public std::integral_constant<bool, LEVEL >= LGA_SIMD_AVX2>
+{};
+
+
+//! Copy the lane sums of GAMomentsKernel into moments.
+template<GABasis PS, class T, class A>
+void GAMomentsTotal(GAMoments<PS, T> &moments, const A &lanes)
+{
+	typedef GAMoments<PS, T> Moments;
+	
+	int row = Moments::dim;
+	for (int r=0; r<Moments::dim; r++)
+	{
+		moments.sum[r] = lanes.total(r);
+		for (int c=r; c<Moments::dim; c++, row++)
+			moments.outer[r][c] = moments.outer[c][r] = lanes.total(row);
+	}
+}
+
+
+//! The moments of count points, in parallel, about the first one.
+/*!	@tparam	SUM		GA_PlainSum, or GA_KahanSum to compensate the rounding. */
+template<class SUM = GA_PlainSum, GABasis PS, class T>
+GAMoments<PS, T> GAMomentsOf(const GATuple<PS, T> *points, std::ptrdiff_t count, const GAParallelOptions &options = GAParallelOptions())
+{
+	typedef GAMoments<PS, T> Moments;
+	typedef GATuple<PS, T> Tuple;
+	typedef GALaneSums<Moments::dim + Moments::dim * (Moments::dim + 1) / 2, T, GAReduceLanes<T>()> Lanes;
+	
+	Moments identity;
+	for (int r=0; r<Moments::dim && count>0; r++)
+		identity.origin[r] = points[0]._data[Moments::vector(r)];
+	
+	return GAParallelReduce(count, sizeof(Tuple), identity, [&](Moments &acc, std::ptrdiff_t begin, std::ptrdiff_t end)
+	{
+		Lanes lanes;
+		GADispatch<GAMomentsKernel<SUM>, Lanes *, const Tuple *, std::ptrdiff_t, const T *>
+			::apply(&lanes, points + begin, end - begin, acc.origin);
+		
+		GAMomentsTotal(acc, lanes);
+		acc.count = end - begin;
+	}, [](Moments &l, const Moments &r) { l += r; }, options);
+}
+
+
+//! The moments of count points, stored in (count + N - 1) / N batches.
+/*!	The lanes past the last point are 0 (as GATupleBatch::gather leaves them). */
+template<class SUM = GA_PlainSum, GABasis PS, class T, int N>
+GAMoments<PS, T> GAMomentsOf(const GATupleBatch<PS, T, N> *points, std::ptrdiff_t count, const GAParallelOptions &options = GAParallelOptions())
+{
+	typedef GAMoments<PS, T> Moments;
+	typedef GATupleBatch<PS, T, N> Batch;
+	typedef GALaneSums<Moments::dim + Moments::dim * (Moments::dim + 1) / 2, T, N> Lanes;
+	
+	Moments identity;
+	for (int r=0; r<Moments::dim && count>0; r++)
+		identity.origin[r] = points[0]._data[Moments::vector(r)][0];
+	
+	return GAParallelReduce((count + N - 1) / N, sizeof(Batch), identity, [&](Moments &acc, std::ptrdiff_t begin, std::ptrdiff_t end)
+	{
+		Lanes lanes;
+		GADispatch<GAMomentsKernel<SUM>, Lanes *, const Batch *, std::ptrdiff_t, const T *>
+			::apply(&lanes, points + begin, end - begin, acc.origin);
+		
+		GAMomentsTotal(acc, lanes);
+		acc.count = std::min(count, end * N) - begin * N;
+		
+		// The empty lanes of the last batch were read as -origin.
+		const T empty = T(end * N - begin * N - acc.count);
+		for (int r=0; r<Moments::dim; r++)
+		{
+			acc.sum[r] += empty * acc.origin[r];
+			for (int c=0; c<Moments::dim; c++)
+				acc.outer[r][c] -= empty * acc.origin[r] * acc.origin[c];
+		}
+	}, [](Moments &l, const Moments &r) { l += r; }, options);
+}
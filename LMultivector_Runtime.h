@@ -0,0 +1,646 @@
+#pragma once//
+
+#include "LMultivector.h"
+#include "LMultivector_Sparse.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+/*!	@file	LMultivector_Runtime.h		Multivectors of an algebra picked at run time
+	
+	GATuple and GASparseTuple fix their algebra at compile time.  When the
+	dimension or the signature is only known once a file is loaded, a
+	GARuntimeTuple stores its blades as (mask, coefficient) pairs, sorted by
+	mask, and points to a GARuntimeAlgebra.  The signs come from the same
+	operations as the compile-time products (GA_GeometricProduct::sign and
+	GAMetricSquare), so both engines agree blade for blade.
+	
+	Each algebra (dimension, signature) is created once.  Up to
+	LGA_RUNTIME_TABLE_BITS basis vectors, it caches the sign table of each
+	product the first time it is used, wider algebras compute the signs on
+	the fly.  Up to LGA_RUNTIME_DENSE_BITS, the products accumulate every
+	blade on the stack (as much as a GATuple of the algebra), wider ones
+	radix sort the terms.
+	
+	The terms live in a small inline buffer, then in a GAArena when one is
+	given, or in a heap buffer kept across reuses: GARuntimeMultiply does not
+	allocate once the output has grown to its working size.
+	
+	@code
+		const GARuntimeAlgebra &cga = GARuntimeAlgebra::get(5, e5);
+		GAArena arena;
+		
+		GARuntimeTuple<> a(cga, &arena), b(cga, &arena), c(cga, &arena);
+		a.set(e1, 1.0f);
+		a.set(e4, 0.5f);
+		b.set(e1^e2, 2.0f);
+		GARuntimeMultiply<GA_GeometricProduct>(c, a, b);
+		
+		auto t = c.tuple<e1^e2^e3^e4^e5, GAConformal>();	// back to the compiled products
+	@endcode
+ */
+
+
+#ifndef LGA_RUNTIME_TABLE_BITS
+//! Runtime algebras up to this dimension cache their sign tables (4^N bytes per product).
+#define LGA_RUNTIME_TABLE_BITS	8
+#endif
+
+#ifndef LGA_RUNTIME_DENSE_BITS
+//! Runtime algebras up to this dimension accumulate the products on the stack, wider ones sort the terms.
+#define LGA_RUNTIME_DENSE_BITS	LGA_DENSE_BITS
+#endif
+
+#ifndef LGA_RUNTIME_INLINE
+//! Terms a GARuntimeTuple stores without any allocation.
+#define LGA_RUNTIME_INLINE	16
+#endif
+
+
+//! Slot of the cached sign table of an operation, -1 for no table.
+template<class OP> struct GARuntimeOpSlot					{ enum { value = -1 }; };
+template<> struct GARuntimeOpSlot<GA_GeometricProduct>		{ enum { value = 0 }; };
+template<> struct GARuntimeOpSlot<GA_OuterProduct>			{ enum { value = 1 }; };
+template<> struct GARuntimeOpSlot<GA_InnerProduct>			{ enum { value = 2 }; };
+template<> struct GARuntimeOpSlot<GA_RightContraction>		{ enum { value = 3 }; };
+template<> struct GARuntimeOpSlot<GA_ScalarProduct>			{ enum { value = 4 }; };
+
+
+//! An algebra whose dimension and signature are chosen at run time.
+/*!	Algebras are shared, get() returns the same object for the same
+	dimension and signature, so two tuples are in the same algebra when
+	their algebra() has the same address.
+ */
+class GARuntimeAlgebra
+{
+public:
+	//! The algebra of the first dimension basis vectors.
+	/*!	@param	neg		Basis vectors that square to -1
+		@param	zero	Basis vectors that square to 0
+	 */
+	static const GARuntimeAlgebra &get(int dimension, unsigned int neg = 0, unsigned int zero = 0)
+	{
+		static std::mutex lock;
+		static std::map<std::tuple<int, unsigned int, unsigned int>, std::unique_ptr<GARuntimeAlgebra>> algebras;
+		
+		std::lock_guard<std::mutex> guard(lock);
+		std::unique_ptr<GARuntimeAlgebra> &toRet = algebras[std::make_tuple(dimension, neg, zero)];
+		if (!toRet)
+			toRet.reset(new GARuntimeAlgebra(dimension, neg, zero));
+		return *toRet;
+	}
+	
+	//! The algebra of a compile-time pseudo-scalar and signature.
+	template<GABasis PS, class S = GAEuclidean>
+	static const GARuntimeAlgebra &get()
+	{
+		static_assert((PS & (PS+1)) == 0, "A runtime algebra holds the first N basis vectors");
+		return get(GAGrade(PS), S::neg, S::zero);
+	}
+	
+	GARuntimeAlgebra(const GARuntimeAlgebra &) = delete;
+	GARuntimeAlgebra &operator=(const GARuntimeAlgebra &) = delete;
+	
+	int dimension() const { return _dimension; }
+	unsigned int pseudoScalar() const { return _ps; }
+	unsigned int neg() const { return _neg; }
+	unsigned int zero() const { return _zero; }
+	
+	//! Does this algebra have the signature S?
+	template<class S>
+	bool signature() const { return _neg == S::neg && _zero == S::zero; }
+	
+	//! Product of the squares of the basis vectors of m.
+	int square(unsigned int m) const { return GAMetricSquare(m, _neg, _zero); }
+	
+	//! Sign of the product OP of two blades in this algebra, 0 if the pair never contributes.
+	template<class OP>
+	int sign(unsigned int left, unsigned int right) const
+	{
+		if (GARuntimeOpSlot<OP>::value < 0)
+			return OP::sign(GABasis(left), GABasis(right)) * square(left & right);
+		
+		// The tabled operations keep some pairs of the geometric product, the
+		// sign of the reordering and the squares then share one parity.
+		if (OP::sign(GABasis(left), GABasis(right)) == 0 || (left & right & _zero) != 0)
+			return 0;
+		return GAGrade(GABasis(flips(left) & right)) % 2 == 0 ? 1 : -1;
+	}
+	
+	//! The bases of right that flip the sign of left right, GAProductFlips and the negative squares.
+	unsigned int flips(unsigned int left) const { return GAProductFlips(left) ^ (left & _neg); }
+	
+	//! The signs of OP, indexed by (left << dimension()) | right.
+	/*!	Built on first use.  nullptr above LGA_RUNTIME_TABLE_BITS, or for an
+		operation without a slot. */
+	template<class OP>
+	const signed char *table() const
+	{
+		const int slot = GARuntimeOpSlot<OP>::value;
+		if (slot < 0 || _dimension > LGA_RUNTIME_TABLE_BITS)
+			return nullptr;
+		
+		std::call_once(_built[slot], [this, slot]()
+		{
+			const unsigned int n = _ps + 1;
+			_tables[slot].reset(new signed char[n * n]);
+			for (unsigned int l=0; l<n; l++)
+				for (unsigned int r=0; r<n; r++)
+					_tables[slot][(l << _dimension) | r] = (signed char)sign<OP>(l, r);
+		});
+		return _tables[slot].get();
+	}
+	
+private:
+	GARuntimeAlgebra(int dimension, unsigned int neg, unsigned int zero)
+	: _dimension(dimension)
+	, _ps(dimension >= 32 ? ~0u : (1u << dimension) - 1)
+	, _neg(neg)
+	, _zero(zero)
+	{
+		assert(dimension >= 0 && dimension <= LGA_BASIS_BITS);
+		assert(((neg | zero) & ~_ps) == 0 && (neg & zero) == 0);
+	}
+	
+	const int _dimension;
+	const unsigned int _ps;
+	const unsigned int _neg;
+	const unsigned int _zero;
+	
+	mutable std::once_flag _built[5];
+	mutable std::unique_ptr<signed char[]> _tables[5];
+};
+
+
+//! Bump allocator for the terms of runtime tuples.
+/*!	Nothing is freed one at a time, reset() releases everything at once
+	(once per frame, or per file).  When a block fills up, another one is
+	chained; the next reset() replaces them by a single block of their total
+	size, so a steady workload stops touching the heap.
+ */
+class GAArena
+{
+public:
+	explicit GAArena(std::size_t bytes = 1 << 16)
+	: _size(bytes > 0 ? bytes : 1)
+	, _block(new char[_size])
+	{}
+	
+	//! Room for count objects of type T, valid until reset().
+	template<class T>
+	T *allocate(std::size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "The arena never runs destructors");
+		
+		const std::size_t bytes = count * sizeof(T);
+		std::size_t at = (_used + alignof(T) - 1) / alignof(T) * alignof(T);
+		if (at + bytes > _size)
+		{
+			_spilled += _size;
+			_full.push_back(std::move(_block));
+			_size = std::max(2 * _size, bytes);
+			_block.reset(new char[_size]);
+			at = 0;
+		}
+		
+		_used = at + bytes;
+		return reinterpret_cast<T *>(_block.get() + at);
+	}
+	
+	//! Release every allocation.
+	void reset()
+	{
+		if (!_full.empty())
+		{
+			_size += _spilled;
+			_full.clear();
+			_block.reset(new char[_size]);
+		}
+		_used = 0;
+		_spilled = 0;
+	}
+	
+	//! Bytes that can be handed out before the arena chains another block.
+	std::size_t capacity() const { return _size; }
+	
+private:
+	std::size_t _size;
+	std::size_t _used = 0;
+	std::size_t _spilled = 0;
+	std::unique_ptr<char[]> _block;
+	std::vector<std::unique_ptr<char[]>> _full;
+};
+
+
+//! A blade and its coefficient.
+template<class T>
+struct GARuntimeTerm
+{
+	unsigned int mask;
+	T value;
+};
+
+
+//! A multivector of a GARuntimeAlgebra, its non-zero blades sorted by mask.
+/*!	@tparam	T	The type (default float)
+ */
+template<class T = float>
+class GARuntimeTuple
+{
+public:
+	typedef GARuntimeTerm<T> Term;
+	
+	//! Zero.  The terms grow into arena when given, it must outlive the tuple.
+	explicit GARuntimeTuple(const GARuntimeAlgebra &in_algebra, GAArena *in_arena = nullptr)
+	: _algebra(&in_algebra)
+	, _arena(in_arena)
+	{}
+	
+	//! The non-zero blades of a dense tuple.
+	template<GABasis PS, class S>
+	GARuntimeTuple(const GARuntimeAlgebra &in_algebra, const GATuple<PS, T, S> &in_, GAArena *in_arena = nullptr)
+	: GARuntimeTuple(in_algebra, in_arena)
+	{
+		assert(in_algebra.signature<S>() && (PS & ~in_algebra.pseudoScalar()) == 0);
+		
+		reserve(1 << GAGrade(PS));
+		for (unsigned int i=0; i < (1u << GAGrade(PS)); i++)
+		{
+			const unsigned int m = GADeposit(i, PS);
+			if (in_._data[m] != T(0))
+				_terms[_count++] = Term{m, in_._data[m]};
+		}
+	}
+	
+	//! Every blade of a sparse tuple, zeros included.
+	template<class B>
+	GARuntimeTuple(const GARuntimeAlgebra &in_algebra, const GASparseTuple<B, T> &in_, GAArena *in_arena = nullptr)
+	: GARuntimeTuple(in_algebra, in_arena)
+	{
+		reserve(B::count);
+		for (int i=0; i<B::count; i++)
+		{
+			assert((B::mask(i) & ~in_algebra.pseudoScalar()) == 0);
+			_terms[_count++] = Term{B::mask(i), in_._data[i]};
+		}
+		std::sort(_terms, _terms + _count, [](const Term &a, const Term &b) { return a.mask < b.mask; });
+	}
+	
+	GARuntimeTuple(const GARuntimeTuple &in_)
+	: GARuntimeTuple(*in_._algebra, in_._arena)
+	{
+		*this = in_;
+	}
+	
+	GARuntimeTuple(GARuntimeTuple &&in_) noexcept
+	: GARuntimeTuple(*in_._algebra, in_._arena)
+	{
+		*this = std::move(in_);
+	}
+	
+	GARuntimeTuple &operator=(const GARuntimeTuple &in_)
+	{
+		if (this != &in_)
+		{
+			_algebra = in_._algebra;
+			clear();
+			reserve(in_._count);
+			std::copy(in_.begin(), in_.end(), _terms);
+			_count = in_._count;
+		}
+		return *this;
+	}
+	
+	//! Takes the heap storage of in_, or its arena storage when both share the arena.
+	/*!	Otherwise copies, which may allocate, so it is not noexcept.  The move
+		constructor shares the arena of in_ and never reaches that copy. */
+	GARuntimeTuple &operator=(GARuntimeTuple &&in_)
+	{
+		if (this == &in_)
+			return *this;
+		
+		_algebra = in_._algebra;
+		if (in_._terms == in_._inline || (!in_._heap && in_._arena != _arena))
+		{
+			*this = in_;
+		}
+		else
+		{
+			_heap = std::move(in_._heap);
+			_terms = in_._terms;
+			_capacity = in_._capacity;
+			_count = in_._count;
+			in_._terms = in_._inline;
+			in_._capacity = LGA_RUNTIME_INLINE;
+		}
+		in_._count = 0;
+		return *this;
+	}
+	
+	//! Convert to a dense tuple, for the compiled products.
+	/*!	Every blade must be within PS, and the signature must be S. */
+	template<GABasis PS, class S = GAEuclidean>
+	GATuple<PS, T, S> tuple() const
+	{
+		assert(_algebra->signature<S>());
+		
+		GATuple<PS, T, S> toRet;
+		for (const Term &t : *this)
+		{
+			assert((t.mask & ~(unsigned int)PS) == 0);
+			toRet._data[t.mask] = t.value;
+		}
+		return toRet;
+	}
+	
+	//! Convert to a sparse tuple, every blade must be within B.
+	template<class B>
+	GASparseTuple<B, T> sparse() const
+	{
+		GASparseTuple<B, T> toRet;
+		for (const Term &t : *this)
+		{
+			assert(B::find(t.mask) >= 0);
+			toRet._data[B::find(t.mask)] = t.value;
+		}
+		return toRet;
+	}
+	
+	//! Coefficient of a blade, zero when it is not stored.
+	T operator[](unsigned int mask) const
+	{
+		const Term *t = find(mask);
+		return t != end() && t->mask == mask ? t->value : T(0);
+	}
+	
+	//! Set the coefficient of a blade.
+	void set(unsigned int mask, T value)
+	{
+		assert((mask & ~_algebra->pseudoScalar()) == 0);
+		
+		Term *t = const_cast<Term *>(find(mask));
+		if (t != end() && t->mask == mask)
+		{
+			t->value = value;
+			return;
+		}
+		
+		const int at = int(t - _terms);
+		reserve(_count + 1);
+		std::copy_backward(_terms + at, _terms + _count, _terms + _count + 1);
+		_terms[at] = Term{mask, value};
+		_count++;
+	}
+	
+	//! Add a single GA object.
+	template<GABasis I>
+	GARuntimeTuple &operator+=(GA<I, T> in_g)
+	{
+		set(I, (*this)[I] + in_g());
+		return *this;
+	}
+	
+	//! Make room for count terms, keeping the current ones.
+	void reserve(int count)
+	{
+		if (count <= _capacity)
+			return;
+		
+		const int capacity = std::max(count, 2 * _capacity);
+		Term *terms;
+		std::unique_ptr<Term[]> heap;
+		if (_arena)
+			terms = _arena->allocate<Term>(capacity);
+		else
+			terms = (heap.reset(new Term[capacity]), heap.get());
+		
+		std::copy(begin(), end(), terms);
+		_heap = std::move(heap);
+		_terms = terms;
+		_capacity = capacity;
+	}
+	
+	//! Zero, keeping the storage.
+	void clear() { _count = 0; }
+	
+	int size() const { return _count; }
+	const Term *begin() const { return _terms; }
+	const Term *end() const { return _terms + _count; }
+	
+	const GARuntimeAlgebra &algebra() const { return *_algebra; }
+	GAArena *arena() const { return _arena; }
+	
+	//! Storage for the kernels: reserve(), write data()[0...count) sorted by mask, then resize(count).
+	Term *data() { return _terms; }
+	void resize(int count) { assert(count <= _capacity); _count = count; }
+	
+private:
+	//! First term whose mask is not below mask.
+	const Term *find(unsigned int mask) const
+	{
+		return std::lower_bound(begin(), end(), mask, [](const Term &t, unsigned int m) { return t.mask < m; });
+	}
+	
+	const GARuntimeAlgebra *_algebra;
+	GAArena *_arena;
+	std::unique_ptr<Term[]> _heap;
+	Term *_terms = _inline;
+	int _count = 0;
+	int _capacity = LGA_RUNTIME_INLINE;
+	Term _inline[LGA_RUNTIME_INLINE];
+};
+
+
+//! Kernel of the narrow algebras, accumulates every blade of the algebra on the stack.
+/*!	The signs come from table when there is one, else from the algebra. */
+template<class OP, class T>
+void GARuntimeMultiplyDense(GARuntimeTuple<T> &out, const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right, const signed char *table)
+{
+	const GARuntimeAlgebra &algebra = left.algebra();
+	const int dimension = algebra.dimension();
+	const unsigned int n = algebra.pseudoScalar() + 1;
+	
+	T sum[1 << LGA_RUNTIME_DENSE_BITS];
+	std::fill(sum, sum + n, T(0));
+	
+	// The pairs that do not contribute add zero, no branch.
+	for (const auto &l : left)
+	{
+		if (table)
+		{
+			const signed char *row = table + (l.mask << dimension);
+			for (const auto &r : right)
+				sum[l.mask ^ r.mask] += T(row[r.mask]) * (l.value * r.value);
+		}
+		else
+		{
+			for (const auto &r : right)
+				sum[l.mask ^ r.mask] += T(algebra.template sign<OP>(l.mask, r.mask)) * (l.value * r.value);
+		}
+	}
+	
+	out.clear();
+	out.reserve((int)std::min<long>(n, (long)left.size() * right.size()));
+	auto *terms = out.data();
+	int count = 0;
+	for (unsigned int m=0; m<n; m++)
+		if (sum[m] != T(0))
+			terms[count++] = GARuntimeTerm<T>{m, sum[m]};
+	out.resize(count);
+}
+
+
+//! Sorts count terms by mask, 8 bits per pass, moving them between terms and scratch.
+/*!	On return terms points to the sorted terms. */
+template<class T>
+void GARuntimeRadixSort(GARuntimeTerm<T> *&terms, GARuntimeTerm<T> *&scratch, int count, int bits)
+{
+	for (int shift=0; shift<bits; shift += 8)
+	{
+		int offset[257] = {0};
+		for (int i=0; i<count; i++)
+			offset[((terms[i].mask >> shift) & 0xFF) + 1]++;
+		for (int d=1; d<257; d++)
+			offset[d] += offset[d-1];
+		
+		for (int i=0; i<count; i++)
+			scratch[offset[(terms[i].mask >> shift) & 0xFF]++] = terms[i];
+		std::swap(terms, scratch);
+	}
+}
+
+
+//! Kernel of the wide algebras, writes every contributing pair then sorts and merges.
+template<class OP, class T>
+void GARuntimeMultiplySorted(GARuntimeTuple<T> &out, const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right)
+{
+	const GARuntimeAlgebra &algebra = left.algebra();
+	const int pairs = left.size() * right.size();
+	
+	out.clear();
+	out.reserve(2 * pairs);
+	GARuntimeTerm<T> *terms = out.data();
+	GARuntimeTerm<T> *scratch = terms + pairs;
+	int count = 0;
+	for (const auto &l : left)
+		for (const auto &r : right)
+		{
+			const int sign = algebra.template sign<OP>(l.mask, r.mask);
+			if (sign != 0)
+				terms[count++] = GARuntimeTerm<T>{l.mask ^ r.mask, T(sign) * (l.value * r.value)};
+		}
+	
+	GARuntimeRadixSort(terms, scratch, count, algebra.dimension());
+	
+	// Merge into the start of out (the sorted terms are there, or after it).
+	GARuntimeTerm<T> *merged = out.data();
+	int size = 0;
+	for (int i=0; i<count; i++)
+	{
+		if (size > 0 && merged[size-1].mask == terms[i].mask)
+			merged[size-1].value += terms[i].value;
+		else
+			merged[size++] = terms[i];
+	}
+	out.resize(size);
+}
+
+
+//! out = left OP right, in the algebra of left and right.
+/*!	out must not be left or right.  Does not allocate once out has room for
+	the result (twice the product of the sizes above LGA_RUNTIME_DENSE_BITS).
+ */
+template<class OP, class T>
+void GARuntimeMultiply(GARuntimeTuple<T> &out, const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right)
+{
+	assert(&out != &left && &out != &right);
+	assert(&left.algebra() == &right.algebra() && &out.algebra() == &left.algebra());
+	
+	if (left.algebra().dimension() <= LGA_RUNTIME_DENSE_BITS)
+		GARuntimeMultiplyDense<OP>(out, left, right, left.algebra().template table<OP>());
+	else
+		GARuntimeMultiplySorted<OP>(out, left, right);
+}
+
+
+//! out = left + sign * right, merging the sorted terms.
+template<class T>
+void GARuntimeAdd(GARuntimeTuple<T> &out, const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right, T sign = T(1))
+{
+	assert(&out != &left && &out != &right);
+	assert(&left.algebra() == &right.algebra() && &out.algebra() == &left.algebra());
+	
+	out.clear();
+	out.reserve(left.size() + right.size());
+	auto *terms = out.data();
+	int count = 0;
+	
+	const auto *l = left.begin(), *r = right.begin();
+	while (l != left.end() || r != right.end())
+	{
+		if (r == right.end() || (l != left.end() && l->mask < r->mask))
+			terms[count++] = *l++;
+		else if (l == left.end() || r->mask < l->mask)
+			terms[count++] = GARuntimeTerm<T>{r->mask, sign * r->value}, r++;
+		else
+			terms[count++] = GARuntimeTerm<T>{l->mask, l->value + sign * r->value}, l++, r++;
+	}
+	out.resize(count);
+}
+
+
+//! Runs a product into a new tuple, in the arena of left.
+template<class OP, class T>
+GARuntimeTuple<T> GARuntimeProduct(const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right)
+{
+	GARuntimeTuple<T> toRet(left.algebra(), left.arena());
+	GARuntimeMultiply<OP>(toRet, left, right);
+	return toRet;
+}
+
+//! The geometric product.
+template<class T>
+GARuntimeTuple<T> operator|(const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right)
+{ return GARuntimeProduct<GA_GeometricProduct>(left, right); }
+
+//! The outer product.
+template<class T>
+GARuntimeTuple<T> operator^(const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right)
+{ return GARuntimeProduct<GA_OuterProduct>(left, right); }
+
+//! The inner product (left contraction).
+template<class T>
+GARuntimeTuple<T> operator*(const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right)
+{ return GARuntimeProduct<GA_InnerProduct>(left, right); }
+
+template<class T>
+GARuntimeTuple<T> LeftContraction(const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right)
+{ return GARuntimeProduct<GA_LeftContraction>(left, right); }
+
+template<class T>
+GARuntimeTuple<T> RightContraction(const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right)
+{ return GARuntimeProduct<GA_RightContraction>(left, right); }
+
+template<class T>
+GARuntimeTuple<T> ScalarProduct(const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right)
+{ return GARuntimeProduct<GA_ScalarProduct>(left, right); }
+
+template<class T>
+GARuntimeTuple<T> operator+(const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right)
+{
+	GARuntimeTuple<T> toRet(left.algebra(), left.arena());
+	GARuntimeAdd(toRet, left, right);
+	return toRet;
+}
+
+template<class T>
+GARuntimeTuple<T> operator-(const GARuntimeTuple<T> &left, const GARuntimeTuple<T> &right)
+{
+	GARuntimeTuple<T> toRet(left.algebra(), left.arena());
+	GARuntimeAdd(toRet, left, right, T(-1));
+	return toRet;
+}
@@ -0,0 +1,672 @@
+#pragma once//
+
+#include "LMultivector.h"
+
+/*!	@file	LMultivector_SIMD.h		SIMD products for the 3D and 4D algebras
+	
+	Almost every tuple product is done within GATuple<e1^e2^e3> (8 floats) or
+	the homogeneous GATuple<e1^e2^e3^e4> (16 floats).  Those fit exactly in
+	SIMD registers, so the product of a tuple by a tuple is rewritten as:
+	
+	@code
+		for each blade i of l:
+			o[k] += l[i] * sign(i, i^k) * r[i^k]		// for every k at once
+	@endcode
+	
+	The r[i^k] is a shuffle of the register holding r, and sign(i, i^k) is a
+	pair of masks: one to flip the sign, one to drop the terms the operation
+	does not keep (outer and inner products).  The masks come from the same
+	OP::sign() as the Cayley tables, so any operation is supported.
+	
+	The levels are AVX-512 (one 16 float register), AVX2 + FMA (two 8 float
+	registers), SSE4.1 (four 4 float registers) or the portable Cayley table
+	code.  Every level is compiled (the ISA is enabled per function), and the
+	widest one the CPU supports is picked once, the first time it is needed,
+	among the levels where lga_bench measured the kernel faster than the
+	portable code (see GASIMDWins).  The same dispatch is used by the batch
+	kernels (see GADispatch).
+	
+	The LGA_ISA environment variable pins a level (scalar, sse4.1, avx2 or
+	avx512), which is useful when benchmarking.  A level the CPU does not
+	support falls back to the best one it does.
+	
+	Define LGA_NO_DISPATCH to only use the level enabled by the compiler
+	flags, LGA_SIMD_LEVEL to force that level, or LGA_NO_SIMD to disable the
+	SIMD code altogether.
+ */
+
+
+#define LGA_SIMD_SCALAR		0
+#define LGA_SIMD_SSE41		1
+#define LGA_SIMD_AVX2		2
+#define LGA_SIMD_AVX512		3
+
+
+#if !defined(LGA_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	//! The SIMD kernels are available (their ISA is enabled per function)
+	#define LGA_SIMD_X86	1
+	#define LGA_TARGET(x)	__attribute__((target(x)))
+	#define LGA_UNROLL		_Pragma("GCC unroll 16")
+	#define LGA_FLATTEN		__attribute__((flatten))
+	
+	#include <immintrin.h>
+#else
+	#define LGA_FLATTEN
+#endif
+
+#include <atomic>
+#include <cstdlib>
+
+
+#ifndef LGA_SIMD_LEVEL
+	#if !defined(LGA_SIMD_X86)
+		#define LGA_SIMD_LEVEL	LGA_SIMD_SCALAR
+	#elif defined(__AVX512F__)
+		#define LGA_SIMD_LEVEL	LGA_SIMD_AVX512
+	#elif defined(__AVX2__) && defined(__FMA__)
+		#define LGA_SIMD_LEVEL	LGA_SIMD_AVX2
+	#elif defined(__SSE4_1__)
+		#define LGA_SIMD_LEVEL	LGA_SIMD_SSE41
+	#else
+		#define LGA_SIMD_LEVEL	LGA_SIMD_SCALAR
+	#endif
+#endif
+
+
+//! Best level supported by the running CPU.
+inline int GASIMDDetect()
+{
+#ifdef LGA_SIMD_X86
+	__builtin_cpu_init();
+	
+	if (__builtin_cpu_supports("avx512f"))
+		return LGA_SIMD_AVX512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return LGA_SIMD_AVX2;
+	if (__builtin_cpu_supports("sse4.1"))
+		return LGA_SIMD_SSE41;
+#endif
+	return LGA_SIMD_SCALAR;
+}
+
+
+//! Level requested through the LGA_ISA environment variable, -1 if none.
+inline int GASIMDRequested()
+{
+	const char *isa = getenv("LGA_ISA");
+	if (isa == nullptr)
+		return -1;
+	
+	if (strcmp(isa, "scalar") == 0)
+		return LGA_SIMD_SCALAR;
+	if (strcmp(isa, "sse4.1") == 0 || strcmp(isa, "sse") == 0)
+		return LGA_SIMD_SSE41;
+	if (strcmp(isa, "avx2") == 0)
+		return LGA_SIMD_AVX2;
+	if (strcmp(isa, "avx512") == 0)
+		return LGA_SIMD_AVX512;
+	return -1;
+}
+
+
+//! Level used by the dispatched kernels, worked out once.
+inline int GASIMDRuntimeLevel()
+{
+	static const int level = []()
+	{
+		const int detected = GASIMDDetect();
+		const int requested = GASIMDRequested();
+		
+		return (requested >= 0 && requested < detected) ? requested : detected;
+	}();
+	
+	return level;
+}
+
+
+//! Level the dispatched kernels run at, GASIMDRuntimeLevel() unless lowered.
+inline std::atomic<int> &GASIMDActiveLevel()
+{
+	static std::atomic<int> level(GASIMDRuntimeLevel());
+	return level;
+}
+
+
+//! Run the dispatched kernels at another level (at most GASIMDRuntimeLevel()).
+/*!	lga_bench runs every benchmark at LGA_SIMD_SCALAR as well, to report
+	both.  Kernels already running on other threads see the change late. */
+inline void GASIMDSetLevel(int in_level)
+{
+	const int widest = GASIMDRuntimeLevel();
+	GASIMDActiveLevel().store(in_level < widest ? in_level : widest, std::memory_order_relaxed);
+}
+
+
+//! Whether KERNEL compiled for LEVEL beats its portable version.
+/*!	A kernel only runs at the levels lga_bench measured faster than
+	LGA_SIMD_SCALAR (a tie stays scalar), so each header specializes this
+	for its own kernels next to them.  Above the CPU level, or where the
+	kernel loses, the next level below that wins is used.
+ */
+template<class KERNEL, int LEVEL>
+struct GASIMDWins : public std::false_type
+{};
+
+
+//! Widest level up to in_level where KERNEL wins, LGA_SIMD_SCALAR if none.
+template<class KERNEL>
+constexpr int GASIMDBest(int in_level)
+{
+	return (in_level >= LGA_SIMD_AVX512 && GASIMDWins<KERNEL, LGA_SIMD_AVX512>::value) ? LGA_SIMD_AVX512 :
+		(in_level >= LGA_SIMD_AVX2 && GASIMDWins<KERNEL, LGA_SIMD_AVX2>::value) ? LGA_SIMD_AVX2 :
+		(in_level >= LGA_SIMD_SSE41 && GASIMDWins<KERNEL, LGA_SIMD_SSE41>::value) ? LGA_SIMD_SSE41 :
+		LGA_SIMD_SCALAR;
+}
+
+
+//! Shuffle masks and sign masks for a product within a D dimensional algebra.
+template<int D>
+struct GASIMDMasks
+{
+	//! r[i^k] within the register, for every blade i.
+	alignas(64) int index[1 << D][1 << D];
+	
+	//! 0x80000000 where sign(i, i^k) is negative.
+	alignas(64) unsigned int sign[1 << D][1 << D];
+	
+	//! 0xFFFFFFFF where sign(i, i^k) is not zero.
+	alignas(64) unsigned int keep[1 << D][1 << D];
+	
+	//! Bit k is set where sign(i, i^k) is not zero (AVX-512 masks).
+	unsigned int lanes[1 << D];
+	
+	//! Every pair contributes (the keep masks can be skipped).
+	bool full;
+};
+
+
+//! Build the masks of OP within a D dimensional algebra.
+template<class OP, int D>
+constexpr GASIMDMasks<D> GASIMDMasksBuild()
+{
+	GASIMDMasks<D> t{};
+	t.full = true;
+	
+	for (int i=0; i < (1 << D); i++)
+	{
+		for (int k=0; k < (1 << D); k++)
+		{
+			const int sign = OP::sign(GABasis(i), GABasis(i^k));
+			
+			t.index[i][k] = i ^ k;
+			t.sign[i][k] = sign < 0 ? 0x80000000u : 0u;
+			t.keep[i][k] = sign != 0 ? 0xFFFFFFFFu : 0u;
+			
+			if (sign != 0)
+				t.lanes[i] |= 1u << k;
+			else
+				t.full = false;
+		}
+	}
+	
+	return t;
+}
+
+
+template<class OP, int D>
+struct GASIMDTable
+{
+	static constexpr GASIMDMasks<D> value = GASIMDMasksBuild<OP, D>();
+};
+
+template<class OP, int D>
+constexpr GASIMDMasks<D> GASIMDTable<OP, D>::value;
+
+
+//! pshufb masks to pick lane (j ^ k) of a 4 float register for lane k.
+struct GASIMDShuffle
+{
+	alignas(16) unsigned char byte[4][16];
+};
+
+
+constexpr GASIMDShuffle GASIMDShuffleBuild()
+{
+	GASIMDShuffle t{};
+	for (int j=0; j<4; j++)
+		for (int k=0; k<4; k++)
+			for (int b=0; b<4; b++)
+				t.byte[j][4*k + b] = (unsigned char)(4*(j ^ k) + b);
+	return t;
+}
+
+
+template<int UNUSED = 0>
+struct GASIMDShuffleTable
+{
+	static constexpr GASIMDShuffle value = GASIMDShuffleBuild();
+};
+
+template<int UNUSED>
+constexpr GASIMDShuffle GASIMDShuffleTable<UNUSED>::value;
+
+
+//! Products of 2^D blades, one implementation per instruction set.
+/*!	Every kernel writes l OP r into o.  The operand r is loaded before
+	anything is written, and o is only written at the end, so o may alias
+	either operand.  The products are summed in several chains of registers
+	that start at zero, so o is never read back.
+ */
+template<class OP, int D>
+struct GASIMDKernel
+{
+	typedef GASIMDTable<OP, D> Table;
+	
+	static constexpr int n = 1 << D;
+	
+	//! Accumulators per register of the result, so the adds do not wait on each other.
+	static constexpr int chains(int B) { return B >= 8 ? 1 : (B >= 2 ? 8 / B : 4); }
+	
+	
+	//! Portable version, runs the Cayley table.
+	static void Scalar(float *o, const float *l, const float *r)
+	{
+		float toRet[n] = {0};
+		
+		GAProduct<GADenseBlades<GABasis(n-1)>, GADenseBlades<GABasis(n-1)>, GADenseBlades<GABasis(n-1)>, OP>(toRet, l, r);
+		
+		for (int k=0; k<n; k++)
+			o[k] = toRet[k];
+	}
+
+
+#ifdef LGA_SIMD_X86
+	//! 4 floats per register, the shuffles are pshufb within each register.
+	LGA_TARGET("sse4.1")
+	static void SSE41(float *o, const float *l, const float *r)
+	{
+		static_assert(D >= 2, "SSE4.1 kernel needs at least 4 blades");
+		
+		constexpr int B = n / 4;
+		constexpr int K = chains(B);
+		const GASIMDMasks<D> &t = Table::value;
+		
+		__m128 rv[B];
+		__m128 acc[K][B];
+		LGA_UNROLL
+		for (int b=0; b<B; b++)
+		{
+			rv[b] = _mm_loadu_ps(r + 4*b);
+			LGA_UNROLL
+			for (int c=0; c<K; c++)
+				acc[c][b] = _mm_setzero_ps();
+		}
+		
+		LGA_UNROLL
+		for (int i=0; i<n; i++)
+		{
+			if (t.lanes[i] == 0)
+				continue;
+			
+			const __m128 li = _mm_set1_ps(l[i]);
+			const __m128i sh = _mm_load_si128((const __m128i*)GASIMDShuffleTable<>::value.byte[i & 3]);
+			
+			LGA_UNROLL
+			for (int b=0; b<B; b++)
+			{
+				if (((t.lanes[i] >> (4*b)) & 0xF) == 0)
+					continue;
+				
+				__m128i v = _mm_shuffle_epi8(_mm_castps_si128(rv[(i >> 2) ^ b]), sh);
+				if (!t.full)
+					v = _mm_and_si128(v, _mm_load_si128((const __m128i*)&t.keep[i][4*b]));
+				v = _mm_xor_si128(v, _mm_load_si128((const __m128i*)&t.sign[i][4*b]));
+				
+				acc[i % K][b] = _mm_add_ps(acc[i % K][b], _mm_mul_ps(li, _mm_castsi128_ps(v)));
+			}
+		}
+		
+		LGA_UNROLL
+		for (int b=0; b<B; b++)
+		{
+			__m128 sum = acc[0][b];
+			LGA_UNROLL
+			for (int c=1; c<K; c++)
+				sum = _mm_add_ps(sum, acc[c][b]);
+			_mm_storeu_ps(o + 4*b, sum);
+		}
+	}
+	
+	
+	//! 8 floats per register, the shuffles are vpermps.
+	LGA_TARGET("avx2,fma")
+	static void AVX2(float *o, const float *l, const float *r)
+	{
+		static_assert(D >= 3, "AVX2 kernel needs at least 8 blades");
+		
+		constexpr int B = n / 8;
+		constexpr int K = chains(B);
+		const GASIMDMasks<D> &t = Table::value;
+		
+		__m256 rv[B];
+		__m256 acc[K][B];
+		LGA_UNROLL
+		for (int b=0; b<B; b++)
+		{
+			rv[b] = _mm256_loadu_ps(r + 8*b);
+			LGA_UNROLL
+			for (int c=0; c<K; c++)
+				acc[c][b] = _mm256_setzero_ps();
+		}
+		
+		LGA_UNROLL
+		for (int i=0; i<n; i++)
+		{
+			LGA_UNROLL
+			for (int b=0; b<B; b++)
+			{
+				if (((t.lanes[i] >> (8*b)) & 0xFF) == 0)
+					continue;
+				
+				// vpermps only looks at the low 3 bits of the index (i^k).
+				const __m256 li = _mm256_set1_ps(l[i]);
+				const __m256i ix = _mm256_load_si256((const __m256i*)&t.index[i][8*b]);
+				__m256i v = _mm256_castps_si256(_mm256_permutevar8x32_ps(rv[(i >> 3) ^ b], ix));
+				if (!t.full)
+					v = _mm256_and_si256(v, _mm256_load_si256((const __m256i*)&t.keep[i][8*b]));
+				v = _mm256_xor_si256(v, _mm256_load_si256((const __m256i*)&t.sign[i][8*b]));
+				
+				acc[i % K][b] = _mm256_fmadd_ps(li, _mm256_castsi256_ps(v), acc[i % K][b]);
+			}
+		}
+		
+		LGA_UNROLL
+		for (int b=0; b<B; b++)
+		{
+			__m256 sum = acc[0][b];
+			LGA_UNROLL
+			for (int c=1; c<K; c++)
+				sum = _mm256_add_ps(sum, acc[c][b]);
+			_mm256_storeu_ps(o + 8*b, sum);
+		}
+	}
+	
+	
+	//! 16 floats per register, the shuffles are vpermps and the dropped
+	//! terms are masked out of the fused multiply-add.
+	LGA_TARGET("avx512f")
+	static void AVX512(float *o, const float *l, const float *r)
+	{
+		static_assert(D >= 4, "AVX-512 kernel needs at least 16 blades");
+		
+		constexpr int B = n / 16;
+		constexpr int K = chains(B);
+		const GASIMDMasks<D> &t = Table::value;
+		
+		__m512 rv[B];
+		__m512 acc[K][B];
+		LGA_UNROLL
+		for (int b=0; b<B; b++)
+		{
+			rv[b] = _mm512_loadu_ps(r + 16*b);
+			LGA_UNROLL
+			for (int c=0; c<K; c++)
+				acc[c][b] = _mm512_setzero_ps();
+		}
+		
+		LGA_UNROLL
+		for (int i=0; i<n; i++)
+		{
+			LGA_UNROLL
+			for (int b=0; b<B; b++)
+			{
+				const __mmask16 k = (__mmask16)(t.lanes[i] >> (16*b));
+				if (k == 0)
+					continue;
+				
+				const __m512 li = _mm512_set1_ps(l[i]);
+				const __m512i ix = _mm512_load_si512((const void*)&t.index[i][16*b]);
+				// Same as _mm512_permutexvar_ps, which trips -Wuninitialized on GCC 12.
+				const __m512 src = rv[(i >> 4) ^ b];
+				__m512i v = _mm512_castps_si512(_mm512_mask_permutexvar_ps(src, (__mmask16)0xFFFF, ix, src));
+				v = _mm512_xor_si512(v, _mm512_load_si512((const void*)&t.sign[i][16*b]));
+				
+				acc[i % K][b] = _mm512_mask3_fmadd_ps(li, _mm512_castsi512_ps(v), acc[i % K][b], k);
+			}
+		}
+		
+		LGA_UNROLL
+		for (int b=0; b<B; b++)
+		{
+			__m512 sum = acc[0][b];
+			LGA_UNROLL
+			for (int c=1; c<K; c++)
+				sum = _mm512_add_ps(sum, acc[c][b]);
+			_mm512_storeu_ps(o + 16*b, sum);
+		}
+	}
+#endif
+	
+	
+	//! Widest level that fits the algebra (a 3D tuple is a single AVX2 register).
+	static constexpr int widest = D >= 4 ? LGA_SIMD_AVX512 : (D == 3 ? LGA_SIMD_AVX2 : LGA_SIMD_SSE41);
+	
+	//! Level enabled by the compiler flags.
+	static constexpr int level = LGA_SIMD_LEVEL < widest ? LGA_SIMD_LEVEL : widest;
+	
+	//! Level run when the compiler flags pick it (the widest that wins).
+	static constexpr int best = GASIMDBest<GASIMDKernel>(level);
+	
+	
+	typedef void (*Function)(float *o, const float *l, const float *r);
+	
+	//! Kernel of a level, or of the widest one below it that wins.
+	static Function select(int in_level)
+	{
+		switch (GASIMDBest<GASIMDKernel>(in_level < widest ? in_level : widest))
+		{
+#ifdef LGA_SIMD_X86
+			case LGA_SIMD_AVX512:	return kernel(std::integral_constant<int, widest>());
+			case LGA_SIMD_AVX2:		return kernel(std::integral_constant<int, LGA_SIMD_AVX2 < widest ? LGA_SIMD_AVX2 : widest>());
+			case LGA_SIMD_SSE41:	return kernel(std::integral_constant<int, LGA_SIMD_SSE41>());
+#endif
+			default:				return &Scalar;
+		}
+	}
+	
+	
+	//! Best kernel for the running CPU.
+	/*!	When the compiler flags already enable the widest kernel, it is
+		called directly. */
+	static void apply(float *o, const float *l, const float *r)
+	{
+#if defined(LGA_SIMD_X86) && !defined(LGA_NO_DISPATCH)
+		dispatch(o, l, r, std::integral_constant<bool, level == widest>());
+#else
+		run(o, l, r, std::integral_constant<int, best>());
+#endif
+	}
+	
+	
+	//! apply() runs one of the SIMD kernels, rather than Scalar.
+	static bool vectorized()
+	{
+#if defined(LGA_SIMD_X86) && !defined(LGA_NO_DISPATCH)
+		return vectorized(std::integral_constant<bool, level == widest>());
+#else
+		return best != LGA_SIMD_SCALAR;
+#endif
+	}
+	
+	
+private:
+	static bool vectorized(std::true_type) { return best != LGA_SIMD_SCALAR; }
+	
+	static bool vectorized(std::false_type)
+	{
+		static const bool v[] = { select(LGA_SIMD_SCALAR) != &Scalar, select(LGA_SIMD_SSE41) != &Scalar,
+								  select(LGA_SIMD_AVX2) != &Scalar, select(LGA_SIMD_AVX512) != &Scalar };
+		return v[GASIMDActiveLevel().load(std::memory_order_relaxed)];
+	}
+	
+	static Function kernel(std::integral_constant<int, LGA_SIMD_SCALAR>) { return &Scalar; }
+	
+#ifdef LGA_SIMD_X86
+	static Function kernel(std::integral_constant<int, LGA_SIMD_SSE41>) { return &SSE41; }
+	static Function kernel(std::integral_constant<int, LGA_SIMD_AVX2>) { return &AVX2; }
+	static Function kernel(std::integral_constant<int, LGA_SIMD_AVX512>) { return &AVX512; }
+#endif
+	
+	static void dispatch(float *o, const float *l, const float *r, std::true_type)
+	{ run(o, l, r, std::integral_constant<int, best>()); }
+	
+	static void dispatch(float *o, const float *l, const float *r, std::false_type)
+	{
+		static const Function f[] = { select(LGA_SIMD_SCALAR), select(LGA_SIMD_SSE41), select(LGA_SIMD_AVX2), select(LGA_SIMD_AVX512) };
+		f[GASIMDActiveLevel().load(std::memory_order_relaxed)](o, l, r);
+	}
+	
+	static void run(float *o, const float *l, const float *r, std::integral_constant<int, LGA_SIMD_SCALAR>)
+	{ Scalar(o, l, r); }
+	
+#ifdef LGA_SIMD_X86
+	static void run(float *o, const float *l, const float *r, std::integral_constant<int, LGA_SIMD_SSE41>)
+	{ SSE41(o, l, r); }
+	
+	static void run(float *o, const float *l, const float *r, std::integral_constant<int, LGA_SIMD_AVX2>)
+	{ AVX2(o, l, r); }
+	
+	static void run(float *o, const float *l, const float *r, std::integral_constant<int, LGA_SIMD_AVX512>)
+	{ AVX512(o, l, r); }
+#endif
+};
+
+
+//! Tuple products within the 3D algebra (8 blades).
+template<class OP>
+struct GATupleKernel<OP, GABasis(e1^e2^e3), GABasis(e1^e2^e3), float>
+: public GASIMDKernel<OP, 3>
+{};
+
+
+//! Tuple products within the homogeneous 4D algebra (16 blades).
+template<class OP>
+struct GATupleKernel<OP, GABasis(e1^e2^e3^e4), GABasis(e1^e2^e3^e4), float>
+: public GASIMDKernel<OP, 4>
+{};
+
+
+//! Blocks of the tuple products over more than 4 vectors (see GAProductBlocks).
+template<class OP>
+struct GABlockKernel<GADenseBlades<GABasis(e1^e2^e3^e4)>, GADenseBlades<GABasis(e1^e2^e3^e4)>,
+					 GADenseBlades<GABasis(e1^e2^e3^e4)>, OP, float>
+{
+	static void apply(float *o, const float *l, const float *r)
+	{
+		typedef GADenseBlades<GABasis(e1^e2^e3^e4)> B;
+		
+		// The portable kernel would only add a copy to the Cayley table.
+		if (!GASIMDKernel<OP, 4>::vectorized())
+		{
+			GAProduct<B, B, B, OP>(o, l, r);
+			return;
+		}
+		
+		alignas(64) float block[16];
+		GASIMDKernel<OP, 4>::apply(block, l, r);
+		
+		for (int k=0; k<16; k++)
+			o[k] += block[k];
+	}
+};
+
+
+//! The 3D and 4D kernels beat the Cayley tables with AVX2 and AVX-512.
+template<class OP, int D>
+struct GASIMDWins<GASIMDKernel<OP, D>, LGA_SIMD_AVX2>
+: public std::true_type
+{};
+
+template<class OP, int D>
+struct GASIMDWins<GASIMDKernel<OP, D>, LGA_SIMD_AVX512>
+: public std::true_type
+{};
+
+//! With SSE4.1 only the inner products, and the outer product in 4D, win.
+template<int D>
+struct GASIMDWins<GASIMDKernel<GA_InnerProduct, D>, LGA_SIMD_SSE41>
+: public std::true_type
+{};
+
+template<>
+struct GASIMDWins<GASIMDKernel<GA_OuterProduct, 4>, LGA_SIMD_SSE41>
+: public std::true_type
+{};
+
+
+//! Run a kernel with the widest instruction set of the running CPU.
+/*!	KERNEL::run(A...) is plain C++ (usually loops over the lanes of a
+	batch).  It is compiled once per level, with that ISA enabled and
+	everything inlined into it, so the compiler vectorizes it for each
+	level.  The level is picked once (see GASIMDRuntimeLevel), and only the
+	levels where GASIMDWins<KERNEL, level> holds are used.
+ 
+	@code
+		struct Scale
+		{
+			static void run(float *o, const float *i, float s)
+			{
+				for (int n=0; n<64; n++)
+					o[n] = i[n] * s;
+			}
+		};
+		
+		GADispatch<Scale, float *, const float *, float>::apply(o, i, 2);
+	@endcode
+ */
+template<class KERNEL, class... A>
+struct GADispatch
+{
+	typedef void (*Function)(A... args);
+	
+	LGA_FLATTEN
+	static void Scalar(A... args) { KERNEL::run(args...); }
+	
+#ifdef LGA_SIMD_X86
+	LGA_TARGET("sse4.1") LGA_FLATTEN
+	static void SSE41(A... args) { KERNEL::run(args...); }
+	
+	LGA_TARGET("avx2,fma") LGA_FLATTEN
+	static void AVX2(A... args) { KERNEL::run(args...); }
+	
+	LGA_TARGET("avx512f") LGA_FLATTEN
+	static void AVX512(A... args) { KERNEL::run(args...); }
+#endif
+	
+	
+	//! Kernel compiled for a level, or for the widest one below it that wins.
+	static Function select(int in_level)
+	{
+		switch (GASIMDBest<KERNEL>(in_level))
+		{
+#ifdef LGA_SIMD_X86
+			case LGA_SIMD_AVX512:	return &AVX512;
+			case LGA_SIMD_AVX2:		return &AVX2;
+			case LGA_SIMD_SSE41:	return &SSE41;
+#endif
+			default:				return &Scalar;
+		}
+	}
+	
+	
+	//! Run the kernel for the running CPU.
+	static void apply(A... args)
+	{
+#if defined(LGA_SIMD_X86) && !defined(LGA_NO_DISPATCH)
+		static const Function f[] = { select(LGA_SIMD_SCALAR), select(LGA_SIMD_SSE41), select(LGA_SIMD_AVX2), select(LGA_SIMD_AVX512) };
+		f[GASIMDActiveLevel().load(std::memory_order_relaxed)](args...);
+#else
+		KERNEL::run(args...);
+#endif
+	}
+};
@@ -0,0 +1,308 @@
+#pragma once//
+
+#include "LMultivector.h"
+
+/*!	@file	LMultivector_Sparse.h		Multivectors that only store some blades
+	
+	A GATuple<PS> has room for every blade of its pseudo-scalar, even though
+	most of them are usually zero (a 3D point in homogeneous space has four
+	coefficients, but a GATuple<e1^e2^e3^e4> has sixteen).
+	
+	A GASparseTuple is given the exact set of blades that can be non-zero,
+	and only stores those.  Products work out the exact set of blades of the
+	result at compile time, and only evaluate the pairs of blades that
+	contribute.
+	
+	@code
+		typedef GABlades<e1, e2, e3> Vector;
+		GASparseTuple<Vector> u(GA<e1>(1) + GA<e2>(2));	// e3 is zero
+		GASparseTuple<Vector> v = GA<e3>(1);
+		
+		auto b = u ^ v;		// GASparseTuple<GABlades<e1^e2, e1^e3, e2^e3>>
+	@endcode
+ */
+
+
+//! A multivector that only stores the blades listed in BLADES
+/*!	@tparam	BLADES	A GABlades listing the blades that can be non-zero.
+	@tparam	T		The type (default float)
+ */
+template<class BLADES, class T = float>
+class GASparseTuple
+{
+public:
+	typedef BLADES Blades;
+	
+	//! Default, all zeros.
+	GASparseTuple() {}
+	
+	//! From a single GA object.
+	template<GABasis I>
+	GASparseTuple(GA<I, T> in_g)
+	{
+		*this = in_g;
+	}
+	
+	//! From another sparse tuple whose blades are all within ours.
+	template<class B2>
+	GASparseTuple(const GASparseTuple<B2, T> &in_)
+	{
+		*this += in_;
+	}
+	
+	//! Gather the blades from a dense tuple.
+	/*!	Blades that are not in PS are zero. */
+	template<GABasis PS>
+	explicit GASparseTuple(const GATuple<PS, T> &in_)
+	{
+		gather(in_, std::make_index_sequence<BLADES::count>());
+	}
+	
+	//! Scatter the blades into a dense tuple.
+	template<GABasis PS>
+	GATuple<PS, T> tuple() const
+	{
+		static_assert((BLADES::span() & ~(unsigned int)PS) == 0, "Data loss would ensue");
+		
+		GATuple<PS, T> toRet;
+		scatter(toRet, std::make_index_sequence<BLADES::count>());
+		return toRet;
+	}
+	
+	//! Fetch - use templates to force computations
+	template<GABasis I>
+	GA<I, T> at() const
+	{
+		static_assert(BLADES::find(I) >= 0, "Blade is not stored in this tuple");
+		return GA<I, T>(_data[BLADES::find(I)]);
+	}
+	
+	//! Assign - to set a value in the tuple.
+	template<GABasis I>
+	GASparseTuple<BLADES, T> &operator=(GA<I, T> in_g)
+	{
+		static_assert(BLADES::find(I) >= 0, "Blade is not stored in this tuple");
+		_data[BLADES::find(I)] = in_g();
+		return *this;
+	}
+	
+	//! Add a value
+	template<GABasis I>
+	GASparseTuple<BLADES, T> &operator+=(GA<I, T> in_g)
+	{
+		static_assert(BLADES::find(I) >= 0, "Blade is not stored in this tuple");
+		_data[BLADES::find(I)] += in_g();
+		return *this;
+	}
+	
+	//! Add another sparse tuple, whose blades must all be within ours.
+	template<class B2>
+	GASparseTuple<BLADES, T> &operator+=(const GASparseTuple<B2, T> &in_)
+	{
+		accumulate(in_, std::make_index_sequence<B2::count>());
+		return *this;
+	}
+	
+public:
+	//! Data, one coefficient per blade in BLADES (in the same order).
+	T _data[BLADES::count > 0 ? BLADES::count : 1] = {0};
+	
+private:
+	template<GABasis PS, std::size_t... I>
+	void gather(const GATuple<PS, T> &in_, std::index_sequence<I...>)
+	{
+		using expand = int[];
+		(void)expand{0, (_data[I] = GADenseBlades<PS>::find(BLADES::mask(I)) >= 0
+								  ? in_._data[BLADES::mask(I)] : T(0), 0)...};
+	}
+	
+	template<GABasis PS, std::size_t... I>
+	void scatter(GATuple<PS, T> &out_, std::index_sequence<I...>) const
+	{
+		using expand = int[];
+		(void)expand{0, (out_._data[BLADES::mask(I)] = _data[I], 0)...};
+	}
+	
+	template<class B2, std::size_t... I>
+	void accumulate(const GASparseTuple<B2, T> &in_, std::index_sequence<I...>)
+	{
+		static_assert(GAUnionBlades<BLADES, B2>::count == BLADES::count, "Data loss would ensue");
+		
+		using expand = int[];
+		(void)expand{0, (_data[BLADES::find(B2::mask(I))] += in_._data[I], 0)...};
+	}
+};
+
+
+//! Result of a product between two sparse tuples
+template<class B1, class B2, class OP, class T>
+using GASparseProduct = GASparseTuple<typename GAProductBlades<B1, B2, OP>::type, T>;
+
+
+//! Run a product between two sparse tuples.
+template<class OP, class T, class B1, class B2>
+GASparseProduct<B1, B2, OP, T> GASparseMultiply(const GASparseTuple<B1, T> &l, const GASparseTuple<B2, T> &r)
+{
+	typedef typename GAProductBlades<B1, B2, OP>::type BO;
+	
+	GASparseTuple<BO, T> toRet;
+	GAProduct<B1, B2, BO, OP>(toRet._data, l._data, r._data);
+	return toRet;
+}
+
+
+//! Geometric product of two sparse tuples.
+template<class T, class B1, class B2>
+GASparseProduct<B1, B2, GA_GeometricProduct, T> operator|(const GASparseTuple<B1, T> &l, const GASparseTuple<B2, T> &r)
+{
+	return GASparseMultiply<GA_GeometricProduct>(l, r);
+}
+
+
+//! Outer product of two sparse tuples.
+template<class T, class B1, class B2>
+GASparseProduct<B1, B2, GA_OuterProduct, T> operator^(const GASparseTuple<B1, T> &l, const GASparseTuple<B2, T> &r)
+{
+	return GASparseMultiply<GA_OuterProduct>(l, r);
+}
+
+
+//! Inner product of two sparse tuples.
+template<class T, class B1, class B2>
+GASparseProduct<B1, B2, GA_InnerProduct, T> operator*(const GASparseTuple<B1, T> &l, const GASparseTuple<B2, T> &r)
+{
+	return GASparseMultiply<GA_InnerProduct>(l, r);
+}
+
+
+//! Geometric product of a sparse tuple by a GA.
+template<class T, class B1, GABasis M2>
+GASparseProduct<B1, GABlades<M2>, GA_GeometricProduct, T> operator|(const GASparseTuple<B1, T> &l, GA<M2, T> r)
+{
+	return GASparseMultiply<GA_GeometricProduct>(l, GASparseTuple<GABlades<M2>, T>(r));
+}
+
+template<class T, class B1, GABasis M2>
+GASparseProduct<B1, GABlades<M2>, GA_OuterProduct, T> operator^(const GASparseTuple<B1, T> &l, GA<M2, T> r)
+{
+	return GASparseMultiply<GA_OuterProduct>(l, GASparseTuple<GABlades<M2>, T>(r));
+}
+
+template<class T, class B1, GABasis M2>
+GASparseProduct<B1, GABlades<M2>, GA_InnerProduct, T> operator*(const GASparseTuple<B1, T> &l, GA<M2, T> r)
+{
+	return GASparseMultiply<GA_InnerProduct>(l, GASparseTuple<GABlades<M2>, T>(r));
+}
+
+
+//! Geometric product of a GA by a sparse tuple.
+template<class T, GABasis M1, class B2>
+GASparseProduct<GABlades<M1>, B2, GA_GeometricProduct, T> operator|(GA<M1, T> l, const GASparseTuple<B2, T> &r)
+{
+	return GASparseMultiply<GA_GeometricProduct>(GASparseTuple<GABlades<M1>, T>(l), r);
+}
+
+template<class T, GABasis M1, class B2>
+GASparseProduct<GABlades<M1>, B2, GA_OuterProduct, T> operator^(GA<M1, T> l, const GASparseTuple<B2, T> &r)
+{
+	return GASparseMultiply<GA_OuterProduct>(GASparseTuple<GABlades<M1>, T>(l), r);
+}
+
+template<class T, GABasis M1, class B2>
+GASparseProduct<GABlades<M1>, B2, GA_InnerProduct, T> operator*(GA<M1, T> l, const GASparseTuple<B2, T> &r)
+{
+	return GASparseMultiply<GA_InnerProduct>(GASparseTuple<GABlades<M1>, T>(l), r);
+}
+
+
+//! Sum of two sparse tuples, stores the union of the blades.
+template<class T, class B1, class B2>
+GASparseTuple<typename GAUnionBlades<B1, B2>::type, T> operator+(const GASparseTuple<B1, T> &l, const GASparseTuple<B2, T> &r)
+{
+	GASparseTuple<typename GAUnionBlades<B1, B2>::type, T> toRet(l);
+	toRet += r;
+	return toRet;
+}
+
+
+//! Sum of a sparse tuple and a GA.
+template<class T, class B1, GABasis M2>
+GASparseTuple<typename GAUnionBlades<B1, GABlades<M2>>::type, T> operator+(const GASparseTuple<B1, T> &l, GA<M2, T> r)
+{
+	GASparseTuple<typename GAUnionBlades<B1, GABlades<M2>>::type, T> toRet(l);
+	toRet += r;
+	return toRet;
+}
+
+
+//! Sum of a GA and a sparse tuple.
+template<class T, GABasis M1, class B2>
+GASparseTuple<typename GAUnionBlades<GABlades<M1>, B2>::type, T> operator+(GA<M1, T> l, const GASparseTuple<B2, T> &r)
+{
+	GASparseTuple<typename GAUnionBlades<GABlades<M1>, B2>::type, T> toRet(r);
+	toRet += l;
+	return toRet;
+}
+
+
+//! Left contraction of two sparse tuples (same as the inner product, *)
+template<class T, class B1, class B2>
+GASparseProduct<B1, B2, GA_LeftContraction, T> LeftContraction(const GASparseTuple<B1, T> &l, const GASparseTuple<B2, T> &r)
+{
+	return GASparseMultiply<GA_LeftContraction>(l, r);
+}
+
+
+//! Right contraction of two sparse tuples
+template<class T, class B1, class B2>
+GASparseProduct<B1, B2, GA_RightContraction, T> RightContraction(const GASparseTuple<B1, T> &l, const GASparseTuple<B2, T> &r)
+{
+	return GASparseMultiply<GA_RightContraction>(l, r);
+}
+
+
+//! Scalar product of two sparse tuples
+/*!	The result only stores the scalar (or nothing, if no blade is shared). */
+template<class T, class B1, class B2>
+GASparseProduct<B1, B2, GA_ScalarProduct, T> ScalarProduct(const GASparseTuple<B1, T> &l, const GASparseTuple<B2, T> &r)
+{
+	return GASparseMultiply<GA_ScalarProduct>(l, r);
+}
+
+
+//! Utility to copy the blades of a sparse tuple that are kept by another set.
+template<class BO, class T, class B, std::size_t... I>
+GASparseTuple<BO, T> GASparseSelect(const GASparseTuple<B, T> &in_, std::index_sequence<I...>)
+{
+	GASparseTuple<BO, T> toRet;
+	
+	using expand = int[];
+	(void)expand{0, (toRet._data[I] = in_._data[B::find(BO::mask(I))], 0)...};
+	
+	return toRet;
+}
+
+
+//! Grade projection of a sparse tuple, keeps the blades of grade K.
+template<int K, class T, class B>
+GASparseTuple<typename GASelectGrade<B, K>::type, T> Grade(const GASparseTuple<B, T> &in_)
+{
+	typedef typename GASelectGrade<B, K>::type BO;
+	return GASparseSelect<BO>(in_, std::make_index_sequence<BO::count>());
+}
+
+
+//! Grade projection of a tuple, keeps the blades of grade K.
+/*!	The result only stores the blades of that grade, so products built on
+	it only evaluate the pairs that are grade K.
+ 
+	@code
+		GATuple<e1^e2^e3^e4> p = Plucker::Point(1, 2, 3);
+		auto v = Grade<1>(p);		// e1, e2, e3 and e4 only
+	@endcode
+ */
+template<int K, GABasis PS, class T>
+GASparseTuple<typename GAGradeBlades<PS, K>::type, T> Grade(const GATuple<PS, T> &in_)
+{
+	return GASparseTuple<typename GAGradeBlades<PS, K>::type, T>(in_);
+}
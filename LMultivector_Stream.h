@@ -0,0 +1,374 @@
+#pragma once//
+
+#include "LMultivector.h"
+#include "LMultivector_View.h"
+#include "LMultivector_File.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!	@file	LMultivector_Stream.h		Transform files larger than memory, chunk by chunk
+	
+	GAStream reads records from a GAStreamReader (a file or a pipe, in the
+	format of GAFileWriter), runs a transform on chunks of them, and writes
+	the results to a GAFileWriter.  The chunks come from a fixed pool, so the
+	memory used does not depend on the size of the file, and the three
+	stages run on their own threads: the next chunk is read and the last one
+	written while the current one is transformed.
+	
+	The transform is given the records of a chunk as array views, and writes
+	its results in place:
+	
+	@code
+		typedef GAGradeBlades<e1^e2^e3^e4, 1>::type Point;
+		
+		GAStreamReader<Point> in_(stdin);
+		GAFileWriter<Point> out("moved.lga");
+		
+		GAStreamStats stats = GAStream(in_, out, GAStreamEach([&](GATupleView<Point, const float> p)
+		{
+			return View(rotor | p) | reverse;
+		}));
+		
+		printf("read %.0f, transform %.0f, write %.0f records/s\n",
+			   stats.read.recordsPerSecond(), stats.transform.recordsPerSecond(), stats.write.recordsPerSecond());
+	@endcode
+ */
+
+
+//! Reads the records of a file or of a pipe, in order.
+/*!	Only AoS files are read (see GAFileLayout).  Nothing is mapped, so
+	stdin and the pipes of popen() work as well as files.
+ */
+template<class B, class T = float, class S = GAEuclidean>
+class GAStreamReader
+{
+public:
+	GAStreamReader() {}
+	
+	//! Open the file, see open().
+	explicit GAStreamReader(const char *in_path) { open(in_path); }
+	
+	//! Read from an open stream, see open().
+	explicit GAStreamReader(std::FILE *in_file) { open(in_file); }
+	
+	GAStreamReader(const GAStreamReader &) = delete;
+	GAStreamReader &operator=(const GAStreamReader &) = delete;
+	
+	~GAStreamReader() { close(); }
+	
+	//! Open the file and read its header.
+	/*!	@return		False when the file can not be read, or does not hold
+					packed records of B, as T, in the signature S.
+	 */
+	bool open(const char *in_path)
+	{
+		close();
+		
+		std::FILE *f = std::fopen(in_path, "rb");
+		return f && start(f, true);
+	}
+	
+	//! Read from an open stream (stdin, a pipe...), close() does not close it.
+	bool open(std::FILE *in_file)
+	{
+		close();
+		return in_file && start(in_file, false);
+	}
+	
+	void close()
+	{
+		if (_file && _owned)
+			std::fclose(_file);
+		_file = nullptr;
+	}
+	
+	bool is_open() const { return _file != nullptr; }
+	
+	//! Bytes from a record to the next.
+	std::size_t stride() const { return _stride; }
+	
+	//! Read up to in_count records, stride() bytes apart, into in_buffer.
+	/*!	@return		The records read, less than in_count at the end. */
+	std::size_t read(void *in_buffer, std::size_t in_count)
+	{
+		assert(_file);
+		
+		const std::size_t n = std::size_t(std::min<std::uint64_t>(in_count, _remaining));
+		const std::size_t got = n > 0 ? std::fread(in_buffer, _stride, n, _file) : 0;
+		
+		if (_known)
+			_remaining -= got;
+		
+		// A file shorter than its header says is an error, a pipe simply ends.
+		if (got < n && (std::ferror(_file) || _known))
+			_ok = false;
+		return got;
+	}
+	
+	//! No read failed, and the file had every record its header announced.
+	bool ok() const { return _ok; }
+	
+private:
+	bool start(std::FILE *in_file, bool in_owned)
+	{
+		_file = in_file;
+		_owned = in_owned;
+		
+		GAFileHeader h;
+		char masks[sizeof(std::uint32_t) * (B::count > 0 ? B::count : 1)];
+		_ok = std::fread(&h, sizeof(h), 1, _file) == 1 && GAFileHeaderValid(h) && h.layout == GAFileAoS
+			&& h.stride % sizeof(T) == 0 && std::fread(masks, sizeof(std::uint32_t), B::count, _file) == std::size_t(B::count)
+			&& GAFileHolds<B, T, S>(h, masks);
+		
+		// Skip up to the data, without seeking (pipes can not).
+		for (std::uint64_t at = sizeof(h) + sizeof(std::uint32_t) * B::count; _ok && at < h.dataOffset; at++)
+			_ok = std::fgetc(_file) != EOF;
+		
+		if (!_ok)
+		{
+			close();
+			return false;
+		}
+		
+		_stride = std::size_t(h.stride);
+		_known = h.count != GAFileUnknownCount();
+		_remaining = h.count;
+		return true;
+	}
+	
+	std::FILE *_file = nullptr;
+	bool _owned = true;
+	bool _ok = false;
+	bool _known = false;
+	std::size_t _stride = 0;
+	std::uint64_t _remaining = 0;		// Records left, GAFileUnknownCount() up to the end
+};
+
+
+//! Volume and time of a stage of GAStream.
+struct GAStreamStage
+{
+	std::uint64_t records = 0;
+	std::uint64_t bytes = 0;
+	double busy = 0;		//!< Seconds working (summed over the workers of the transform)
+	double idle = 0;		//!< Seconds waiting for a chunk
+	
+	double recordsPerSecond() const { return busy > 0 ? double(records) / busy : 0; }
+	double bytesPerSecond() const { return busy > 0 ? double(bytes) / busy : 0; }
+};
+
+
+//! What GAStream did.
+struct GAStreamStats
+{
+	GAStreamStage read, transform, write;
+	double seconds = 0;		//!< Wall time of the run
+	bool ok = true;			//!< No read or write failed
+};
+
+
+//! Sizes of GAStream.
+struct GAStreamOptions
+{
+	std::size_t chunkRecords = 1 << 16;		//!< Records per chunk
+	int chunks = 4;							//!< Chunks in the pool, bounds the memory
+	int workers = 1;						//!< Threads running the transform
+};
+
+
+//! A transform of GAStream that maps each record, out[i] = f(in_[i]).
+template<class F>
+struct GAStreamMap
+{
+	F f;
+	
+	template<class IN, class OUT>
+	void operator()(const IN &in_, const OUT &out) const
+	{
+		for (std::ptrdiff_t i=0; i<in_.size(); i++)
+			out[i] = f(in_[i]);
+	}
+};
+
+
+//! Transform each record with f, which returns anything a view can be assigned.
+template<class F>
+GAStreamMap<F> GAStreamEach(F f)
+{
+	return GAStreamMap<F>{f};
+}
+
+
+//! Read the records of in_, transform them by chunks, write the results to out.
+/*!	@param	transform	Called as transform(GATupleArrayView<BIN, const T, S> in_,
+						GATupleArrayView<BOUT, T, S> out), with out as long as
+						in_.  With several workers, it is called on different
+						chunks at the same time.
+	
+	The reader, the workers and the writer each run on a thread, and hand
+	the chunks of a pool of options.chunks over to the next stage.  The
+	results are written in the order of the records.
+ */
+template<class BIN, class BOUT, class T, class S, class F>
+GAStreamStats GAStream(GAStreamReader<BIN, T, S> &in_, GAFileWriter<BOUT, T, S> &out, F transform, const GAStreamOptions &options = GAStreamOptions())
+{
+	typedef std::chrono::steady_clock Clock;
+	enum State { Free, Read, Working, Done };
+	
+	struct Chunk
+	{
+		std::vector<T> in_, out;
+		std::size_t count = 0;
+		State state = Free;
+	};
+	
+	assert(in_.is_open() && options.chunkRecords > 0 && options.chunks > 0 && options.workers > 0);
+	
+	const std::size_t records = options.chunkRecords;
+	const std::size_t outStride = sizeof(T) * BOUT::count;
+	const std::uint64_t none = ~std::uint64_t(0);
+	
+	std::vector<Chunk> chunks(options.chunks);
+	for (Chunk &c : chunks)
+	{
+		c.in_.resize(records * in_.stride() / sizeof(T));
+		c.out.resize(records * BOUT::count);
+	}
+	
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::uint64_t end = none;		// Chunks in the run, once the reader has seen the end
+	std::uint64_t next = 0;			// Next chunk for a worker
+	bool stop = false;				// The writer failed
+	
+	GAStreamStats stats;
+	const auto start = Clock::now();
+	
+	auto seconds = [](Clock::time_point from) { return std::chrono::duration<double>(Clock::now() - from).count(); };
+	
+	std::thread reader([&]()
+	{
+		for (std::uint64_t seq=0; ; seq++)
+		{
+			Chunk &c = chunks[seq % chunks.size()];
+			
+			auto wait = Clock::now();
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				changed.wait(lock, [&]() { return c.state == Free; });
+				if (stop)
+				{
+					end = seq;
+					changed.notify_all();
+					return;
+				}
+			}
+			stats.read.idle += seconds(wait);
+			
+			auto work = Clock::now();
+			const std::size_t n = in_.read(c.in_.data(), records);
+			stats.read.busy += seconds(work);
+			stats.read.records += n;
+			stats.read.bytes += n * in_.stride();
+			
+			std::lock_guard<std::mutex> lock(mutex);
+			if (n > 0)
+			{
+				c.count = n;
+				c.state = Read;
+			}
+			if (n < records)
+				end = n > 0 ? seq + 1 : seq;
+			changed.notify_all();
+			
+			if (n < records)
+				return;
+		}
+	});
+	
+	std::vector<std::thread> workers;
+	for (int w=0; w<options.workers; w++)
+	{
+		workers.emplace_back([&]()
+		{
+			GAStreamStage local;
+			for (;;)
+			{
+				std::uint64_t seq;
+				
+				auto wait = Clock::now();
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					changed.wait(lock, [&]() { return next >= end || chunks[next % chunks.size()].state == Read; });
+					if (next >= end)
+						break;
+					
+					seq = next++;
+					chunks[seq % chunks.size()].state = Working;
+				}
+				local.idle += seconds(wait);
+				
+				Chunk &c = chunks[seq % chunks.size()];
+				
+				auto work = Clock::now();
+				transform(GATupleArrayView<BIN, const T, S>(c.in_.data(), std::ptrdiff_t(c.count), std::ptrdiff_t(in_.stride())),
+						  GATupleArrayView<BOUT, T, S>(c.out.data(), std::ptrdiff_t(c.count), std::ptrdiff_t(outStride)));
+				local.busy += seconds(work);
+				local.records += c.count;
+				local.bytes += c.count * outStride;
+				
+				std::lock_guard<std::mutex> lock(mutex);
+				c.state = Done;
+				changed.notify_all();
+			}
+			
+			std::lock_guard<std::mutex> lock(mutex);
+			stats.transform.records += local.records;
+			stats.transform.bytes += local.bytes;
+			stats.transform.busy += local.busy;
+			stats.transform.idle += local.idle;
+		});
+	}
+	
+	std::thread writer([&]()
+	{
+		for (std::uint64_t seq=0; ; seq++)
+		{
+			Chunk &c = chunks[seq % chunks.size()];
+			
+			auto wait = Clock::now();
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				changed.wait(lock, [&]() { return seq >= end || c.state == Done; });
+				if (seq >= end)
+					return;
+			}
+			stats.write.idle += seconds(wait);
+			
+			auto work = Clock::now();
+			out.write(GATupleArrayView<BOUT, T, S>(c.out.data(), std::ptrdiff_t(c.count), std::ptrdiff_t(outStride)));
+			stats.write.busy += seconds(work);
+			stats.write.records += c.count;
+			stats.write.bytes += c.count * outStride;
+			
+			std::lock_guard<std::mutex> lock(mutex);
+			c.state = Free;
+			stop = stop || !out.ok();
+			changed.notify_all();
+		}
+	});
+	
+	reader.join();
+	for (std::thread &w : workers)
+		w.join();
+	writer.join();
+	
+	stats.seconds = seconds(start);
+	stats.ok = in_.ok() && out.ok();
+	return stats;
+}
@@ -0,0 +1,965 @@
+#pragma once//
+
+#include <cmath>
+
+#include "LMultivector.h"
+#include "LMultivector_Dual.h"
+#include "LMultivector_Sparse.h"
+#include "LMultivector_Batch.h"
+
+/*!	@file	LMultivector_Versor.h		Rotors, reflections, norms and the sandwich
+	
+	A versor V moves a multivector x by the sandwich V x ~V.  Done as two
+	generic products, every blade of V | x is multiplied again by ~V, even
+	though a versor preserves grades and the other grades cancel.
+	GAVersor::Sandwich only computes the blades V | x can produce, then only
+	the grades of x.
+	
+	To move many points by the same versor, GAVersor::Matrix builds the
+	matrix of its action on the vectors once (the terms v_a v_b and v_b v_a
+	merged, see GASandwichTable), and applies it to arrays of tuples (or
+	batches).  GAVersorMatrixKernel is scalar on purpose: it has no
+	GASIMDWins, as no SIMD level beat the portable loops (AVX2 was 40%
+	slower), so GADispatch runs the portable code.
+	
+	Square, NormSquared and Normalize use the same symmetry: in x | x the
+	terms x_i x_j and x_j x_i are merged, and the scalar of x | ~x only
+	needs the squares of the coefficients.
+	
+	@code
+		auto r = Rotation<e1^e2>(0.7f);				// Within the plane e1^e2
+		GATuple<e1^e2^e3> p = r.Sandwich(GA<e1>(1.0f) + GA<e3>(2.0f));
+		
+		r.Matrix<e1^e2^e3^e4>().Transform(out, points, count);
+	@endcode
+ */
+
+
+//! Sign that reversing a blade multiplies it by.
+constexpr int GAReverseSign(const GABasis b)
+{
+	return ((GAGrade(b) * (GAGrade(b) - 1)) / 2) % 2 == 0 ? 1 : -1;
+}
+
+
+//! Utility to reverse every blade of a tuple, see Reverse.
+template<GABasis PS, class T, std::size_t... I>
+GATuple<PS, T> GAReverse(const GATuple<PS, T> &in_, std::index_sequence<I...>)
+{
+	GATuple<PS, T> toRet;
+	
+	using expand = int[];
+	(void)expand{0, (toRet._data[GADeposit(I, PS)] =
+					 GASigned<GAReverseSign(GABasis(GADeposit(I, PS)))>(in_._data[GADeposit(I, PS)]), 0)...};
+	
+	return toRet;
+}
+
+
+//! Utility to reverse every blade of a sparse tuple, see Reverse.
+template<class B, class T, std::size_t... I>
+GASparseTuple<B, T> GAReverse(const GASparseTuple<B, T> &in_, std::index_sequence<I...>)
+{
+	GASparseTuple<B, T> toRet;
+	
+	using expand = int[];
+	(void)expand{0, (toRet._data[I] = GASigned<GAReverseSign(GABasis(B::mask(I)))>(in_._data[I]), 0)...};
+	
+	return toRet;
+}
+
+
+//! Utility to reverse the storage of a blade layout.
+template<class L, class T, std::size_t... I>
+inline void GAReverse(T *o, const T *in_, std::index_sequence<I...>)
+{
+	using expand = int[];
+	(void)expand{0, (o[L::slot(I)] = GASigned<GAReverseSign(GABasis(L::mask(I)))>(in_[L::slot(I)]), 0)...};
+}
+
+
+//! The reverse, ~x, each blade has its vectors in the opposite order.
+template<GABasis PS, class T>
+GATuple<PS, T> Reverse(const GATuple<PS, T> &in_)
+{
+	return GAReverse(in_, std::make_index_sequence<1 << GAGrade(PS)>());
+}
+
+
+//! The reverse of a sparse tuple.
+template<class B, class T>
+GASparseTuple<B, T> Reverse(const GASparseTuple<B, T> &in_)
+{
+	return GAReverse(in_, std::make_index_sequence<B::count>());
+}
+
+
+//! Utility to sum the squares of a layout, see NormSquared.
+template<class L, class T, std::size_t... I>
+inline T GANormSquared(const T *in_, std::index_sequence<I...>)
+{
+	// Four partial sums, so the adds do not wait on each other.
+	T sum[4] = {T(0), T(0), T(0), T(0)};
+	
+	using expand = int[];
+	(void)expand{0, (sum[I % 4] += GASigned<GAProductMultiplyBy(GABasis(L::mask(I)), GABasis(L::mask(I))) *
+											GAReverseSign(GABasis(L::mask(I)))>(in_[L::slot(I)] * in_[L::slot(I)]), 0)...};
+	return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+
+//! The squared norm, the scalar part of x | ~x.
+/*!	Only the blades squared contribute to the scalar, so this is one
+	multiply-add per blade instead of the full product. */
+template<GABasis PS, class T>
+T NormSquared(const GATuple<PS, T> &in_)
+{
+	return GANormSquared<GADenseBlades<PS>>(in_._data, std::make_index_sequence<GADenseBlades<PS>::count>());
+}
+
+
+//! The squared norm of a sparse tuple.
+template<class B, class T>
+T NormSquared(const GASparseTuple<B, T> &in_)
+{
+	return GANormSquared<B>(in_._data, std::make_index_sequence<B::count>());
+}
+
+
+//! The norm, the square root of |x | ~x|.
+template<GABasis PS, class T>
+T Norm(const GATuple<PS, T> &in_)
+{
+	return T(std::sqrt(std::fabs(NormSquared(in_))));
+}
+
+
+template<class B, class T>
+T Norm(const GASparseTuple<B, T> &in_)
+{
+	return T(std::sqrt(std::fabs(NormSquared(in_))));
+}
+
+
+//! The reciprocal square root, 1 / sqrt(x).
+struct GA_Rsqrt
+{
+	template<class T>
+	static T apply(const T x) { return T(1) / T(std::sqrt(x)); }
+	
+	//! Every lane, in place.
+	template<class T, int N>
+	static void lanes(T (&x)[N])
+	{
+		LGA_IVDEP
+		for (int n=0; n<N; n++)
+			x[n] = apply(x[n]);
+	}
+};
+
+
+//! A fast reciprocal square root for floats, within 1e-6 of 1 / sqrt(x).
+/*!	The 12 bit estimate of the CPU (rsqrtps) refined by one Newton step,
+	without a divide or a square root.  Without the x86 SIMD code, an
+	estimate from the bits of x (within 3.5e-2) refined by three steps, as
+	two only come within 5e-6.  Other types use the
+	exact GA_Rsqrt.
+ */
+struct GA_FastRsqrt
+{
+	//! One Newton step from the estimate y.
+	template<class T>
+	static T step(const T x, const T y) { return y * (T(1.5) - T(0.5) * x * y * y); }
+	
+	static float apply(const float x)
+	{
+#ifdef LGA_SIMD_X86
+		return step(x, _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set1_ps(x))));
+#else
+		unsigned int i;
+		memcpy(&i, &x, sizeof(i));
+		i = 0x5f3759dfu - (i >> 1);
+		
+		float y;
+		memcpy(&y, &i, sizeof(y));
+		return step(x, step(x, step(x, y)));
+#endif
+	}
+	
+	template<class T>
+	static T apply(const T x) { return GA_Rsqrt::apply(x); }
+	
+	//! Every lane, in place: the estimates 4 lanes at a time, then the steps over every lane.
+	template<int N>
+	static void lanes(float (&x)[N])
+	{
+#ifdef LGA_SIMD_X86
+		alignas(64) float y[N];
+		for (int n=0; n+4<=N; n+=4)
+			_mm_storeu_ps(y + n, _mm_rsqrt_ps(_mm_loadu_ps(x + n)));
+		for (int n=N/4*4; n<N; n++)
+			y[n] = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x[n])));
+		
+		LGA_IVDEP
+		for (int n=0; n<N; n++)
+			x[n] = step(x[n], y[n]);
+#else
+		for (int n=0; n<N; n++)
+			x[n] = apply(x[n]);
+#endif
+	}
+	
+	template<class T, int N>
+	static void lanes(T (&x)[N])
+	{
+		for (int n=0; n<N; n++)
+			x[n] = apply(x[n]);
+	}
+};
+
+
+//! Utility to scale the storage of a layout, see Normalize.
+template<class L, class T, std::size_t... I>
+inline void GAScale(T *o, const T *in_, const T s, std::index_sequence<I...>)
+{
+	using expand = int[];
+	(void)expand{0, (o[L::slot(I)] = in_[L::slot(I)] * s, 0)...};
+}
+
+
+//! x scaled so |x | ~x| = 1.
+/*!	@tparam	RSQRT	GA_Rsqrt, or GA_FastRsqrt to trade some precision for speed.
+					On one tuple the sum of the squares dominates, and both
+					take about as long; on batches GA_FastRsqrt is twice as
+					fast.
+	
+	@code
+		rotor = Normalize<GA_FastRsqrt>(rotor);
+	@endcode
+ */
+template<class RSQRT = GA_Rsqrt, GABasis PS, class T>
+GATuple<PS, T> Normalize(const GATuple<PS, T> &in_)
+{
+	GATuple<PS, T> toRet;
+	GAScale<GADenseBlades<PS>>(toRet._data, in_._data, RSQRT::apply(T(std::fabs(NormSquared(in_)))),
+							   std::make_index_sequence<GADenseBlades<PS>::count>());
+	return toRet;
+}
+
+
+//! A sparse tuple scaled so |x | ~x| = 1.
+template<class RSQRT = GA_Rsqrt, class B, class T>
+GASparseTuple<B, T> Normalize(const GASparseTuple<B, T> &in_)
+{
+	GASparseTuple<B, T> toRet;
+	GAScale<B>(toRet._data, in_._data, RSQRT::apply(T(std::fabs(NormSquared(in_)))),
+			   std::make_index_sequence<B::count>());
+	return toRet;
+}
+
+
+//! Utility to add the signed square of a blade to the lanes of norm, see GANormSquaredLanes.
+template<int S, int N, class T>
+inline void GAAddSquareLanes(T (&norm)[N], const T *in_)
+{
+	LGA_IVDEP
+	for (int n=0; n<N; n++)
+		norm[n] += GASigned<S>(in_[n] * in_[n]);
+}
+
+
+//! Utility to sum the squares of a layout over the lanes of a batch, see GANormalizeKernel.
+template<class L, int N, class T, std::size_t... I>
+inline void GANormSquaredLanes(T (&norm)[N], const T (*in_)[N], std::index_sequence<I...>)
+{
+	using expand = int[];
+	(void)expand{0, (GAAddSquareLanes<GAProductMultiplyBy(GABasis(L::mask(I)), GABasis(L::mask(I))) *
+									  GAReverseSign(GABasis(L::mask(I)))>(norm, in_[L::slot(I)]), 0)...};
+}
+
+
+//! Kernel of the batch Normalize.
+template<class RSQRT>
+struct GANormalizeKernel
+{
+	template<GABasis PS, class T, int N>
+	static void run(GATupleBatch<PS, T, N> *io, std::ptrdiff_t count)
+	{
+		for (std::ptrdiff_t i=0; i<count; i++)
+		{
+			alignas(64) T norm[N] = {};
+			GANormSquaredLanes<GADenseBlades<PS>>(norm, io[i]._data, std::make_index_sequence<GADenseBlades<PS>::count>());
+			
+			LGA_IVDEP
+			for (int n=0; n<N; n++)
+				norm[n] = T(std::fabs(norm[n]));
+			RSQRT::lanes(norm);
+			
+			for (int b=0; b<=PS; b++)
+			{
+				LGA_IVDEP
+				for (int n=0; n<N; n++)
+					io[i]._data[b][n] *= norm[n];
+			}
+		}
+	}
+};
+
+
+//! The batch Normalize wins with AVX2 and AVX-512 (SSE4.1 ties the scalar code).
+template<class RSQRT>
+struct GASIMDWins<GANormalizeKernel<RSQRT>, LGA_SIMD_AVX2>
+: public std::true_type
+{};
+
+template<class RSQRT>
+struct GASIMDWins<GANormalizeKernel<RSQRT>, LGA_SIMD_AVX512>
+: public std::true_type
+{};
+
+
+//! Normalize every tuple of count batches, in place, for the running CPU.
+template<class RSQRT = GA_Rsqrt, GABasis PS, class T, int N>
+void Normalize(GATupleBatch<PS, T, N> *io, std::ptrdiff_t count)
+{
+	GADispatch<GANormalizeKernel<RSQRT>, GATupleBatch<PS, T, N> *, std::ptrdiff_t>::apply(io, count);
+}
+
+
+//! Normalize every tuple of a batch, in place.
+template<class RSQRT = GA_Rsqrt, GABasis PS, class T, int N>
+void Normalize(GATupleBatch<PS, T, N> &io)
+{
+	Normalize<RSQRT>(&io, 1);
+}
+
+
+//! Count the terms of the square of L that do not cancel.
+template<class L, class O>
+constexpr int GASquareTermCount()
+{
+	int n = 0;
+	for (int i=0; i<L::count; i++)
+	{
+		for (int j=i; j<L::count; j++)
+		{
+			const unsigned int li = L::mask(i);
+			const unsigned int lj = L::mask(j);
+			const int sign = GAProductMultiplyBy(GABasis(li), GABasis(lj)) + (i != j ? GAProductMultiplyBy(GABasis(lj), GABasis(li)) : 0);
+			
+			if (sign != 0 && O::find(li ^ lj) >= 0)
+				n++;
+		}
+	}
+	return n;
+}
+
+
+//! Build the terms of the square of L, x_i x_j and x_j x_i merged.
+template<class L, class O, int N>
+constexpr GAProductTerms<N> GASquareTermBuild()
+{
+	GAProductTerms<N> t{};
+	int n = 0;
+	for (int i=0; i<L::count; i++)
+	{
+		for (int j=i; j<L::count; j++)
+		{
+			const unsigned int li = L::mask(i);
+			const unsigned int lj = L::mask(j);
+			const int sign = GAProductMultiplyBy(GABasis(li), GABasis(lj)) + (i != j ? GAProductMultiplyBy(GABasis(lj), GABasis(li)) : 0);
+			const int o = O::find(li ^ lj);
+			
+			if (sign != 0 && o >= 0)
+			{
+				t.term[n].l = L::slot(i);
+				t.term[n].r = L::slot(j);
+				t.term[n].o = o;
+				t.term[n].sign = sign;
+				n++;
+			}
+		}
+	}
+	return t;
+}
+
+
+//! Compile-time table of x | x.
+/*!	x_i x_j and x_j x_i land on the same blade, so each pair is visited
+	once, with a sign of 2, or dropped when the blades anticommute (they
+	cancel).  About half the terms of the product.
+ */
+template<class L, class O>
+struct GASquareTable
+{
+	static constexpr int count = GASquareTermCount<L, O>();
+	
+	static constexpr GAProductTerms<count> value = GASquareTermBuild<L, O, count>();
+};
+
+template<class L, class O>
+constexpr GAProductTerms<GASquareTable<L, O>::count> GASquareTable<L, O>::value;
+
+
+template<class L, class O, class T>
+inline void GASquare(T *o, const T *x, std::true_type)
+{
+	typedef GASquareTable<L, O> TABLE;
+	GAProductApply<TABLE>(o, x, x, std::integral_constant<bool, TABLE::count <= LGA_UNROLL_LIMIT>());
+}
+
+
+//! Large dense algebras run the product, block by block.
+template<class L, class O, class T>
+inline void GASquare(T *o, const T *x, std::false_type)
+{
+	GAProduct<L, L, O, GA_GeometricProduct>(o, x, x);
+}
+
+
+//! Accumulate x | x into o.
+template<class L, class O, class T>
+inline void GASquare(T *o, const T *x)
+{
+	GASquare<L, O>(o, x, std::integral_constant<bool, !GAProductBlocked<L, L, O, GA_GeometricProduct>::value>());
+}
+
+
+//! The square, x | x, with the symmetric terms merged (see GASquareTable).
+template<GABasis PS, class T>
+GATuple<PS, T> Square(const GATuple<PS, T> &in_)
+{
+	GATuple<PS, T> toRet;
+	GASquare<GADenseBlades<PS>, GADenseBlades<PS>>(toRet._data, in_._data);
+	return toRet;
+}
+
+
+//! The square of a sparse tuple.
+template<class B, class T>
+GASparseProduct<B, B, GA_GeometricProduct, T> Square(const GASparseTuple<B, T> &in_)
+{
+	typedef typename GAProductBlades<B, B, GA_GeometricProduct>::type BO;
+	
+	GASparseTuple<BO, T> toRet;
+	GASquare<B, BO>(toRet._data, in_._data);
+	return toRet;
+}
+
+
+//! Marks the blades of a layout whose grade is even (P = 0) or odd (P = 1).
+template<class L, int P>
+struct GAParityMarks
+{
+	static constexpr unsigned int span = L::span();
+	
+	static constexpr int bound = L::count;
+	
+	template<class C>
+	static constexpr void mark(C &hit)
+	{
+		for (int i=0; i<L::count; i++)
+			if (GAGrade(GABasis(L::mask(i))) % 2 == P)
+				hit.add(L::mask(i));
+	}
+};
+
+
+//! The blades of even grade within PS (the blades of a rotor).
+template<GABasis PS>
+using GAEvenBlades = GAMaskSet<GAParityMarks<GADenseBlades<PS>, 0>>;
+
+
+//! The blades of odd grade within PS (the blades of a reflection).
+template<GABasis PS>
+using GAOddBlades = GAMaskSet<GAParityMarks<GADenseBlades<PS>, 1>>;
+
+
+//! Marks the blades within SPAN that have the grade of a blade of X.
+template<class X, unsigned int SPAN>
+struct GAGradeSetMarks
+{
+	static constexpr unsigned int span = SPAN;
+	
+	static constexpr int bound = 1 << GAGrade(GABasis(SPAN));
+	
+	template<class C>
+	static constexpr void mark(C &hit)
+	{
+		for (int i=0; i<(1 << GAGrade(GABasis(SPAN))); i++)
+			for (int k=0; k<X::count; k++)
+				if (GAGrade(GABasis(GADeposit(i, SPAN))) == GAGrade(GABasis(X::mask(k))))
+					hit.add(GADeposit(i, SPAN));
+	}
+};
+
+
+//! The blades that V x ~V can produce, those with the grades of X.
+template<class V, class X>
+using GASandwichBlades = GAMaskSet<GAGradeSetMarks<X, V::span() | X::span()>>;
+
+
+//! Accumulate the sandwich v x ~v into o.
+/*!	Run as v | x, into the exact blades it can produce, then by ~v into the
+	grades of x only: a versor preserves grades, so the other grades cancel
+	by symmetry and are never computed.
+	
+	@tparam	V	Blade layout of the versor (a GABlades)
+	@tparam	X	Blade layout of the multivector moved
+	@tparam	O	Blade layout of the result (see GASandwichBlades)
+ */
+template<class V, class X, class O, class T>
+inline void GASandwich(T *o, const T *v, const T *x)
+{
+	typedef typename GAProductBlades<V, X, GA_GeometricProduct>::type VX;
+	
+	T reverse[V::count > 0 ? V::count : 1];
+	GAReverse<V>(reverse, v, std::make_index_sequence<V::count>());
+	
+	T vx[VX::count > 0 ? VX::count : 1] = {};
+	GAProduct<V, X, VX, GA_GeometricProduct>(vx, v, x);
+	GAProduct<VX, V, O, GA_GeometricProduct>(o, vx, reverse);
+}
+
+
+//! One term of a sandwich table: out[o] += sign * v[a] * v[b] * x[x]
+struct GASandwichTerm
+{
+	int a;
+	int b;
+	int x;
+	int o;
+	int sign;
+};
+
+
+//! The terms of a sandwich table.
+template<int N>
+struct GASandwichTerms
+{
+	GASandwichTerm term[N > 0 ? N : 1];
+};
+
+
+//! Sign of the blade a x ~b, 0 unless it has the grade of x.
+/*!	A versor preserves grades, so the other grades always cancel. */
+constexpr int GASandwichSign(const GABasis a, const GABasis x, const GABasis b)
+{
+	return GAGrade(a^x^b) == GAGrade(x)
+			? GAProductMultiplyBy(a, x) * GAProductMultiplyBy(a^x, b) * GAReverseSign(b) : 0;
+}
+
+
+//! Sign of v[i] v[j] x[k] within the sandwich, both orders of i and j merged.
+template<class V, class X>
+constexpr int GASandwichPairSign(int i, int j, int k)
+{
+	return GASandwichSign(GABasis(V::mask(i)), GABasis(X::mask(k)), GABasis(V::mask(j)))
+		 + (i != j ? GASandwichSign(GABasis(V::mask(j)), GABasis(X::mask(k)), GABasis(V::mask(i))) : 0);
+}
+
+
+//! Count the terms of a sandwich that do not cancel.
+template<class V, class X, class O>
+constexpr int GASandwichTermCount()
+{
+	int n = 0;
+	for (int i=0; i<V::count; i++)
+		for (int j=i; j<V::count; j++)
+			for (int k=0; k<X::count; k++)
+				if (GASandwichPairSign<V, X>(i, j, k) != 0 && O::find(V::mask(i) ^ V::mask(j) ^ X::mask(k)) >= 0)
+					n++;
+	return n;
+}
+
+
+//! Build the terms of a sandwich that do not cancel.
+template<class V, class X, class O, int N>
+constexpr GASandwichTerms<N> GASandwichTermBuild()
+{
+	GASandwichTerms<N> t{};
+	int n = 0;
+	for (int i=0; i<V::count; i++)
+	{
+		for (int j=i; j<V::count; j++)
+		{
+			for (int k=0; k<X::count; k++)
+			{
+				const int sign = GASandwichPairSign<V, X>(i, j, k);
+				const int o = O::find(V::mask(i) ^ V::mask(j) ^ X::mask(k));
+				
+				if (sign != 0 && o >= 0)
+				{
+					t.term[n].a = V::slot(i);
+					t.term[n].b = V::slot(j);
+					t.term[n].x = X::slot(k);
+					t.term[n].o = o;
+					t.term[n].sign = sign;
+					n++;
+				}
+			}
+		}
+	}
+	return t;
+}
+
+
+//! Compile-time table of the sandwich v x ~v, as terms of v by v.
+/*!	The terms v_a v_b and v_b v_a are merged, so those that cancel by
+	symmetry are dropped.  Used to build GAVersorMatrix, where each term is
+	computed once.
+	
+	@tparam	V	Blade layout of the versor
+	@tparam	X	Blade layout of the multivector moved
+	@tparam	O	Blade layout of the result.  Terms landing outside are dropped.
+ */
+template<class V, class X, class O>
+struct GASandwichTable
+{
+	static constexpr int count = GASandwichTermCount<V, X, O>();
+	
+	static constexpr GASandwichTerms<count> value = GASandwichTermBuild<V, X, O, count>();
+};
+
+template<class V, class X, class O>
+constexpr GASandwichTerms<GASandwichTable<V, X, O>::count> GASandwichTable<V, X, O>::value;
+
+
+#ifndef LGA_SANDWICH_LIMIT
+//! Sandwiches with more triples of blades than this run each vector instead.
+#define LGA_SANDWICH_LIMIT 32768
+#endif
+
+
+//! The sandwich table of V and X can be built at compile time.
+template<class V, class X>
+struct GASandwichCompileTime
+: public std::integral_constant<bool, V::count * V::count * X::count <= LGA_SANDWICH_LIMIT>
+{};
+
+
+//! Adds the terms of V x ~V on the vectors of PS to m (see GAVersorMatrix).
+template<class V, GABasis PS, class T, int D>
+inline void GASandwichMatrix(T (*m)[D], const T *v, std::true_type)
+{
+	typedef typename GAGradeBlades<PS, 1>::type X;
+	typedef GASandwichTable<V, X, X> TABLE;
+	
+	for (int i=0; i<TABLE::count; i++)
+	{
+		const GASandwichTerm &t = TABLE::value.term[i];
+		m[t.o][t.x] += T(t.sign) * v[t.a] * v[t.b];
+	}
+}
+
+
+//! Large algebras run the sandwich of each vector instead.
+template<class V, GABasis PS, class T, int D>
+inline void GASandwichMatrix(T (*m)[D], const T *v, std::false_type)
+{
+	typedef typename GAGradeBlades<PS, 1>::type X;
+	
+	for (int c=0; c<D; c++)
+	{
+		T x[D] = {};
+		T column[D] = {};
+		x[c] = T(1);
+		
+		GASandwich<V, X, X>(column, v, x);
+		for (int r=0; r<D; r++)
+			m[r][c] += column[r];
+	}
+}
+
+
+template<GABasis PS, class T>
+class GAVersorMatrix;
+
+
+//! A versor, the product of invertible vectors (rotors, reflections...).
+/*!	@tparam	BLADES	The blades of the versor (see GARotor).
+	@tparam	T		The type (default float)
+ */
+template<class BLADES, class T = float>
+class GAVersor
+{
+public:
+	typedef BLADES Blades;
+	
+	//! The identity, 1 (or 0 when BLADES has no scalar).
+	GAVersor()
+	{
+		if (BLADES::find(scalar) >= 0)
+			_versor._data[BLADES::find(scalar)] = T(1);
+	}
+	
+	//! From its coefficients.
+	explicit GAVersor(const GASparseTuple<BLADES, T> &in_) : _versor(in_) {}
+	
+	//! From another versor whose blades are all within ours.
+	template<class B2>
+	GAVersor(const GAVersor<B2, T> &in_) : _versor(in_._versor) {}
+	
+	//! Gather the blades from a tuple.
+	template<GABasis PS>
+	explicit GAVersor(const GATuple<PS, T> &in_) : _versor(in_) {}
+	
+	//! The reverse, ~V, which undoes V when V is normalized.
+	GAVersor<BLADES, T> Reverse() const
+	{
+		return GAVersor<BLADES, T>(::Reverse(_versor));
+	}
+	
+	//! The inverse, ~V / (V ~V), which undoes V.
+	GAVersor<BLADES, T> Inverse() const
+	{
+		GASparseTuple<BLADES, T> toRet;
+		GAReverse<BLADES>(toRet._data, _versor._data, std::make_index_sequence<BLADES::count>());
+		GAScale<BLADES>(toRet._data, toRet._data, T(1) / Norm2(), std::make_index_sequence<BLADES::count>());
+		return GAVersor<BLADES, T>(toRet);
+	}
+	
+	//! The squared norm, V ~V.
+	T Norm2() const
+	{
+		return NormSquared(_versor);
+	}
+	
+	//! The versor scaled so V ~V = 1 (see Normalize for RSQRT).
+	template<class RSQRT = GA_Rsqrt>
+	GAVersor<BLADES, T> Normalized() const
+	{
+		return GAVersor<BLADES, T>(::Normalize<RSQRT>(_versor));
+	}
+	
+	//! Scale the versor so V ~V = 1.
+	template<class RSQRT = GA_Rsqrt>
+	void Normalize()
+	{
+		_versor = ::Normalize<RSQRT>(_versor);
+	}
+	
+	//! V x ~V, only the grades of x are computed (see GASandwich).
+	/*!	Every blade of the tuple is read, pass Grade<1>(x) to move a vector. */
+	template<GABasis PS>
+	GATuple<GABasis(BLADES::span() | PS), T> Sandwich(const GATuple<PS, T> &in_) const
+	{
+		typedef GADenseBlades<PS> X;
+		
+		GATuple<GABasis(BLADES::span() | PS), T> toRet;
+		GASandwich<BLADES, X, GAScatteredBlades<typename GASandwichBlades<BLADES, X>::type>>(toRet._data, _versor._data, in_._data);
+		return toRet;
+	}
+	
+	//! V x ~V of a sparse tuple.
+	template<class B>
+	GASparseTuple<typename GASandwichBlades<BLADES, B>::type, T> Sandwich(const GASparseTuple<B, T> &in_) const
+	{
+		GASparseTuple<typename GASandwichBlades<BLADES, B>::type, T> toRet;
+		GASandwich<BLADES, B, typename GASandwichBlades<BLADES, B>::type>(toRet._data, _versor._data, in_._data);
+		return toRet;
+	}
+	
+	//! V x ~V of a single blade.
+	template<GABasis I>
+	GASparseTuple<typename GASandwichBlades<BLADES, GABlades<I>>::type, T> Sandwich(GA<I, T> in_g) const
+	{
+		return Sandwich(GASparseTuple<GABlades<I>, T>(in_g));
+	}
+	
+	//! The matrix of the sandwich on the vectors of PS, see GAVersorMatrix.
+	template<GABasis PS>
+	GAVersorMatrix<PS, T> Matrix() const
+	{
+		return GAVersorMatrix<PS, T>(*this);
+	}
+	
+public:
+	//! Coefficients, one per blade in BLADES.
+	GASparseTuple<BLADES, T> _versor;
+};
+
+
+//! A rotor of PS, a versor with the blades of even grade.
+template<GABasis PS, class T = float>
+using GARotor = GAVersor<typename GAEvenBlades<PS>::type, T>;
+
+
+//! r x ~r, where r is a versor (see GAVersor::Sandwich).
+template<GABasis M1, GABasis M2, class T>
+GATuple<GABasis(M1|M2), T> Sandwich(const GATuple<M1, T> &r, const GATuple<M2, T> &x)
+{
+	return GAVersor<typename GAAllBlades<M1>::type, T>(r).Sandwich(x);
+}
+
+
+//! r x ~r, for sparse tuples.
+template<class B1, class B2, class T>
+GASparseTuple<typename GASandwichBlades<B1, B2>::type, T> Sandwich(const GASparseTuple<B1, T> &r, const GASparseTuple<B2, T> &x)
+{
+	return GAVersor<B1, T>(r).Sandwich(x);
+}
+
+
+//! The composition, moving by r then by l.
+template<class T, class B1, class B2>
+GAVersor<typename GAProductBlades<B1, B2, GA_GeometricProduct>::type, T> operator|(const GAVersor<B1, T> &l, const GAVersor<B2, T> &r)
+{
+	typedef typename GAProductBlades<B1, B2, GA_GeometricProduct>::type BO;
+	return GAVersor<BO, T>(l._versor | r._versor);
+}
+
+
+//! The rotation by angle within the plane of the unit blade B.
+/*!	Turns the first vector of B towards the second.
+	
+	@code
+		Rotation<e1^e2>(0.5f).Sandwich(GA<e1>(1.0f))	// cos(0.5) e1 + sin(0.5) e2
+	@endcode
+ */
+template<GABasis B, class T>
+GAVersor<GABlades<scalar, B>, T> Rotation(T angle)
+{
+	static_assert(GAGrade(B) == 2, "A rotation is within a plane");
+	
+	GASparseTuple<GABlades<scalar, B>, T> toRet;
+	toRet = GA<scalar, T>(T(std::cos(angle / 2)));
+	toRet = GA<B, T>(T(-std::sin(angle / 2)));
+	return GAVersor<GABlades<scalar, B>, T>(toRet);
+}
+
+
+//! Applies GAVersorMatrix to an array of tuples.
+template<GABasis PS>
+struct GAVersorMatrixKernel
+{
+	static constexpr int dim = GAGrade(PS);
+	
+	//! The i-th vector of PS.
+	static constexpr GABasis vector(int i) { return GABasis(GADeposit(1u << i, PS)); }
+	
+	template<class T>
+	static void run(GATuple<PS, T> *o, const GATuple<PS, T> *in_, const GAVersorMatrix<PS, T> *matrix, std::ptrdiff_t count)
+	{
+		T m[dim][dim];
+		for (int r=0; r<dim; r++)
+			for (int c=0; c<dim; c++)
+				m[r][c] = matrix->_m[r][c];
+		
+		for (std::ptrdiff_t i=0; i<count; i++)
+		{
+			T x[dim];
+			for (int c=0; c<dim; c++)
+				x[c] = in_[i]._data[vector(c)];
+			
+			GATuple<PS, T> toRet;
+			for (int r=0; r<dim; r++)
+			{
+				T sum = T(0);
+				for (int c=0; c<dim; c++)
+					sum += m[r][c] * x[c];
+				toRet._data[vector(r)] = sum;
+			}
+			o[i] = toRet;
+		}
+	}
+	
+	template<class T, int N>
+	static void run(GATupleBatch<PS, T, N> *o, const GATupleBatch<PS, T, N> *in_, const GAVersorMatrix<PS, T> *matrix, std::ptrdiff_t count)
+	{
+		T m[dim][dim];
+		for (int r=0; r<dim; r++)
+			for (int c=0; c<dim; c++)
+				m[r][c] = matrix->_m[r][c];
+		
+		for (std::ptrdiff_t i=0; i<count; i++)
+		{
+			alignas(64) T acc[dim][N];
+			for (int r=0; r<dim; r++)
+			{
+				for (int n=0; n<N; n++)
+					acc[r][n] = 0;
+				for (int c=0; c<dim; c++)
+				{
+					LGA_IVDEP
+					for (int n=0; n<N; n++)
+						acc[r][n] += m[r][c] * in_[i]._data[vector(c)][n];
+				}
+			}
+			
+			for (int b=0; b<=PS; b++)
+				for (int n=0; n<N; n++)
+					o[i]._data[b][n] = 0;
+			for (int r=0; r<dim; r++)
+				for (int n=0; n<N; n++)
+					o[i]._data[vector(r)][n] = acc[r][n];
+		}
+	}
+};
+
+
+//! The action of a versor on the vectors of PS, as a matrix.
+/*!	Built once from the versor (one sandwich per vector), then every point
+	costs a matrix product instead of a sandwich.  Only the vectors are
+	moved, the other blades of the result are 0.
+	
+	@code
+		const auto m = rotor.Matrix<e1^e2^e3^e4>();
+		m.Transform(out, points, count);			// out[i] = rotor.Sandwich(points[i])
+	@endcode
+ */
+template<GABasis PS, class T = float>
+class GAVersorMatrix
+{
+public:
+	static constexpr int dim = GAGrade(PS);
+	
+	//! The identity.
+	GAVersorMatrix()
+	{
+		for (int r=0; r<dim; r++)
+			for (int c=0; c<dim; c++)
+				_m[r][c] = r == c ? T(1) : T(0);
+	}
+	
+	//! The matrix of V x ~V on the vectors of PS.
+	template<class BLADES>
+	explicit GAVersorMatrix(const GAVersor<BLADES, T> &in_)
+	{
+		for (int r=0; r<dim; r++)
+			for (int c=0; c<dim; c++)
+				_m[r][c] = T(0);
+		
+		GASandwichMatrix<BLADES, PS>(_m, in_._versor._data,
+									 GASandwichCompileTime<BLADES, typename GAGradeBlades<PS, 1>::type>());
+	}
+	
+	//! Move the vectors of one tuple.
+	GATuple<PS, T> operator()(const GATuple<PS, T> &in_) const
+	{
+		GATuple<PS, T> toRet;
+		GAVersorMatrixKernel<PS>::run(&toRet, &in_, this, 1);
+		return toRet;
+	}
+	
+	//! Move count tuples, out may be in_.
+	void Transform(GATuple<PS, T> *out_, const GATuple<PS, T> *in_, std::ptrdiff_t count) const
+	{
+		typedef GATuple<PS, T> Tuple;
+		GADispatch<GAVersorMatrixKernel<PS>, Tuple *, const Tuple *, const GAVersorMatrix *, std::ptrdiff_t>
+			::apply(out_, in_, this, count);
+	}
+	
+	//! Move count batches, out may be in_.
+	template<int N>
+	void Transform(GATupleBatch<PS, T, N> *out_, const GATupleBatch<PS, T, N> *in_, std::ptrdiff_t count) const
+	{
+		typedef GATupleBatch<PS, T, N> Batch;
+		GADispatch<GAVersorMatrixKernel<PS>, Batch *, const Batch *, const GAVersorMatrix *, std::ptrdiff_t>
+			::apply(out_, in_, this, count);
+	}
+	
+public:
+	//! _m[r][c] is the r-th vector of the image of the c-th vector of PS.
+	T _m[dim > 0 ? dim : 1][dim > 0 ? dim : 1];
+};
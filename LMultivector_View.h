@@ -0,0 +1,452 @@
+#pragma once//
+
+#include "LMultivector.h"
+#include "LMultivector_Sparse.h"
+
+/*!	@file	LMultivector_View.h		Tuples read and written in place
+	
+	A GATupleView maps the coefficients of a blade layout onto memory the
+	view does not own, such as the records of an interleaved vertex buffer or
+	of an mmap'd file.  The layout is usually compact (a GABlades stores its
+	i-th blade at slot i), and a GATupleArrayView steps from record to record
+	with a stride in bytes.  GATupleView<B, const float> only reads.
+	
+	The products read the coefficients where they are (the Cayley tables of
+	GAProduct and the SIMD kernels only see the layouts), and assigning to a
+	view writes the blades of its layout back into the buffer:
+	
+	@code
+		struct Vertex { float pos[4]; float normal[3]; float uv[2]; };
+		typedef GABlades<e1, e2, e3, e4> Point;
+		
+		GATupleArrayView<Point, const float> points(&vertices[0].pos[0], count, sizeof(Vertex));
+		GATupleArrayView<Point> moved(&out[0].pos[0], count, sizeof(Vertex));
+		
+		for (int i=0; i<count; i++)
+			moved[i] = View(motor) | points[i];	// written into out, no copies
+	@endcode
+	
+	@warning	A view is a reference: copying it copies the pointer, but
+				assigning to it writes the coefficients.
+ */
+
+
+//! Some of the blades of a layout, stored where the layout stores them.
+/*!	GAScatteredBlades<B> is GASubsetBlades<GADenseBlades<PS>, B>, this one
+	also works within compact layouts.
+ */
+template<class LAYOUT, class SUB>
+struct GASubsetBlades
+{
+	static constexpr int count = SUB::count;
+	
+	static constexpr unsigned int mask(int i) { return SUB::mask(i); }
+	
+	static constexpr int slot(int i) { return LAYOUT::find(SUB::mask(i)); }
+	
+	static constexpr int find(unsigned int m)
+	{ return SUB::find(m) >= 0 ? LAYOUT::find(m) : -1; }
+	
+	static constexpr unsigned int span() { return SUB::span(); }
+};
+
+
+//! One lane of N interleaved records of the layout B (structure of arrays).
+/*!	Each slot of B is a row of N coefficients, so lane n of a block
+	is read from &block[0][n] (see GATupleBatch and GAFileReader::record).
+ */
+template<class B, int N>
+struct GALaneBlades
+{
+	static constexpr int count = B::count;
+	
+	static constexpr unsigned int mask(int i) { return B::mask(i); }
+	
+	static constexpr int slot(int i) { return B::slot(i) * N; }
+	
+	static constexpr int find(unsigned int m)
+	{ return B::find(m) >= 0 ? B::find(m) * N : -1; }
+	
+	static constexpr unsigned int span() { return B::span(); }
+};
+
+
+//! Coefficients a record of the layout B holds (its highest slot + 1).
+template<class B>
+constexpr int GAViewSlots()
+{
+	int toRet = 0;
+	for (int i=0; i<B::count; i++)
+		toRet = B::slot(i) + 1 > toRet ? B::slot(i) + 1 : toRet;
+	return toRet;
+}
+
+
+//! A tuple whose coefficients live in a buffer it does not own.
+/*!	@tparam	BLADES	The blade layout of the buffer (GABlades, GADenseBlades...)
+	@tparam	T		The type, const T for a read-only view
+	@tparam	S		The metric signature
+ */
+template<class BLADES, class T = float, class S = GAEuclidean>
+class GATupleView
+{
+public:
+	typedef BLADES Blades;
+	typedef typename std::remove_const<T>::type Type;
+	
+	//! The blade BLADES::mask(i) is at in_data[BLADES::slot(i)].
+	explicit GATupleView(T *in_data) : _data(in_data) {}
+	
+	//! Views of the same buffer, a mutable view also reads as a const one.
+	GATupleView(const GATupleView &in_) = default;
+	
+	template<class T2>
+	GATupleView(const GATupleView<BLADES, T2, S> &in_) : _data(in_.data()) {}
+	
+	//! Write the blades of the layout, those in_ does not store are 0.
+	GATupleView &operator=(const GATupleView &in_)
+	{
+		assign(in_);
+		return *this;
+	}
+	
+	template<class B2, class T2>
+	GATupleView &operator=(const GATupleView<B2, T2, S> &in_)
+	{
+		assign(in_);
+		return *this;
+	}
+	
+	template<GABasis PS>
+	GATupleView &operator=(const GATuple<PS, Type, S> &in_)
+	{
+		assign(GATupleView<GADenseBlades<PS>, const Type, S>(in_._data));
+		return *this;
+	}
+	
+	template<class B2>
+	GATupleView &operator=(const GASparseTuple<B2, Type> &in_)
+	{
+		assign(GATupleView<B2, const Type, S>(in_._data));
+		return *this;
+	}
+	
+	//! Set a single blade, the others are kept.
+	template<GABasis I>
+	GATupleView &operator=(GA<I, Type, S> in_g)
+	{
+		static_assert(BLADES::find(I) >= 0, "Blade is not stored in this view");
+		_data[BLADES::find(I)] = in_g();
+		return *this;
+	}
+	
+	//! Fetch - use templates to force computations
+	template<GABasis I>
+	GA<I, Type, S> at() const
+	{
+		static_assert(BLADES::find(I) >= 0, "Blade is not stored in this view");
+		return GA<I, Type, S>(_data[BLADES::find(I)]);
+	}
+	
+	//! Copy into a dense tuple.
+	template<GABasis PS>
+	GATuple<PS, Type, S> tuple() const
+	{
+		static_assert((BLADES::span() & ~(unsigned int)PS) == 0, "Data loss would ensue");
+		
+		GATuple<PS, Type, S> toRet;
+		for (int i=0; i<BLADES::count; i++)
+			toRet._data[BLADES::mask(i)] = _data[BLADES::slot(i)];
+		return toRet;
+	}
+	
+	//! Copy into a sparse tuple of the same blades.
+	GASparseTuple<typename GAMaskSet<GAUnionMarks<BLADES, GABlades<>>>::type, Type> sparse() const
+	{
+		typedef typename GAMaskSet<GAUnionMarks<BLADES, GABlades<>>>::type BO;
+		
+		GASparseTuple<BO, Type> toRet;
+		GATupleView<BO, Type, S>(toRet._data) = *this;
+		return toRet;
+	}
+	
+	//! The buffer, at the first coefficient of the record.
+	T *data() const { return _data; }
+	
+private:
+	template<class B2, class T2>
+	void assign(const GATupleView<B2, T2, S> &in_)
+	{
+		static_assert(!std::is_const<T>::value, "A const view can not be written");
+		
+		Type gathered[BLADES::count > 0 ? BLADES::count : 1];	// in_ may overlap the view
+		for (int i=0; i<BLADES::count; i++)
+			gathered[i] = B2::find(BLADES::mask(i)) >= 0 ? in_.data()[B2::find(BLADES::mask(i))] : Type(0);
+		for (int i=0; i<BLADES::count; i++)
+			_data[BLADES::slot(i)] = gathered[i];
+	}
+	
+	T *_data;
+};
+
+
+//! count records of the layout B, stride bytes apart.
+/*!	@code
+		// Lines stored as 6 floats, within records of 32 bytes.
+		GATupleArrayView<Plucker::LineBlades<e1^e2^e3^e4>, const float> lines(&buffer[0].line[0], count, 32);
+	@endcode
+ */
+template<class BLADES, class T = float, class S = GAEuclidean>
+class GATupleArrayView
+{
+public:
+	typedef GATupleView<BLADES, T, S> Record;
+	typedef BLADES Blades;
+	typedef typename std::remove_const<T>::type Type;
+	
+	//! The records start at in_base, the default stride packs them.
+	GATupleArrayView(T *in_base, std::ptrdiff_t in_count, std::ptrdiff_t in_stride = sizeof(T) * GAViewSlots<BLADES>())
+	: _base(in_base)
+	, _count(in_count)
+	, _stride(in_stride)
+	{}
+	
+	template<class T2>
+	GATupleArrayView(const GATupleArrayView<BLADES, T2, S> &in_)
+	: GATupleArrayView(in_.data(), in_.size(), in_.stride())
+	{}
+	
+	//! The i-th record (assign to it to write the buffer).
+	Record operator[](std::ptrdiff_t i) const
+	{
+		typedef typename std::conditional<std::is_const<T>::value, const char, char>::type Byte;
+		return Record(reinterpret_cast<T *>(reinterpret_cast<Byte *>(_base) + i * _stride));
+	}
+	
+	//! The records [in_begin, in_begin + in_count), in the same buffer.
+	GATupleArrayView slice(std::ptrdiff_t in_begin, std::ptrdiff_t in_count) const
+	{
+		assert(in_begin >= 0 && in_count >= 0 && in_begin + in_count <= _count);
+		return GATupleArrayView(operator[](in_begin).data(), in_count, _stride);
+	}
+	
+	std::ptrdiff_t size() const { return _count; }
+	std::ptrdiff_t stride() const { return _stride; }
+	T *data() const { return _base; }
+	
+private:
+	T *_base;
+	std::ptrdiff_t _count;
+	std::ptrdiff_t _stride;
+};
+
+
+//! A read-only view of a dense tuple.
+template<GABasis PS, class T, class S>
+GATupleView<GADenseBlades<PS>, const T, S> View(const GATuple<PS, T, S> &in_)
+{
+	return GATupleView<GADenseBlades<PS>, const T, S>(in_._data);
+}
+
+//! A writable view of a dense tuple.
+template<GABasis PS, class T, class S>
+GATupleView<GADenseBlades<PS>, T, S> View(GATuple<PS, T, S> &in_)
+{
+	return GATupleView<GADenseBlades<PS>, T, S>(in_._data);
+}
+
+//! A read-only view of a sparse tuple.
+template<class B, class T>
+GATupleView<B, const T> View(const GASparseTuple<B, T> &in_)
+{
+	return GATupleView<B, const T>(in_._data);
+}
+
+//! A writable view of a sparse tuple.
+template<class B, class T>
+GATupleView<B, T> View(GASparseTuple<B, T> &in_)
+{
+	return GATupleView<B, T>(in_._data);
+}
+
+//! A view read only.
+template<class B, class T, class S>
+GATupleView<B, const typename std::remove_const<T>::type, S> View(const GATupleView<B, T, S> &in_)
+{
+	return in_;
+}
+
+
+//! Product of two views of the layouts L and R.
+/*!	Two dense layouts give a GATuple through GATupleKernel (and its SIMD
+	specializations), the others a GASparseTuple of the blades L OP R can
+	produce.
+ */
+template<class L, class R, class OP, class T, class S>
+struct GAViewProduct
+{
+	typedef typename GAMetricOp<OP, S>::type MOP;
+	typedef GASparseTuple<typename GAProductBlades<L, R, MOP>::type, T> type;
+	
+	static void apply(type &o, const T *l, const T *r)
+	{
+		GAProduct<L, R, typename type::Blades, MOP>(o._data, l, r);
+	}
+};
+
+template<GABasis M1, GABasis M2, class OP, class T, class S>
+struct GAViewProduct<GADenseBlades<M1>, GADenseBlades<M2>, OP, T, S>
+{
+	typedef GATupleProduct<OP, GADenseBlades<M1>, GADenseBlades<M2>, T, S> type;
+	
+	static void apply(type &o, const T *l, const T *r)
+	{
+		GATupleKernel<typename GAMetricOp<OP, S>::type, M1, M2, T>::apply(o._data, l, r);
+	}
+};
+
+
+//! Run a product of two views, reading both buffers in place.
+template<class OP, class B1, class B2, class T, class S>
+typename GAViewProduct<B1, B2, OP, T, S>::type GAViewMultiply(const GATupleView<B1, const T, S> &l, const GATupleView<B2, const T, S> &r)
+{
+	typename GAViewProduct<B1, B2, OP, T, S>::type toRet;
+	GAViewProduct<B1, B2, OP, T, S>::apply(toRet, l.data(), r.data());
+	return toRet;
+}
+
+
+//! Geometric product of a view by a view, a tuple or a sparse tuple (and the reverse).
+template<class B1, class T1, class S, class B2, class T2>
+auto operator|(const GATupleView<B1, T1, S> &l, const GATupleView<B2, T2, S> &r)
+{
+	return GAViewMultiply<GA_GeometricProduct>(View(l), View(r));
+}
+
+template<class B, class T, class S, class R>
+auto operator|(const GATupleView<B, T, S> &l, const R &r) -> decltype(GAViewMultiply<GA_GeometricProduct>(View(l), View(r)))
+{
+	return GAViewMultiply<GA_GeometricProduct>(View(l), View(r));
+}
+
+template<class L, class B, class T, class S>
+auto operator|(const L &l, const GATupleView<B, T, S> &r) -> decltype(GAViewMultiply<GA_GeometricProduct>(View(l), View(r)))
+{
+	return GAViewMultiply<GA_GeometricProduct>(View(l), View(r));
+}
+
+
+//! Outer product of a view by a view, a tuple or a sparse tuple (and the reverse).
+template<class B1, class T1, class S, class B2, class T2>
+auto operator^(const GATupleView<B1, T1, S> &l, const GATupleView<B2, T2, S> &r)
+{
+	return GAViewMultiply<GA_OuterProduct>(View(l), View(r));
+}
+
+template<class B, class T, class S, class R>
+auto operator^(const GATupleView<B, T, S> &l, const R &r) -> decltype(GAViewMultiply<GA_OuterProduct>(View(l), View(r)))
+{
+	return GAViewMultiply<GA_OuterProduct>(View(l), View(r));
+}
+
+template<class L, class B, class T, class S>
+auto operator^(const L &l, const GATupleView<B, T, S> &r) -> decltype(GAViewMultiply<GA_OuterProduct>(View(l), View(r)))
+{
+	return GAViewMultiply<GA_OuterProduct>(View(l), View(r));
+}
+
+
+//! Inner product of a view by a view, a tuple or a sparse tuple (and the reverse).
+template<class B1, class T1, class S, class B2, class T2>
+auto operator*(const GATupleView<B1, T1, S> &l, const GATupleView<B2, T2, S> &r)
+{
+	return GAViewMultiply<GA_InnerProduct>(View(l), View(r));
+}
+
+template<class B, class T, class S, class R>
+auto operator*(const GATupleView<B, T, S> &l, const R &r) -> decltype(GAViewMultiply<GA_InnerProduct>(View(l), View(r)))
+{
+	return GAViewMultiply<GA_InnerProduct>(View(l), View(r));
+}
+
+template<class L, class B, class T, class S>
+auto operator*(const L &l, const GATupleView<B, T, S> &r) -> decltype(GAViewMultiply<GA_InnerProduct>(View(l), View(r)))
+{
+	return GAViewMultiply<GA_InnerProduct>(View(l), View(r));
+}
+
+
+//! Products of a view and a GA.
+template<class B, class T, class S, GABasis M2>
+auto operator|(const GATupleView<B, T, S> &l, GA<M2, typename std::remove_const<T>::type, S> r)
+{
+	const typename std::remove_const<T>::type v = r();
+	return GAViewMultiply<GA_GeometricProduct>(View(l), GATupleView<GABlades<M2>, const typename std::remove_const<T>::type, S>(&v));
+}
+
+template<class B, class T, class S, GABasis M2>
+auto operator^(const GATupleView<B, T, S> &l, GA<M2, typename std::remove_const<T>::type, S> r)
+{
+	const typename std::remove_const<T>::type v = r();
+	return GAViewMultiply<GA_OuterProduct>(View(l), GATupleView<GABlades<M2>, const typename std::remove_const<T>::type, S>(&v));
+}
+
+template<class B, class T, class S, GABasis M2>
+auto operator*(const GATupleView<B, T, S> &l, GA<M2, typename std::remove_const<T>::type, S> r)
+{
+	const typename std::remove_const<T>::type v = r();
+	return GAViewMultiply<GA_InnerProduct>(View(l), GATupleView<GABlades<M2>, const typename std::remove_const<T>::type, S>(&v));
+}
+
+template<class B, class T, class S, GABasis M1>
+auto operator|(GA<M1, typename std::remove_const<T>::type, S> l, const GATupleView<B, T, S> &r)
+{
+	const typename std::remove_const<T>::type v = l();
+	return GAViewMultiply<GA_GeometricProduct>(GATupleView<GABlades<M1>, const typename std::remove_const<T>::type, S>(&v), View(r));
+}
+
+template<class B, class T, class S, GABasis M1>
+auto operator^(GA<M1, typename std::remove_const<T>::type, S> l, const GATupleView<B, T, S> &r)
+{
+	const typename std::remove_const<T>::type v = l();
+	return GAViewMultiply<GA_OuterProduct>(GATupleView<GABlades<M1>, const typename std::remove_const<T>::type, S>(&v), View(r));
+}
+
+template<class B, class T, class S, GABasis M1>
+auto operator*(GA<M1, typename std::remove_const<T>::type, S> l, const GATupleView<B, T, S> &r)
+{
+	const typename std::remove_const<T>::type v = l();
+	return GAViewMultiply<GA_InnerProduct>(GATupleView<GABlades<M1>, const typename std::remove_const<T>::type, S>(&v), View(r));
+}
+
+
+//! Left contraction of two views (same as the inner product, *)
+template<class B1, class T1, class S, class B2, class T2>
+auto LeftContraction(const GATupleView<B1, T1, S> &l, const GATupleView<B2, T2, S> &r)
+{
+	return GAViewMultiply<GA_LeftContraction>(View(l), View(r));
+}
+
+
+//! Right contraction of two views
+template<class B1, class T1, class S, class B2, class T2>
+auto RightContraction(const GATupleView<B1, T1, S> &l, const GATupleView<B2, T2, S> &r)
+{
+	return GAViewMultiply<GA_RightContraction>(View(l), View(r));
+}
+
+
+//! Scalar product of two views
+template<class B1, class T1, class S, class B2, class T2>
+auto ScalarProduct(const GATupleView<B1, T1, S> &l, const GATupleView<B2, T2, S> &r)
+{
+	return GAViewMultiply<GA_ScalarProduct>(View(l), View(r));
+}
+
+
+//! Grade projection of a view, a view of the blades of grade K (nothing is copied).
+template<int K, class B, class T, class S>
+GATupleView<GASubsetBlades<B, typename GASelectGrade<B, K>::type>, T, S> Grade(const GATupleView<B, T, S> &in_)
+{
+	return GATupleView<GASubsetBlades<B, typename GASelectGrade<B, K>::type>, T, S>(in_.data());
+}
@@ -1,6 +1,8 @@
 #pragma once//
 
 #include "LMultivector.h"
+#include "LMultivector_Sparse.h"
+#include "LMultivector_View.h"
 #include <ostream>
 #include <cmath>
 
@@ -18,9 +20,9 @@
 std::ostream &operator<<(std::ostream &ostr, GABasis t)
 {
 	int x;
-	for (x=0; x<9; x++)
+	for (x=0; x<LGA_BASIS_BITS; x++)
 	{
-		if (t & (1 << x))
+		if ((unsigned int)t & (1u << x))
 		{
 			switch(x+1)
 			{
@@ -51,8 +53,8 @@ std::ostream &operator<<(std::ostream &ostr, GABasis t)
 
 
 //! Output function for GA
-template<GABasis BASIS, class TYPE>
-std::ostream &operator<<(std::ostream &o, GA<BASIS, TYPE> &v)
+template<GABasis BASIS, class TYPE, class S>
+std::ostream &operator<<(std::ostream &o, const GA<BASIS, TYPE, S> &v)
 {
 	o << v() << BASIS;
 	return o;
@@ -65,18 +67,24 @@ struct GAOStreamUtil
 	GAOStreamUtil(std::ostream &in_oRef)
 	: _oRef(in_oRef) {}
 	
-	template<GABasis BASIS, class TYPE>
-	void action(GA<BASIS, TYPE> &o)
+	template<GABasis BASIS, class TYPE, class S>
+	void action(GA<BASIS, TYPE, S> o)
 	{
-		if (std::abs(o()) <= 0.00001)
+		write(o(), BASIS);
+	}
+	
+	template<class TYPE>
+	void write(TYPE v, GABasis basis)
+	{
+		if (std::abs(v) <= 0.00001)
 			return;
 		
-		if (o() < 0)
+		if (v < 0)
 			_oRef << " - ";
 		else if (!_firstRun)
 			_oRef << " + ";
 		
-		_oRef << std::abs(o()) << BASIS;
+		_oRef << std::abs(v) << basis;
 		
 		_firstRun = false;
 	}
@@ -87,12 +95,52 @@ private:
 };
 
 
-//! Output for a tuple (for debugging as there is an implicit copy!)
-template<GABasis BASIS, class TYPE>
-std::ostream& operator<<(std::ostream &o, GATuple<BASIS, TYPE> t)
+//! Output for a tuple
+template<GABasis BASIS, class TYPE, class S>
+std::ostream& operator<<(std::ostream &o, const GATuple<BASIS, TYPE, S> &t)
+{
+	GAOStreamUtil osu(o);
+	GATupleForEach(t, osu);
+	
+	return o;
+}
+
+
+//! Utility to visit the blades of a sparse tuple
+template<class BLADES, class TYPE, std::size_t... I>
+void GAOStreamSparse(GAOStreamUtil &osu, const GASparseTuple<BLADES, TYPE> &t, std::index_sequence<I...>)
+{
+	using expand = int[];
+	(void)expand{0, (osu.write(t._data[I], GABasis(BLADES::mask(I))), 0)...};
+}
+
+
+//! Output for a sparse tuple
+template<class BLADES, class TYPE>
+std::ostream& operator<<(std::ostream &o, const GASparseTuple<BLADES, TYPE> &t)
 {
 	GAOStreamUtil osu(o);
-	GAMetaHelper<BASIS, BASIS, GAOStreamUtil, TYPE> gmh(t, osu);
+	GAOStreamSparse(osu, t, std::make_index_sequence<BLADES::count>());
 	
 	return o;
 }
+
+
+//! Utility to visit the blades of a view
+template<class BLADES, class TYPE, class S, std::size_t... I>
+void GAOStreamView(GAOStreamUtil &osu, const GATupleView<BLADES, TYPE, S> &t, std::index_sequence<I...>)
+{
+	using expand = int[];
+	(void)expand{0, (osu.write(t.data()[BLADES::slot(I)], GABasis(BLADES::mask(I))), 0)...};
+}
+
+
+//! Output for a view, read from its buffer
+template<class BLADES, class TYPE, class S>
+std::ostream& operator<<(std::ostream &o, const GATupleView<BLADES, TYPE, S> &t)
+{
+	GAOStreamUtil osu(o);
+	GAOStreamView(osu, t, std::make_index_sequence<BLADES::count>());
+	
+	return o;
+}
\ No newline at end of file
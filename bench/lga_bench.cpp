@@ -0,0 +1,2277 @@
+/*!	@file	lga_bench.cpp		Micro and macro benchmarks
+	
+	Measures ns/op and flops/op of the products (2D to 9D, and within the PGA
+	and CGA metrics), Dual, Cross, the Plucker routines, the versors, the
+	outermorphisms and the runtime algebras, then transforms a point cloud
+	(as batches, and in place through views), intersects lines and planes
+	read from memory-mapped files, streams a file through a meet, runs the
+	intersections and the rotations on every core, and sums a cloud.
+	Every result is checked against a naive double precision reference, and
+	the numbers are written as JSON so they can be compared across versions.
+	
+	@code
+		lga_bench [--json out.json] [--points 10000000] [--time 0.2] [--filter name]
+	@endcode
+	
+	The flops are counted by running each benchmark once with a scalar type
+	that counts its operations (the multiplications by the signs of the
+	Cayley tables are not counted, the compiler folds them).
+	
+	Every benchmark also runs with the SIMD kernels pinned to LGA_SIMD_SCALAR
+	(see GASIMDSetLevel), and both times are reported: a kernel should only
+	be listed in GASIMDWins for the levels that beat the scalar column.
+ */
+
+#include "LGA.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+
+//! Scalar that counts the arithmetic done on it.
+struct Flop
+{
+	//! Operations since the last reset.
+	static long count;
+	
+	Flop(double in_v = 0) : v((float)in_v), sign(false) {}
+	Flop(int in_sign) : v((float)in_sign), sign(true) {}	// Signs of the Cayley tables
+	
+	explicit operator float() const { return v; }
+	
+	Flop &operator+=(Flop r) { count++; v += r.v; sign = false; return *this; }
+	Flop &operator-=(Flop r) { count++; v -= r.v; sign = false; return *this; }
+	Flop &operator*=(Flop r) { count += (sign || r.sign) ? 0 : 1; v *= r.v; sign = sign && r.sign; return *this; }
+	Flop &operator/=(Flop r) { count++; v /= r.v; sign = false; return *this; }
+	
+	float v;
+	bool sign;		//!< Exactly +1 or -1, multiplying by it is free.
+};
+
+long Flop::count = 0;
+
+Flop operator+(Flop l, Flop r) { return l += r; }
+Flop operator-(Flop l, Flop r) { return l -= r; }
+Flop operator*(Flop l, Flop r) { return l *= r; }
+Flop operator-(Flop l) { Flop o(-l.v); o.sign = l.sign; return o; }
+Flop operator/(Flop l, Flop r) { return l /= r; }
+
+// Comparisons, the absolute value and the exponent are free, a square root counts as one.
+bool operator==(Flop l, Flop r) { return l.v == r.v; }
+bool operator<(Flop l, Flop r) { return l.v < r.v; }
+bool operator>(Flop l, Flop r) { return l.v > r.v; }
+bool operator<=(Flop l, Flop r) { return l.v <= r.v; }
+Flop fabs(Flop x) { return Flop(std::fabs(x.v)); }
+Flop sqrt(Flop x) { Flop::count++; return Flop(std::sqrt(x.v)); }
+Flop frexp(Flop x, int *e) { return Flop(std::frexp(x.v, e)); }
+
+
+//! GA_Math for Flop, a square root, sine, cosine or arc tangent counts as one.
+struct FlopMath
+{
+	static Flop sqrt(const Flop x) { return ::sqrt(x); }
+	static void sincos(const Flop x, Flop &s, Flop &c) { Flop::count += 2; s = std::sin(x.v); c = std::cos(x.v); }
+	static Flop atan2(const Flop y, const Flop x) { Flop::count++; return Flop(std::atan2(y.v, x.v)); }
+};
+
+
+//! Allocator for GATupleBatch arrays (std::allocator ignores alignas before C++17).
+template<class T>
+struct AlignedAllocator
+{
+	typedef T value_type;
+	
+	AlignedAllocator() {}
+	template<class U> AlignedAllocator(const AlignedAllocator<U> &) {}
+	
+	T *allocate(std::size_t n)
+	{
+		void *p = nullptr;
+		if (posix_memalign(&p, alignof(T) < 64 ? 64 : alignof(T), n * sizeof(T)) != 0)
+			throw std::bad_alloc();
+		return (T *)p;
+	}
+	
+	void deallocate(T *p, std::size_t) { free(p); }
+	
+	template<class U> bool operator==(const AlignedAllocator<U> &) const { return true; }
+	template<class U> bool operator!=(const AlignedAllocator<U> &) const { return false; }
+};
+
+
+//! Keep the compiler from dropping the work being timed.
+template<class T>
+inline void Sink(const T *p)
+{
+	asm volatile("" : : "r"(p) : "memory");
+}
+
+
+//! Naive reference: count the swaps to sort the bases of l followed by r.
+int NaiveSign(unsigned int l, unsigned int r)
+{
+	int swaps = 0;
+	for (int i=0; i<32; i++)
+		for (int j=0; j<i; j++)
+			if (((l >> i) & 1) && ((r >> j) & 1))
+				swaps++;
+	return swaps % 2 == 0 ? 1 : -1;
+}
+
+
+enum NaiveOp { NaiveGeometric, NaiveOuter, NaiveInner, NaiveRightContraction, NaiveScalar };
+
+
+//! Naive reference: o += l OP r over dense arrays of 2^D blades.
+/*!	The basis vectors of neg square to -1, those of zero to 0. */
+void NaiveProduct(NaiveOp op, int D, const double *l, const double *r, double *o,
+				  unsigned int neg = 0, unsigned int zero = 0)
+{
+	for (unsigned int i=0; i < (1u << D); i++)
+	{
+		if (l[i] == 0)
+			continue;
+		
+		for (unsigned int j=0; j < (1u << D); j++)
+		{
+			if (r[j] == 0)
+				continue;
+			if (op == NaiveOuter && (i & j) != 0)
+				continue;
+			if (op == NaiveInner && (i & j) != i)
+				continue;
+			if (op == NaiveRightContraction && (i & j) != j)
+				continue;
+			if (op == NaiveScalar && i != j)
+				continue;
+			
+			if ((i & j & zero) != 0)
+				continue;
+			
+			const int square = GAGrade(GABasis(i & j & neg)) % 2 == 0 ? 1 : -1;
+			o[i ^ j] += square * NaiveSign(i, j) * l[i] * r[j];
+		}
+	}
+}
+
+
+//! Naive reference: the dual as defined by LMultivector_Dual.h
+void NaiveDual(int D, const double *in_, double *o)
+{
+	std::vector<double> inverse(1u << D, 0.0);
+	inverse[(1u << D) - 1] = ((D * (D-1)) / 2) % 2 == 0 ? 1.0 : -1.0;
+	NaiveProduct(NaiveInner, D, in_, inverse.data(), o);
+}
+
+
+//! Naive reference: keep the blades of grade K.
+std::vector<double> NaiveGrade(int D, const double *in_, int K)
+{
+	std::vector<double> o(1u << D, 0.0);
+	for (unsigned int i=0; i < (1u << D); i++)
+		if (GAGrade(GABasis(i)) == K)
+			o[i] = in_[i];
+	return o;
+}
+
+
+//! Copy a GA or a tuple to / from a dense array of 2^D coefficients.
+template<GABasis I, class T, class S>
+void Export(const GA<I, T, S> &in_g, double *o) { o[I] = (double)(float)in_g(); }
+
+template<GABasis PS, class T, class S>
+void Export(const GATuple<PS, T, S> &in_, double *o)
+{
+	for (int b=0; b<=PS; b++)
+		o[b] = (double)(float)in_._data[b];
+}
+
+template<GABasis I, class T, class S>
+void Import(const double *in_, GA<I, T, S> &o) { o = T(in_[I]); }
+
+template<GABasis PS, class T, class S>
+void Import(const double *in_, GATuple<PS, T, S> &o)
+{
+	for (int b=0; b<=PS; b++)
+		o._data[b] = T((b & ~PS) == 0 ? in_[b] : 0.0);
+}
+
+template<class B, class T>
+void Export(const GASparseTuple<B, T> &in_, double *o)
+{
+	for (int i=0; i<B::count; i++)
+		o[B::mask(i)] = (double)(float)in_._data[i];
+}
+
+template<class B, class T>
+void Import(const double *in_, GASparseTuple<B, T> &o)
+{
+	for (int i=0; i<B::count; i++)
+		o._data[i] = T(in_[B::mask(i)]);
+}
+
+
+//! Dimension of the algebra of a benchmark.
+constexpr GABasis PseudoScalar(int D) { return GABasis((1 << D) - 1); }
+
+
+/*	Every micro benchmark provides, for a scalar type T and a dimension D:
+	- L and R, the operands (GA or GATuple),
+	- run(l, r), the operation being timed,
+	- reference(l, r, o), the same operation on dense double arrays.
+ */
+
+template<class T, int D>
+struct GAxGA
+{
+	static const char *name() { return "ga_ga_gp"; }
+	typedef GA<e1, T> L;
+	typedef GA<PseudoScalar(D), T> R;
+	static auto run(const L &l, const R &r) { return l | r; }
+	static void reference(const double *l, const double *r, double *o) { NaiveProduct(NaiveGeometric, D, l, r, o); }
+};
+
+template<class T, int D>
+struct TuplexGA
+{
+	static const char *name() { return "tuple_ga_gp"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GA<e1, T> R;
+	static auto run(const L &l, const R &r) { return l | r; }
+	static void reference(const double *l, const double *r, double *o) { NaiveProduct(NaiveGeometric, D, l, r, o); }
+};
+
+template<class T, int D>
+struct TuplexTupleGP
+{
+	static const char *name() { return "tuple_tuple_gp"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GATuple<PseudoScalar(D), T> R;
+	static auto run(const L &l, const R &r) { return l | r; }
+	static void reference(const double *l, const double *r, double *o) { NaiveProduct(NaiveGeometric, D, l, r, o); }
+};
+
+template<class T, int D>
+struct TuplexTupleOP
+{
+	static const char *name() { return "tuple_tuple_op"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GATuple<PseudoScalar(D), T> R;
+	static auto run(const L &l, const R &r) { return l ^ r; }
+	static void reference(const double *l, const double *r, double *o) { NaiveProduct(NaiveOuter, D, l, r, o); }
+};
+
+template<class T, int D>
+struct TuplexTupleIP
+{
+	static const char *name() { return "tuple_tuple_ip"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GATuple<PseudoScalar(D), T> R;
+	static auto run(const L &l, const R &r) { return l * r; }
+	static void reference(const double *l, const double *r, double *o) { NaiveProduct(NaiveInner, D, l, r, o); }
+};
+
+//! Reference by the eager operators: f on float tuples of l and r.
+/*!	For the forms that must give the same result as a two-operand product. */
+template<int D, class F>
+void EagerReference(const double *l, const double *r, double *o, F f)
+{
+	GATuple<PseudoScalar(D), float> a, b;
+	Import(l, a);
+	Import(r, b);
+	Export(f(a, b), o);
+}
+
+template<class T, int D>
+struct LazyChain
+{
+	static const char *name() { return "lazy_chain"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GATuple<PseudoScalar(D), T> R;
+	static L run(const L &l, const R &r) { return (Lazy(l) | r) + (Lazy(l) ^ r); }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		EagerReference<D>(l, r, o, [](auto a, auto b) { auto s = a | b; s += a ^ b; return s; });
+	}
+};
+
+template<class T, int D>
+struct LazyAlias
+{
+	static const char *name() { return "lazy_alias"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GATuple<PseudoScalar(D), T> R;
+	// The product reads t after the first term was added to it.
+	static L run(const L &l, const R &r) { L t = l; t += Lazy(t) + (Lazy(t) | r); return t; }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		EagerReference<D>(l, r, o, [](auto a, auto b) { const auto p = a | b; auto s = a; s += a; s += p; return s; });
+	}
+};
+
+template<class T, int D>
+struct InPlaceGP
+{
+	static const char *name() { return "inplace_gp"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GATuple<PseudoScalar(D), T> R;
+	static L run(const L &l, const R &r) { L t = l; t |= r; return t; }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		EagerReference<D>(l, r, o, [](auto a, auto b) { return a | b; });
+	}
+};
+
+template<class T, int D>
+struct InPlaceOP
+{
+	static const char *name() { return "inplace_op"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GATuple<PseudoScalar(D), T> R;
+	static L run(const L &l, const R &r) { L t = l; t ^= r; return t; }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		EagerReference<D>(l, r, o, [](auto a, auto b) { return a ^ b; });
+	}
+};
+
+template<class T, int D>
+struct InPlaceIP
+{
+	static const char *name() { return "inplace_ip"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GATuple<PseudoScalar(D), T> R;
+	static L run(const L &l, const R &r) { L t = l; t *= r; return t; }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		EagerReference<D>(l, r, o, [](auto a, auto b) { return a * b; });
+	}
+};
+
+//! x |= x, the product reads x while it is written.
+template<class T, int D>
+struct InPlaceSquare
+{
+	static const char *name() { return "inplace_square"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GA<scalar, T> R;
+	static L run(const L &l, const R &) { L t = l; t |= t; return t; }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		EagerReference<D>(l, r, o, [](auto a, auto) { return a | a; });
+	}
+};
+
+//! x -= y of a subset, against x += -1 | y.
+template<class T, int D>
+struct InPlaceSub
+{
+	static const char *name() { return "inplace_sub"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GATuple<PseudoScalar(D-1), T> R;
+	static L run(const L &l, const R &r) { L t = l; t -= r; return t; }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		GATuple<PseudoScalar(D), float> a;
+		GATuple<PseudoScalar(D-1), float> b;
+		Import(l, a);
+		Import(r, b);
+		a += GA<scalar>(-1.0f) | b;
+		Export(a, o);
+	}
+};
+
+template<class T, int D>
+struct TupleDual
+{
+	static const char *name() { return "dual"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GA<scalar, T> R;
+	static auto run(const L &l, const R &) { return Dual(l); }
+	static void reference(const double *l, const double *, double *o) { NaiveDual(D, l, o); }
+};
+
+template<class T, int D>
+struct TupleCross
+{
+	static const char *name() { return "cross"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GATuple<PseudoScalar(D), T> R;
+	static auto run(const L &l, const R &r) { return Cross(l, r); }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		std::vector<double> wedge(1u << D, 0.0), ps(1u << D, 0.0);
+		NaiveProduct(NaiveOuter, D, l, r, wedge.data());
+		ps[(1u << D) - 1] = -1;
+		NaiveProduct(NaiveGeometric, D, ps.data(), wedge.data(), o);
+	}
+};
+
+template<class T, int D>
+struct TupleSquare
+{
+	static const char *name() { return "square"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GA<scalar, T> R;
+	static auto run(const L &l, const R &) { return Square(l); }
+	static void reference(const double *l, const double *, double *o) { NaiveProduct(NaiveGeometric, D, l, l, o); }
+};
+
+template<class T, int D>
+struct TupleNormSquared
+{
+	static const char *name() { return "norm_squared"; }
+	typedef GATuple<PseudoScalar(D), T> L;
+	typedef GA<scalar, T> R;
+	static auto run(const L &l, const R &) { return GA<scalar, T>(NormSquared(l)); }
+	static void reference(const double *l, const double *, double *o)
+	{
+		// The metric is Euclidean, every blade times its reverse is 1.
+		for (int b=0; b<(1 << D); b++)
+			o[0] += l[b] * l[b];
+	}
+};
+
+template<class T, int D>
+struct WideGP
+{
+	static const char *name() { return "sparse_bivector_vector_gp"; }
+	typedef GASparseTuple<typename GAGradeBlades<PseudoScalar(D), 2>::type, T> L;
+	typedef GASparseTuple<typename GAGradeBlades<PseudoScalar(D), 1>::type, T> R;
+	static auto run(const L &l, const R &r) { return l | r; }
+	static void reference(const double *l, const double *r, double *o) { NaiveProduct(NaiveGeometric, D, l, r, o); }
+};
+
+template<class T, int D>
+struct ProjectiveGP
+{
+	static const char *name() { return "pga_gp"; }
+	typedef GATuple<PseudoScalar(D), T, GASignature<scalar, GABasis(1 << (D-1))>> L;
+	typedef L R;
+	static auto run(const L &l, const R &r) { return l | r; }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		NaiveProduct(NaiveGeometric, D, l, r, o, 0, 1u << (D-1));
+	}
+};
+
+template<class T, int D>
+struct ConformalGP
+{
+	static const char *name() { return "cga_gp"; }
+	typedef GATuple<PseudoScalar(D), T, GASignature<GABasis(1 << (D-1))>> L;
+	typedef L R;
+	static auto run(const L &l, const R &r) { return l | r; }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		NaiveProduct(NaiveGeometric, D, l, r, o, 1u << (D-1));
+	}
+};
+
+template<class T, int D>
+struct PluckerPoint
+{
+	static const char *name() { return "plucker_point"; }
+	typedef GATuple<e1^e2^e3, T> L;
+	typedef GA<scalar, T> R;
+	static auto run(const L &l, const R &)
+	{
+		return Plucker::Point((float)l._data[e1], (float)l._data[e2], (float)l._data[e3]);
+	}
+	static void reference(const double *l, const double *, double *o)
+	{
+		o[e1] = l[e1]; o[e2] = l[e2]; o[e3] = l[e3]; o[e4] = 1;
+	}
+};
+
+template<class T, int D>
+struct PluckerLine
+{
+	static const char *name() { return "plucker_line"; }
+	typedef GATuple<e1^e2^e3^e4, T> L;
+	typedef GATuple<e1^e2^e3^e4, T> R;
+	static auto run(const L &l, const R &r) { return Plucker::Line(l, r); }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		NaiveProduct(NaiveOuter, 4, NaiveGrade(4, l, 1).data(), NaiveGrade(4, r, 1).data(), o);
+	}
+};
+
+template<class T, int D>
+struct PluckerPlane
+{
+	static const char *name() { return "plucker_plane"; }
+	typedef GATuple<e1^e2^e3^e4, T> L;
+	typedef GATuple<e1^e2^e3^e4, T> R;
+	
+	//! Third point of the plane.
+	static L third() { L p; p += GA<e1, T>(0.5); p += GA<e2, T>(-2.0); p += GA<e3, T>(1.5); p += GA<e4, T>(1.0); return p; }
+	
+	static auto run(const L &l, const R &r) { return Plucker::Plane(l, r, third()); }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		double p3[16] = {0};
+		Export(GATuple<e1^e2^e3^e4, float>(PluckerPlane<float, D>::third()), p3);
+		
+		double line[16] = {0};
+		NaiveProduct(NaiveOuter, 4, NaiveGrade(4, l, 1).data(), NaiveGrade(4, r, 1).data(), line);
+		NaiveProduct(NaiveOuter, 4, line, NaiveGrade(4, p3, 1).data(), o);
+	}
+};
+
+template<class T, int D>
+struct PluckerMeet
+{
+	static const char *name() { return "plucker_meet"; }
+	typedef GATuple<e1^e2^e3^e4, T> L;
+	typedef GATuple<e1^e2^e3^e4, T> R;
+	static auto run(const L &l, const R &r) { return Plucker::Meet(l, r); }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		double dual[16] = {0};
+		NaiveDual(4, l, dual);
+		NaiveProduct(NaiveInner, 4, dual, r, o);
+	}
+};
+
+
+template<class T, int D>
+struct PluckerJoin
+{
+	static const char *name() { return "plucker_join"; }
+	typedef GATuple<e1^e2^e3^e4, T> L;
+	typedef GATuple<e1^e2^e3^e4, T> R;
+	
+	//! The vectors of x, as a point.
+	static L point(const L &x) { L p; for (int b : {e1, e2, e3, e4}) p._data[b] = x._data[b]; return p; }
+	
+	static auto run(const L &l, const R &r) { return Plucker::Join(point(l), point(r)); }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		NaiveProduct(NaiveOuter, 4, NaiveGrade(4, l, 1).data(), NaiveGrade(4, r, 1).data(), o);
+	}
+};
+
+//! The join of the line through two points with a third point, a plane.
+template<class T, int D>
+struct PluckerJoinPlane
+{
+	static const char *name() { return "plucker_join_plane"; }
+	typedef GATuple<e1^e2^e3^e4, T> L;
+	typedef GATuple<e1^e2^e3^e4, T> R;
+	static auto run(const L &l, const R &r)
+	{
+		typedef PluckerJoin<T, D> J;
+		return Plucker::Join(J::run(l, r), J::point(PluckerPlane<T, D>::third()));
+	}
+	static void reference(const double *l, const double *r, double *o) { PluckerPlane<T, D>::reference(l, r, o); }
+};
+
+template<class T, int D>
+struct PluckerMeetLinePlane
+{
+	static const char *name() { return "plucker_meet_line_plane"; }
+	typedef GATuple<e1^e2^e3^e4, T> L;
+	typedef GATuple<e1^e2^e3^e4, T> R;
+	static auto run(const L &l, const R &r) { return Plucker::MeetLinePlane(l, r); }
+	static void reference(const double *l, const double *r, double *o)
+	{
+		double dual[16] = {0};
+		NaiveDual(4, NaiveGrade(4, l, 2).data(), dual);
+		NaiveProduct(NaiveInner, 4, dual, NaiveGrade(4, r, 3).data(), o);
+	}
+};
+
+
+//! One line of the report.
+struct Result
+{
+	std::string name;
+	int dim;
+	double nsPerOp;
+	double scalarNsPerOp;	//!< Same benchmark with the kernels at LGA_SIMD_SCALAR
+	double flopsPerOp;
+	double maxError;
+	bool ok;
+};
+
+
+//! Command line options.
+struct Options
+{
+	std::string json = "lga_bench.json";
+	std::string filter;
+	long points = 10000000;
+	double seconds = 0.2;
+	
+	bool quiet = false;				//!< Only print the failures (scalar pass)
+	std::vector<Result> scalar;		//!< Results of the scalar pass
+};
+
+
+//! ns/op of a benchmark in the scalar pass (its own if there was none).
+double ScalarNs(const Options &opt, const Result &res)
+{
+	for (const Result &s : opt.scalar)
+		if (s.name == res.name && s.dim == res.dim)
+			return s.nsPerOp;
+	return res.nsPerOp;
+}
+
+
+//! Keep a result and print it, with its time at LGA_SIMD_SCALAR.
+void Report(const Options &opt, std::vector<Result> &results, Result res, const std::string &extra = "")
+{
+	res.scalarNsPerOp = ScalarNs(opt, res);
+	results.push_back(res);
+	
+	if (!opt.quiet || !res.ok)
+		printf("%-24s %dD %12.2f ns/op %9.2f scalar %10.0f flops/op %8.2f GFlop/s  %serr %.2g %s\n",
+			   res.name.c_str(), res.dim, res.nsPerOp, res.scalarNsPerOp, res.flopsPerOp, res.flopsPerOp / res.nsPerOp,
+			   extra.c_str(), res.maxError, res.ok ? "" : "FAILED");
+}
+
+
+//! Operands per benchmark (cycled through while timing).
+static const int kOperands = 256;
+
+
+//! Time, count and check one micro benchmark.
+template<template<class, int> class B, int D>
+void Measure(const Options &opt, std::vector<Result> &results)
+{
+	typedef B<float, D> F;
+	typedef B<Flop, D> C;
+	
+	Result res;
+	res.name = F::name();
+	res.dim = D;
+	
+	if (!opt.filter.empty() && res.name.find(opt.filter) == std::string::npos)
+		return;
+	
+	// Operands, as dense double arrays first so every type sees the same values.
+	const int n = 1 << D;
+	std::mt19937 rnd(1234 + D);
+	std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+	
+	std::vector<double> dl(kOperands * n), dr(kOperands * n);
+	for (double &v : dl) v = uniform(rnd);
+	for (double &v : dr) v = uniform(rnd);
+	
+	std::vector<typename F::L> l(kOperands);
+	std::vector<typename F::R> r(kOperands);
+	for (int k=0; k<kOperands; k++)
+	{
+		Import(&dl[k * n], l[k]);
+		Import(&dr[k * n], r[k]);
+		
+		// Keep only what the operands store
+		std::fill(&dl[k * n], &dl[k * n] + n, 0.0);
+		std::fill(&dr[k * n], &dr[k * n] + n, 0.0);
+		Export(l[k], &dl[k * n]);
+		Export(r[k], &dr[k * n]);
+	}
+	
+	typedef decltype(F::run(l[0], r[0])) Out;
+	std::vector<Out> o(kOperands);
+	
+	// Time, doubling the repetitions until the run is long enough.
+	long reps = 1;
+	double elapsed = 0;
+	for (;;)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (long rep=0; rep<reps; rep++)
+		{
+			for (int k=0; k<kOperands; k++)
+				o[k] = F::run(l[k], r[(k + rep) % kOperands]);
+			Sink(o.data());
+		}
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		
+		if (elapsed >= opt.seconds)
+			break;
+		reps *= 2;
+	}
+	res.nsPerOp = elapsed * 1e9 / (double(reps) * kOperands);
+	
+	// Count the flops of one operation.
+	{
+		typename C::L cl;
+		typename C::R cr;
+		Import(&dl[0], cl);
+		Import(&dr[0], cr);
+		
+		Flop::count = 0;
+		auto co = C::run(cl, cr);
+		(void)co;
+		res.flopsPerOp = (double)Flop::count;
+	}
+	
+	// Check against the reference (the last repetition used r[k + reps - 1]).
+	res.maxError = 0;
+	double scale = 1;
+	for (int k=0; k<kOperands; k++)
+	{
+		const int kr = int((k + reps - 1) % kOperands);
+		std::vector<double> expect(n, 0.0), got(n, 0.0);
+		F::reference(&dl[k * n], &dr[kr * n], expect.data());
+		Export(o[k], got.data());
+		
+		for (int b=0; b<n; b++)
+		{
+			res.maxError = std::fmax(res.maxError, std::fabs(expect[b] - got[b]));
+			scale = std::fmax(scale, std::fabs(expect[b]));
+		}
+	}
+	res.ok = res.maxError <= 1e-4 * scale * n;
+	
+	Report(opt, results, res);
+	fflush(stdout);
+}
+
+
+//! Run a benchmark for each dimension in the list.
+template<template<class, int> class B, int... D>
+void MeasureDims(const Options &opt, std::vector<Result> &results, std::integer_sequence<int, D...>)
+{
+	using expand = int[];
+	(void)expand{0, (Measure<B, D>(opt, results), 0)...};
+}
+
+
+//! Macro benchmark: rotate a point cloud with a rotor, 8 points at a time.
+/*!	p' = R p ~R, with the points in structure-of-arrays form and run
+	through GATupleBatch. */
+void MeasureCloud(const Options &opt, std::vector<Result> &results)
+{
+	Result res;
+	res.name = "cloud_rotate";
+	res.dim = 3;
+	
+	if (!opt.filter.empty() && res.name.find(opt.filter) == std::string::npos)
+		return;
+	
+	const long count = (opt.points + 7) / 8 * 8;
+	std::vector<float> x(count), y(count), z(count);
+	std::vector<float> ox(count), oy(count), oz(count);
+	
+	std::mt19937 rnd(42);
+	std::uniform_real_distribution<float> uniform(-100.0f, 100.0f);
+	for (long i=0; i<count; i++)
+	{
+		x[i] = uniform(rnd);
+		y[i] = uniform(rnd);
+		z[i] = uniform(rnd);
+	}
+	
+	// Rotation of theta within the plane e1^e2 (and its reverse).
+	const double theta = 0.7;
+	const float c = (float)std::cos(theta / 2);
+	const float s = (float)std::sin(theta / 2);
+	
+	GATuple<e1^e2^e3> rotor, reverse;
+	rotor += GA<scalar>(c);
+	rotor += GA<e1^e2>(-s);
+	reverse += GA<scalar>(c);
+	reverse += GA<e1^e2>(s);
+	
+	const auto start = std::chrono::steady_clock::now();
+	
+	GATupleBatch<e1^e2^e3, float, 8> batch;
+	for (long i=0; i<count; i+=8)
+	{
+		for (int n=0; n<8; n++)
+		{
+			batch._data[e1][n] = x[i + n];
+			batch._data[e2][n] = y[i + n];
+			batch._data[e3][n] = z[i + n];
+		}
+		
+		const GATupleBatch<e1^e2^e3, float, 8> moved = (rotor | batch) | reverse;
+		
+		for (int n=0; n<8; n++)
+		{
+			ox[i + n] = moved._data[e1][n];
+			oy[i + n] = moved._data[e2][n];
+			oz[i + n] = moved._data[e3][n];
+		}
+	}
+	Sink(ox.data());
+	
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	res.nsPerOp = elapsed * 1e9 / double(count);
+	
+	// Flops of one point, through the same tables.
+	{
+		GATuple<e1^e2^e3, Flop> fr, fv, fp;
+		fr += GA<scalar, Flop>(c);
+		fr += GA<e1^e2, Flop>(-s);
+		fv += GA<scalar, Flop>(c);
+		fv += GA<e1^e2, Flop>(s);
+		fp += GA<e1, Flop>(1.0);
+		
+		Flop::count = 0;
+		auto moved = (fr | fp) | fv;
+		(void)moved;
+		res.flopsPerOp = (double)Flop::count;
+	}
+	
+	// Check against a rotation matrix.
+	res.maxError = 0;
+	const double ct = std::cos(theta), st = std::sin(theta);
+	for (long i=0; i<count; i += count / 1000 + 1)
+	{
+		const double ex = ct * x[i] - st * y[i];
+		const double ey = st * x[i] + ct * y[i];
+		
+		res.maxError = std::fmax(res.maxError, std::fabs(ex - ox[i]));
+		res.maxError = std::fmax(res.maxError, std::fabs(ey - oy[i]));
+		res.maxError = std::fmax(res.maxError, std::fabs(z[i] - oz[i]));
+	}
+	res.ok = res.maxError <= 1e-3;
+	
+	res.scalarNsPerOp = ScalarNs(opt, res);
+	results.push_back(res);
+	if (!opt.quiet || !res.ok)
+		printf("%-24s %ldM points %8.2f ns/point %6.2f scalar %6.0f flops/point %8.2f GFlop/s  err %.2g %s\n",
+			   res.name.c_str(), count / 1000000, res.nsPerOp, res.scalarNsPerOp, res.flopsPerOp, res.flopsPerOp / res.nsPerOp,
+			   res.maxError, res.ok ? "" : "FAILED");
+}
+
+
+//! Macro benchmark: rotate the positions of an interleaved vertex buffer in place.
+/*!	view_cloud_rotate reads and writes the records through GATupleArrayView,
+	without copying the points into tuples (compare with cloud_rotate).
+ */
+void MeasureViewCloud(const Options &opt, std::vector<Result> &results)
+{
+	Result res;
+	res.name = "view_cloud_rotate";
+	res.dim = 3;
+	
+	if (!opt.filter.empty() && res.name.find(opt.filter) == std::string::npos)
+		return;
+	
+	struct Vertex { float pos[3]; float normal[3]; float uv[2]; };
+	typedef GABlades<e1, e2, e3> Position;
+	
+	const long count = opt.points;
+	std::vector<Vertex> in_(count), out(count);
+	
+	std::mt19937 rnd(42);
+	std::uniform_real_distribution<float> uniform(-100.0f, 100.0f);
+	for (long i=0; i<count; i++)
+		for (int k=0; k<3; k++)
+			in_[i].pos[k] = in_[i].normal[k] = uniform(rnd);
+	
+	const double theta = 0.7;
+	const float c = (float)std::cos(theta / 2);
+	const float s = (float)std::sin(theta / 2);
+	
+	GATuple<e1^e2^e3> rotor, reverse;
+	rotor += GA<scalar>(c);
+	rotor += GA<e1^e2>(-s);
+	reverse += GA<scalar>(c);
+	reverse += GA<e1^e2>(s);
+	
+	const GATupleArrayView<Position, const float> points(&in_[0].pos[0], count, sizeof(Vertex));
+	const GATupleArrayView<Position> moved(&out[0].pos[0], count, sizeof(Vertex));
+	
+	const auto start = std::chrono::steady_clock::now();
+	
+	for (long i=0; i<count; i++)
+		moved[i] = View(rotor | points[i]) | reverse;
+	Sink(out.data());
+	
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	res.nsPerOp = elapsed * 1e9 / double(count);
+	
+	// Flops of one point, through the same tables.
+	{
+		GATuple<e1^e2^e3, Flop> fr, fv;
+		fr += GA<scalar, Flop>(c);
+		fr += GA<e1^e2, Flop>(-s);
+		fv += GA<scalar, Flop>(c);
+		fv += GA<e1^e2, Flop>(s);
+		const Flop fp[3] = {Flop(1.0), Flop(0.0), Flop(0.0)};
+		
+		Flop::count = 0;
+		auto m = View(fr | GATupleView<Position, const Flop>(fp)) | fv;
+		(void)m;
+		res.flopsPerOp = (double)Flop::count;
+	}
+	
+	// Check against a rotation matrix, and that the rest of the records is untouched.
+	res.maxError = 0;
+	const double ct = std::cos(theta), st = std::sin(theta);
+	for (long i=0; i<count; i += count / 1000 + 1)
+	{
+		const double ex = ct * in_[i].pos[0] - st * in_[i].pos[1];
+		const double ey = st * in_[i].pos[0] + ct * in_[i].pos[1];
+		
+		res.maxError = std::fmax(res.maxError, std::fabs(ex - out[i].pos[0]));
+		res.maxError = std::fmax(res.maxError, std::fabs(ey - out[i].pos[1]));
+		res.maxError = std::fmax(res.maxError, std::fabs(in_[i].pos[2] - out[i].pos[2]));
+		res.maxError = std::fmax(res.maxError, std::fabs(out[i].normal[0]));
+	}
+	res.ok = res.maxError <= 1e-3;
+	
+	res.scalarNsPerOp = ScalarNs(opt, res);
+	results.push_back(res);
+	if (!opt.quiet || !res.ok)
+		printf("%-24s %ldM points %8.2f ns/point %6.2f scalar %6.0f flops/point %8.2f GFlop/s  err %.2g %s\n",
+			   res.name.c_str(), count / 1000000, res.nsPerOp, res.scalarNsPerOp, res.flopsPerOp, res.flopsPerOp / res.nsPerOp,
+			   res.maxError, res.ok ? "" : "FAILED");
+}
+
+
+//! Repeat a run until it lasts long enough, returns the ns per item.
+template<class F>
+double TimeItems(const Options &opt, long items, F run)
+{
+	long reps = 1;
+	for (;;)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (long rep=0; rep<reps; rep++)
+			run();
+		const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		
+		if (elapsed >= opt.seconds)
+			return elapsed * 1e9 / (double(reps) * items);
+		reps *= 2;
+	}
+}
+
+
+//! Macro benchmark: intersect lines with planes.
+/*!	plucker_intersect_pairs runs Plucker::IntersectPairs on arrays of
+	tuples, plucker_intersect_batches on arrays of GATupleBatch, and
+	plucker_intersect_scalar calls Plucker::Meet once per pair.
+	plucker_intersect_all runs Plucker::IntersectAll of 64 lines with
+	4096 planes, its tuple, batch and view forms checked against
+	IntersectPairs.
+ */
+void MeasureIntersect(const Options &opt, std::vector<Result> &results)
+{
+	typedef GATuple<e1^e2^e3^e4> T4;
+	typedef GATupleBatch<e1^e2^e3^e4, float, 16> B4;
+	
+	if (!opt.filter.empty() && std::string("plucker_intersect").find(opt.filter) == std::string::npos
+		&& opt.filter.find("plucker_intersect") == std::string::npos)
+		return;
+	
+	const int count = (int)std::min<long>(opt.points / 4, 1 << 20) / 16 * 16;
+	std::vector<T4> lines(count), planes(count), points(count);
+	std::vector<B4, AlignedAllocator<B4>> lineBatches(count / 16), planeBatches(count / 16), pointBatches(count / 16);
+	std::unique_ptr<bool[]> hit(new bool[count]);
+	std::unique_ptr<bool[]> batchHit(new bool[count]);
+	
+	std::mt19937 rnd(7);
+	std::uniform_real_distribution<float> uniform(-10.0f, 10.0f);
+	auto point = [&]() { return Plucker::Point(uniform(rnd), uniform(rnd), uniform(rnd)); };
+	for (int i=0; i<count; i++)
+	{
+		lines[i] = Plucker::Line(point(), point());
+		planes[i] = Plucker::Plane(point(), point(), point());
+		lineBatches[i / 16].set(i % 16, lines[i]);
+		planeBatches[i / 16].set(i % 16, planes[i]);
+	}
+	
+	Result res;
+	res.dim = 4;
+	res.flopsPerOp = 24 + 4;		// 12 multiply-adds, then the divide
+	
+	res.name = "plucker_intersect_batches";
+	res.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		Plucker::IntersectPairs(pointBatches.data(), batchHit.get(), lineBatches.data(), planeBatches.data(), count / 16);
+		Sink(pointBatches.data());
+	});
+	const double batchesNs = res.nsPerOp;
+	
+	res.name = "plucker_intersect_pairs";
+	res.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		Plucker::IntersectPairs(points.data(), hit.get(), lines.data(), planes.data(), count);
+		Sink(points.data());
+	});
+	
+	// Check against the naive meet, divided (and the batches against the tuples).
+	res.maxError = 0;
+	bool agree = true;
+	for (int i=0; i<count; i++)
+	{
+		double l[16] = {0}, p[16] = {0}, dual[16] = {0}, expect[16] = {0};
+		Export(lines[i], l);
+		Export(planes[i], p);
+		NaiveDual(4, NaiveGrade(4, l, 2).data(), dual);
+		NaiveProduct(NaiveInner, 4, dual, NaiveGrade(4, p, 3).data(), expect);
+		
+		const T4 batched = pointBatches[i / 16].get(i % 16);
+		for (int b=0; b<16; b++)
+			if (batched._data[b] != points[i]._data[b])
+				agree = false;
+		
+		const double w = expect[e4];
+		if ((w != 0) != hit[i] || hit[i] != batchHit[i])
+			agree = false;
+		if (w == 0)
+			continue;
+		
+		// Lines almost parallel to their plane are ill-conditioned in float,
+		// the relative error is only checked on the others.
+		double lnorm = 0, pnorm = 0;
+		for (int b=0; b<16; b++)
+		{
+			lnorm += l[b] * l[b];
+			pnorm += p[b] * p[b];
+		}
+		if (std::fabs(w) < 1e-2 * std::sqrt(lnorm * pnorm))
+			continue;
+		
+		for (int b : {e1, e2, e3})
+			res.maxError = std::fmax(res.maxError, std::fabs(expect[b] / w - points[i]._data[b]) / (1 + std::fabs(expect[b] / w)));
+		res.maxError = std::fmax(res.maxError, std::fabs(1.0 - points[i]._data[e4]));
+	}
+	res.ok = agree && res.maxError <= 1e-3;
+	
+	Result batches = res;
+	batches.name = "plucker_intersect_batches";
+	batches.nsPerOp = batchesNs;
+	
+	// One Plucker::Meet at a time, for comparison.
+	Result scalar = res;
+	scalar.name = "plucker_intersect_scalar";
+	scalar.flopsPerOp = 162 + 4;
+	scalar.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		for (int i=0; i<count; i++)
+		{
+			T4 m = Plucker::Meet(lines[i], planes[i]);
+			const float w = m._data[e4];
+			hit[i] = w != 0;
+			
+			const float inverse = hit[i] ? 1 / w : 0;
+			points[i] = T4();
+			points[i]._data[e1] = m._data[e1] * inverse;
+			points[i]._data[e2] = m._data[e2] * inverse;
+			points[i]._data[e3] = m._data[e3] * inverse;
+			points[i]._data[e4] = hit[i] ? 1 : 0;
+		}
+		Sink(points.data());
+	});
+	
+	// Every line with every plane, of 64 lines, checked against IntersectPairs
+	// on the same pairs (the batches and views against the tuples).
+	const int allLines = std::min(count, 64);
+	const int allPlanes = std::min(count, 4096);
+	std::vector<T4> pairLines(allLines * allPlanes), pairPlanes(allLines * allPlanes);
+	std::vector<T4> allPoints(allLines * allPlanes), pairPoints(allLines * allPlanes), viewPoints(allLines * allPlanes);
+	std::vector<B4, AlignedAllocator<B4>> allBatches(allLines / 16 * allPlanes);
+	std::unique_ptr<bool[]> allHit(new bool[allLines * allPlanes]);
+	std::unique_ptr<bool[]> pairHit(new bool[allLines * allPlanes]);
+	std::unique_ptr<bool[]> viewHit(new bool[allLines * allPlanes]);
+	std::unique_ptr<bool[]> allBatchHit(new bool[allLines * allPlanes]);
+	for (int i=0; i<allLines; i++)
+		for (int j=0; j<allPlanes; j++)
+		{
+			pairLines[i * allPlanes + j] = lines[i];
+			pairPlanes[i * allPlanes + j] = planes[j];
+		}
+	
+	Result all = res;
+	all.name = "plucker_intersect_all";
+	all.nsPerOp = TimeItems(opt, allLines * allPlanes, [&]()
+	{
+		Plucker::IntersectAll(allPoints.data(), allHit.get(), lines.data(), allLines, planes.data(), allPlanes);
+		Sink(allPoints.data());
+	});
+	
+	typedef GATupleArrayView<GADenseBlades<e1^e2^e3^e4>, float> Tuples;
+	typedef GATupleArrayView<GADenseBlades<e1^e2^e3^e4>, const float> ConstTuples;
+	Plucker::IntersectPairs(pairPoints.data(), pairHit.get(), pairLines.data(), pairPlanes.data(), allLines * allPlanes);
+	Plucker::IntersectAll(allBatches.data(), allBatchHit.get(), lineBatches.data(), allLines / 16, planes.data(), allPlanes);
+	Plucker::IntersectAll(Tuples(&viewPoints[0]._data[0], allLines * allPlanes, sizeof(T4)), viewHit.get(),
+						  ConstTuples(&lines[0]._data[0], allLines, sizeof(T4)), ConstTuples(&planes[0]._data[0], allPlanes, sizeof(T4)));
+	
+	bool allAgree = true;
+	for (int i=0; i<allLines; i++)
+		for (int j=0; j<allPlanes; j++)
+		{
+			const int k = i * allPlanes + j;
+			const int lane = (i / 16 * allPlanes + j) * 16 + i % 16;
+			const T4 batched = allBatches[i / 16 * allPlanes + j].get(i % 16);
+			for (int b=0; b<16; b++)
+				if (allPoints[k]._data[b] != pairPoints[k]._data[b] || viewPoints[k]._data[b] != pairPoints[k]._data[b]
+					|| batched._data[b] != pairPoints[k]._data[b])
+					allAgree = false;
+			if (allHit[k] != pairHit[k] || viewHit[k] != pairHit[k] || allBatchHit[lane] != pairHit[k])
+				allAgree = false;
+		}
+	all.ok = res.ok && allAgree;
+	
+	for (const Result &r : {batches, res, scalar, all})
+	{
+		Report(opt, results, r);
+	}
+}
+
+
+//! Macro benchmark: intersect lines and planes read from memory-mapped files.
+/*!	file_open maps a file of lines (only its header is read), and
+	file_intersect_pairs runs Plucker::IntersectPairs on the records of the
+	mapped files, writing the points into a strided buffer.  Compare with
+	plucker_intersect_pairs.
+ */
+void MeasureFile(const Options &opt, std::vector<Result> &results)
+{
+	typedef GAGradeBlades<e1^e2^e3^e4, 1>::type PointLayout;
+	typedef GAGradeBlades<e1^e2^e3^e4, 2>::type LineLayout;
+	typedef GAGradeBlades<e1^e2^e3^e4, 3>::type PlaneLayout;
+	typedef GATuple<e1^e2^e3^e4> T4;
+	
+	if (!opt.filter.empty() && std::string("file_").find(opt.filter) == std::string::npos
+		&& opt.filter.find("file_") == std::string::npos)
+		return;
+	
+	const char *linePath = "lga_bench_lines.lga";
+	const char *planePath = "lga_bench_planes.lga";
+	const char *blockPath = "lga_bench_blocks.lga";
+	
+	const int count = (int)std::min<long>(opt.points / 4, 1 << 20);
+	std::vector<T4> lines(count), planes(count), points(count);
+	std::unique_ptr<bool[]> hit(new bool[count]);
+	std::unique_ptr<bool[]> fileHit(new bool[count]);
+	
+	std::mt19937 rnd(7);
+	std::uniform_real_distribution<float> uniform(-10.0f, 10.0f);
+	auto point = [&]() { return Plucker::Point(uniform(rnd), uniform(rnd), uniform(rnd)); };
+	
+	GAFileWriter<LineLayout> lineFile(linePath);
+	GAFileWriter<PlaneLayout> planeFile(blockPath, GAFileSoA, 8);
+	for (int i=0; i<count; i++)
+	{
+		lines[i] = Plucker::Line(point(), point());
+		planes[i] = Plucker::Plane(point(), point(), point());
+		lineFile.write(lines[i]);
+		planeFile.write(planes[i]);
+	}
+	bool ok = lineFile.close() && planeFile.close();
+	
+	// The planes were written as SoA blocks, read them back as records.
+	GAFileReader soa(blockPath);
+	ok = ok && soa.is_open() && soa.holds<PlaneLayout>() && soa.size() == (std::uint64_t)count;
+	
+	GAFileWriter<PlaneLayout> aos(planePath);
+	for (int i=0; i<count && ok; i++)
+		aos.write(soa.record<PlaneLayout, 8>(i));
+	soa.close();
+	ok = aos.close() && ok;
+	
+	Result open;
+	open.name = "file_open";
+	open.dim = 4;
+	open.flopsPerOp = 0;
+	open.nsPerOp = TimeItems(opt, 1, [&]()
+	{
+		GAFileReader f(linePath);
+		ok = ok && f.is_open();
+	});
+	
+	GAFileReader lineReader(linePath), planeReader(planePath);
+	ok = ok && lineReader.holds<LineLayout>() && planeReader.holds<PlaneLayout>();
+	
+	std::vector<float> out(std::size_t(count) * 8);		// Points in records of 8 floats
+	
+	Result res;
+	res.name = "file_intersect_pairs";
+	res.dim = 4;
+	res.flopsPerOp = 24 + 4;
+	res.nsPerOp = ok ? TimeItems(opt, count, [&]()
+	{
+		Plucker::IntersectPairs(GATupleArrayView<PointLayout>(out.data(), count, 8 * sizeof(float)), fileHit.get(),
+								lineReader.records<LineLayout>(), planeReader.records<PlaneLayout>());
+		Sink(out.data());
+	}) : 0;
+	
+	// Check against the tuples.
+	Plucker::IntersectPairs(points.data(), hit.get(), lines.data(), planes.data(), count);
+	
+	res.maxError = 0;
+	for (int i=0; i<count && ok; i++)
+	{
+		ok = ok && hit[i] == fileHit[i];
+		for (int b=0; b<PointLayout::count; b++)
+			res.maxError = std::fmax(res.maxError, std::fabs(out[i * 8 + b] - points[i]._data[PointLayout::mask(b)]) / (1 + std::fabs(points[i]._data[PointLayout::mask(b)])));
+	}
+	res.ok = open.ok = ok && res.maxError <= 1e-5;
+	open.maxError = res.maxError;
+	
+	lineReader.close();
+	planeReader.close();
+	std::remove(linePath);
+	std::remove(planePath);
+	std::remove(blockPath);
+	
+	for (const Result &r : {open, res})
+	{
+		Report(opt, results, r);
+	}
+}
+
+
+//! Macro benchmark: stream a file of lines and planes through Plucker::MeetLinePlane.
+/*!	stream_meet reads records holding a line and a plane, meets them on a
+	worker thread and writes the points, chunk by chunk (see GAStream).  The
+	ns/op is the wall time per record, the throughput of each stage is
+	printed.
+ */
+void MeasureStream(const Options &opt, std::vector<Result> &results)
+{
+	typedef GAUnionBlades<GAGradeBlades<e1^e2^e3^e4, 2>::type, GAGradeBlades<e1^e2^e3^e4, 3>::type>::type Record;
+	typedef GAGradeBlades<e1^e2^e3^e4, 1>::type PointLayout;
+	typedef GATuple<e1^e2^e3^e4> T4;
+	
+	Result res;
+	res.name = "stream_meet";
+	res.dim = 4;
+	res.flopsPerOp = 24;
+	
+	if (!opt.filter.empty() && res.name.find(opt.filter) == std::string::npos)
+		return;
+	
+	const char *inPath = "lga_bench_stream_in.lga";
+	const char *outPath = "lga_bench_stream_out.lga";
+	
+	const long count = opt.points;
+	std::vector<T4> expect(std::size_t(std::min<long>(count, 4096)));
+	
+	std::mt19937 rnd(11);
+	std::uniform_real_distribution<float> uniform(-10.0f, 10.0f);
+	auto point = [&]() { return Plucker::Point(uniform(rnd), uniform(rnd), uniform(rnd)); };
+	
+	bool ok;
+	{
+		GAFileWriter<Record> file(inPath);
+		for (long i=0; i<count; i++)
+		{
+			const T4 line = Plucker::Line(point(), point());
+			const T4 plane = Plucker::Plane(point(), point(), point());
+			if (i < (long)expect.size())
+				expect[i] = Plucker::MeetLinePlane(line, plane);
+			T4 both = line;
+			both += plane;
+			file.write(both);
+		}
+		ok = file.close();
+	}
+	
+	GAStreamReader<Record> in_(inPath);
+	GAFileWriter<PointLayout> out(outPath);
+	
+	GAStreamOptions options;
+	options.chunkRecords = 1 << 14;
+	
+	const GAStreamStats stats = GAStream(in_, out, GAStreamEach([](GATupleView<Record, const float> r)
+	{
+		return Plucker::MeetLinePlane(r, r);	// The grade 2 and grade 3 parts
+	}), options);
+	
+	ok = ok && stats.ok && out.close();
+	in_.close();
+	res.nsPerOp = stats.seconds * 1e9 / double(count);
+	
+	// Check the first records against the tuples.
+	GAFileReader points(outPath);
+	ok = ok && points.holds<PointLayout>() && points.size() == (std::uint64_t)count;
+	
+	res.maxError = 0;
+	for (long i=0; i<(long)expect.size() && ok; i++)
+	{
+		const T4 p = points.records<PointLayout>()[i].tuple<e1^e2^e3^e4>();
+		for (int b=0; b<16; b++)
+			res.maxError = std::fmax(res.maxError, std::fabs(p._data[b] - expect[i]._data[b]) / (1 + std::fabs(expect[i]._data[b])));
+	}
+	res.ok = ok && res.maxError <= 1e-5;
+	
+	points.close();
+	std::remove(inPath);
+	std::remove(outPath);
+	
+	res.scalarNsPerOp = ScalarNs(opt, res);
+	results.push_back(res);
+	if (!opt.quiet || !res.ok)
+		printf("%-24s %ldM records %8.2f ns/record %6.2f scalar  read %.0f, meet %.0f, write %.0f MB/s  err %.2g %s\n",
+			   res.name.c_str(), count / 1000000, res.nsPerOp, res.scalarNsPerOp, stats.read.bytesPerSecond() / 1e6,
+			   stats.transform.bytesPerSecond() / 1e6, stats.write.bytesPerSecond() / 1e6, res.maxError, res.ok ? "" : "FAILED");
+}
+
+
+//! Macro benchmark: intersect and rotate arrays on the threads of GAThreadPool::global().
+/*!	parallel_intersect_pairs runs Plucker::ParallelIntersectPairs (half of
+	the lines miss their plane and leave early), parallel_rotate
+	GAParallelApply of a rotor matrix over a GAParallelArray.  Both are
+	checked against the serial routines; set LGA_THREADS to change the
+	threads.
+ */
+void MeasureParallel(const Options &opt, std::vector<Result> &results)
+{
+	typedef GATuple<e1^e2^e3^e4> T4;
+	
+	if (!opt.filter.empty() && std::string("parallel_").find(opt.filter) == std::string::npos
+		&& opt.filter.find("parallel_") == std::string::npos)
+		return;
+	
+	const long count = opt.points;
+	const int threads = GAThreadPool::global().concurrency();
+	
+	GAParallelArray<T4> lines(count), planes(count), points(count), expect(count);
+	std::unique_ptr<bool[]> hit(new bool[count]), expectHit(new bool[count]);
+	
+	std::mt19937 rnd(13);
+	std::uniform_real_distribution<float> uniform(-10.0f, 10.0f);
+	auto point = [&]() { return Plucker::Point(uniform(rnd), uniform(rnd), uniform(rnd)); };
+	
+	const T4 ground = Plucker::Plane(Plucker::Point(0.0f, 0.0f, 0.0f), Plucker::Point(1.0f, 0.0f, 0.0f), Plucker::Point(0.0f, 1.0f, 0.0f));
+	for (long i=0; i<count; i++)
+	{
+		const T4 a = point();
+		T4 b = point();
+		if (i % 2)
+			b._data[e3] = a._data[e3];		// Parallel to the ground
+		lines[i] = Plucker::Line(a, b);
+		planes[i] = i % 2 ? ground : Plucker::Plane(point(), point(), point());
+	}
+	
+	Result pairs;
+	pairs.name = "parallel_intersect_pairs";
+	pairs.dim = 4;
+	pairs.flopsPerOp = 24 + 4;
+	pairs.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		Plucker::ParallelIntersectPairs(points.data(), hit.get(), lines.data(), planes.data(), count, 1e-6f);
+		Sink(points.data());
+	});
+	
+	Plucker::IntersectPairs(expect.data(), expectHit.get(), lines.data(), planes.data(), (int)count, 1e-6f);
+	
+	bool ok = true;
+	pairs.maxError = 0;
+	for (long i=0; i<count; i++)
+	{
+		ok = ok && hit[i] == expectHit[i];
+		for (int b=0; b<16; b++)
+			pairs.maxError = std::fmax(pairs.maxError, std::fabs(points[i]._data[b] - expect[i]._data[b]));
+	}
+	pairs.ok = ok && pairs.maxError == 0;
+	
+	const GARotor<e1^e2^e3^e4> rotor = Rotation<e2^e3>(-0.4f) | Rotation<e1^e2>(0.7f);
+	const auto m = rotor.Matrix<e1^e2^e3^e4>();
+	
+	Result rotate;
+	rotate.name = "parallel_rotate";
+	rotate.dim = 4;
+	rotate.flopsPerOp = 2 * 4 * 4;
+	rotate.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		GAParallelApply(m, points.data(), expect.data(), count);
+		Sink(points.data());
+	});
+	
+	m.Transform(lines.data(), expect.data(), count);
+	
+	rotate.maxError = 0;
+	for (long i=0; i<count; i++)
+		for (int b=0; b<16; b++)
+			rotate.maxError = std::fmax(rotate.maxError, std::fabs(points[i]._data[b] - lines[i]._data[b]) / (1 + std::fabs(lines[i]._data[b])));
+	rotate.ok = rotate.maxError <= 1e-5;		// The chunks split the SIMD groups differently
+	
+	for (const Result &r : {pairs, rotate})
+		Report(opt, results, r, std::to_string(threads) + " threads  ");
+}
+
+
+//! Macro benchmark: sums and moments of a point cloud far from the origin.
+/*!	reduce_sum runs GASum on tuples, reduce_moments GAMomentsOf (centroid
+	and covariance) on batches, both with GA_KahanSum.  Checked against
+	double precision sums.
+ */
+void MeasureReduce(const Options &opt, std::vector<Result> &results)
+{
+	typedef GATuple<e1^e2^e3^e4> T4;
+	typedef GATupleBatch<e1^e2^e3^e4, float, 16> B4;
+	
+	if (!opt.filter.empty() && std::string("reduce_").find(opt.filter) == std::string::npos
+		&& opt.filter.find("reduce_") == std::string::npos)
+		return;
+	
+	const long count = opt.points;
+	std::vector<T4> points(count);
+	std::vector<B4, AlignedAllocator<B4>> batches((count + 15) / 16);
+	
+	std::mt19937 rnd(17);
+	std::uniform_real_distribution<float> uniform(-10.0f, 10.0f);
+	for (long i=0; i<count; i++)
+		points[i] = Plucker::Point(1000 + uniform(rnd), uniform(rnd), 2 * uniform(rnd));
+	for (long i=0; i<count; i+=16)
+		batches[i / 16].gather(&points[i], (int)std::min<long>(16, count - i));
+	
+	double sum[3] = {}, outer[3][3] = {};
+	for (long i=0; i<count; i++)
+	{
+		const double x[3] = {points[i]._data[e1], points[i]._data[e2], points[i]._data[e3]};
+		for (int r=0; r<3; r++)
+		{
+			sum[r] += x[r];
+			for (int c=0; c<3; c++)
+				outer[r][c] += (x[r] - 1000 * (r == 0)) * (x[c] - 1000 * (c == 0));
+		}
+	}
+	
+	Result total;
+	total.name = "reduce_sum";
+	total.dim = 4;
+	total.flopsPerOp = 16;
+	
+	T4 s;
+	total.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		s = GASum<GA_KahanSum>(points.data(), count);
+		Sink(&s);
+	});
+	
+	total.maxError = 0;
+	for (int r=0; r<3; r++)
+		total.maxError = std::fmax(total.maxError, std::fabs(s._data[1 << r] - sum[r]) / (1 + std::fabs(sum[r])));
+	total.ok = total.maxError <= 1e-6 && s._data[e4] == (float)count;
+	
+	Result moments;
+	moments.name = "reduce_moments";
+	moments.dim = 4;
+	moments.flopsPerOp = 4 + 2 * 10;
+	
+	GAMoments<e1^e2^e3^e4> m;
+	moments.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		m = GAMomentsOf<GA_KahanSum>(batches.data(), count);
+		Sink(&m);
+	});
+	
+	// The covariance of the shifted sums, exact in double.
+	moments.maxError = 0;
+	for (int r=0; r<3; r++)
+	{
+		const double mean = sum[r] / count;
+		moments.maxError = std::fmax(moments.maxError, std::fabs(m.mean()._data[1 << r] - mean) / (1 + std::fabs(mean)));
+		
+		for (int c=0; c<3; c++)
+		{
+			const double shift[3] = {1000, 0, 0};
+			const double cov = outer[r][c] / count - (mean - shift[r]) * (sum[c] / count - shift[c]);
+			moments.maxError = std::fmax(moments.maxError, std::fabs(m.covariance(r, c) - cov) / (1 + std::fabs(cov)));
+		}
+	}
+	moments.ok = moments.maxError <= 1e-4 && m.count == count;
+	
+	for (const Result &r : {total, moments})
+	{
+		Report(opt, results, r);
+	}
+}
+
+
+//! Macro benchmark: rotate points by the same rotor.
+/*!	versor_products runs the two products (r | x) | ~r, versor_sandwich
+	the fused GAVersor::Sandwich, and versor_matrix the matrix built once by
+	GAVersor::Matrix over the whole array.
+ */
+void MeasureVersor(const Options &opt, std::vector<Result> &results)
+{
+	typedef GATuple<e1^e2^e3^e4> T4;
+	
+	if (!opt.filter.empty() && std::string("versor").find(opt.filter) == std::string::npos
+		&& opt.filter.find("versor") == std::string::npos)
+		return;
+	
+	const int count = (int)std::min<long>(opt.points, 100000);
+	std::vector<T4> points(count), moved(count);
+	
+	std::mt19937 rnd(11);
+	std::uniform_real_distribution<float> uniform(-100.0f, 100.0f);
+	for (int i=0; i<count; i++)
+		points[i] = Plucker::Point(uniform(rnd), uniform(rnd), uniform(rnd));
+	
+	// Turn by 0.7 within e1^e2, then by -0.4 within e2^e3.
+	const GARotor<e1^e2^e3^e4> rotor = Rotation<e2^e3>(-0.4f) | Rotation<e1^e2>(0.7f);
+	const T4 r = rotor._versor.tuple<e1^e2^e3^e4>();
+	const T4 reverse = Reverse(r);
+	
+	Result products;
+	products.name = "versor_products";
+	products.dim = 4;
+	products.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		for (int i=0; i<count; i++)
+			moved[i] = (r | points[i]) | reverse;
+		Sink(moved.data());
+	});
+	
+	Result sandwich;
+	sandwich.name = "versor_sandwich";
+	sandwich.dim = 4;
+	sandwich.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		for (int i=0; i<count; i++)
+			moved[i] = rotor.Sandwich(Grade<1>(points[i])).tuple<e1^e2^e3^e4>();
+		Sink(moved.data());
+	});
+	
+	Result matrix;
+	matrix.name = "versor_matrix";
+	matrix.dim = 4;
+	matrix.flopsPerOp = 2 * 4 * 4;
+	matrix.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		rotor.Matrix<e1^e2^e3^e4>().Transform(moved.data(), points.data(), count);
+		Sink(moved.data());
+	});
+	
+	// Flops of one point, through the same tables.
+	{
+		GATuple<e1^e2^e3^e4, Flop> fr, fv, fp;
+		for (int b=0; b<16; b++)
+		{
+			fr._data[b] = r._data[b];
+			fv._data[b] = reverse._data[b];
+		}
+		fp._data[e1] = 1.0;
+		
+		Flop::count = 0;
+		auto m = (fr | fp) | fv;
+		(void)m;
+		products.flopsPerOp = (double)Flop::count;
+		
+		const GAVersor<GARotor<e1^e2^e3^e4>::Blades, Flop> fvr(fr);
+		Flop::count = 0;
+		auto s = fvr.Sandwich(Grade<1>(fp));
+		(void)s;
+		sandwich.flopsPerOp = (double)Flop::count;
+	}
+	
+	// Check the three against the rotation matrices, in double.
+	const double c1 = std::cos(0.7), s1 = std::sin(0.7);
+	const double c2 = std::cos(-0.4), s2 = std::sin(-0.4);
+	auto check = [&](Result &res, std::function<T4(int)> move)
+	{
+		res.maxError = 0;
+		for (int i=0; i<count; i += count / 1000 + 1)
+		{
+			const T4 p = points[i];
+			const double x = c1 * p._data[e1] - s1 * p._data[e2];
+			const double y = s1 * p._data[e1] + c1 * p._data[e2];
+			const double expect[3] = {x, c2 * y - s2 * p._data[e3], s2 * y + c2 * p._data[e3]};
+			
+			const T4 q = move(i);
+			for (int k=0; k<3; k++)
+				res.maxError = std::fmax(res.maxError, std::fabs(expect[k] - q._data[1 << k]) / 100);
+			res.maxError = std::fmax(res.maxError, std::fabs(1 - q._data[e4]));
+		}
+		res.ok = res.maxError <= 1e-5;
+	};
+	
+	check(products, [&](int i) { return T4((r | points[i]) | reverse); });
+	check(sandwich, [&](int i) { return rotor.Sandwich(Grade<1>(points[i])).tuple<e1^e2^e3^e4>(); });
+	rotor.Matrix<e1^e2^e3^e4>().Transform(moved.data(), points.data(), count);
+	check(matrix, [&](int i) { return moved[i]; });
+	
+	for (const Result &res : {products, sandwich, matrix})
+	{
+		Report(opt, results, res);
+	}
+}
+
+
+//! Macro benchmark: normalize rotors, as done every integration step.
+/*!	normalize_product takes the norm from x | ~x, normalize_exact and
+	normalize_fast use NormSquared (with GA_Rsqrt and GA_FastRsqrt), and
+	normalize_batches runs GA_FastRsqrt over the lanes of batches.  The
+	flops of NormSquared, the scale and the Newton step are counted with
+	Flop; the square root, the divide and the estimate count as one each.
+ */
+void MeasureNormalize(const Options &opt, std::vector<Result> &results)
+{
+	typedef GATuple<e1^e2^e3^e4> T4;
+	typedef GATupleBatch<e1^e2^e3^e4, float, 16> B4;
+	
+	if (!opt.filter.empty() && std::string("normalize").find(opt.filter) == std::string::npos
+		&& opt.filter.find("normalize") == std::string::npos)
+		return;
+	
+	const int count = (int)std::min<long>(opt.points, 100000) / 16 * 16;
+	std::vector<T4> rotors(count), moved(count);
+	std::vector<B4, AlignedAllocator<B4>> batches(count / 16), movedBatches(count / 16);
+	
+	std::mt19937 rnd(17);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+	for (int i=0; i<count; i++)
+	{
+		for (int b : {0, 3, 5, 6, 9, 10, 12, 15})
+			rotors[i]._data[b] = uniform(rnd);
+		batches[i / 16].set(i % 16, rotors[i]);
+	}
+	
+	Result product;
+	product.name = "normalize_product";
+	product.dim = 4;
+	product.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		for (int i=0; i<count; i++)
+		{
+			const float n2 = (rotors[i] | Reverse(rotors[i]))._data[scalar];
+			const float inverse = 1 / std::sqrt(n2);
+			for (int b=0; b<16; b++)
+				moved[i]._data[b] = rotors[i]._data[b] * inverse;
+		}
+		Sink(moved.data());
+	});
+	{
+		GATuple<e1^e2^e3^e4, Flop> fr;
+		for (int b=0; b<16; b++)
+			fr._data[b] = 1.0;
+		Flop::count = 0;
+		auto n2 = fr | Reverse(fr);
+		(void)n2;
+		product.flopsPerOp = (double)Flop::count + 2 + 16;
+	}
+	
+	double normalizeFlops, newtonFlops;
+	{
+		GATuple<e1^e2^e3^e4, Flop> fr, scaled;
+		for (int b=0; b<16; b++)
+			fr._data[b] = 1.0;
+		Flop::count = 0;
+		const Flop n2 = NormSquared(fr);
+		GAScale<GADenseBlades<e1^e2^e3^e4>>(scaled._data, fr._data, n2, std::make_index_sequence<16>());
+		normalizeFlops = (double)Flop::count;
+		
+		Flop::count = 0;
+		GA_FastRsqrt::step(n2, Flop(1.0));
+		newtonFlops = (double)Flop::count;
+	}
+	
+	Result exact;
+	exact.name = "normalize_exact";
+	exact.dim = 4;
+	exact.flopsPerOp = normalizeFlops + 2;
+	exact.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		for (int i=0; i<count; i++)
+			moved[i] = Normalize(rotors[i]);
+		Sink(moved.data());
+	});
+	
+	Result fast = exact;
+	fast.name = "normalize_fast";
+	fast.flopsPerOp = normalizeFlops + 1 + newtonFlops;
+	fast.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		for (int i=0; i<count; i++)
+			moved[i] = Normalize<GA_FastRsqrt>(rotors[i]);
+		Sink(moved.data());
+	});
+	
+	Result batched = fast;
+	batched.name = "normalize_batches";
+	batched.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		std::copy(batches.begin(), batches.end(), movedBatches.begin());
+		Normalize<GA_FastRsqrt>(movedBatches.data(), count / 16);
+		Sink(movedBatches.data());
+	});
+	
+	// Check against the norm in double.
+	auto check = [&](Result &res, std::function<T4(int)> normalized)
+	{
+		res.maxError = 0;
+		for (int i=0; i<count; i += count / 1000 + 1)
+		{
+			double n2 = 0;
+			for (int b=0; b<16; b++)
+				n2 += (double)rotors[i]._data[b] * rotors[i]._data[b];
+			
+			const T4 got = normalized(i);
+			for (int b=0; b<16; b++)
+				res.maxError = std::fmax(res.maxError, std::fabs(rotors[i]._data[b] / std::sqrt(n2) - got._data[b]));
+		}
+		res.ok = res.maxError <= 1e-5;
+	};
+	
+	check(product, [&](int i)
+	{
+		const float inverse = 1 / std::sqrt((rotors[i] | Reverse(rotors[i]))._data[scalar]);
+		T4 toRet;
+		for (int b=0; b<16; b++)
+			toRet._data[b] = rotors[i]._data[b] * inverse;
+		return toRet;
+	});
+	check(exact, [&](int i) { return Normalize(rotors[i]); });
+	check(fast, [&](int i) { return Normalize<GA_FastRsqrt>(rotors[i]); });
+	check(batched, [&](int i) { return movedBatches[i / 16].get(i % 16); });
+	
+	for (Result *res : {&product, &exact, &fast, &batched})
+	{
+		Report(opt, results, *res);
+	}
+}
+
+
+//! Macro benchmark: rotors from bivectors and back, and inverses.
+/*!	exp_series sums the series (scaling and squaring), exp_closed and
+	log_closed are the closed forms of 4D, and the batches use GA_FastMath.
+	inverse_solve solves x | y = 1, inverse_closed is the closed form.  The
+	flops are counted on one tuple, a square root, sine, cosine or arc
+	tangent counting as one.
+ */
+void MeasureExp(const Options &opt, std::vector<Result> &results)
+{
+	typedef GATuple<e1^e2^e3^e4> T4;
+	typedef GATupleBatch<e1^e2^e3^e4, float, 16> B4;
+	
+	if (!opt.filter.empty() && std::string("exp_log_inverse").find(opt.filter) == std::string::npos
+		&& opt.filter.find("exp") == std::string::npos && opt.filter.find("log") == std::string::npos
+		&& opt.filter.find("inverse") == std::string::npos)
+		return;
+	
+	const int count = (int)std::min<long>(opt.points, 100000) / 16 * 16;
+	std::vector<T4> bivectors(count), rotors(count), out(count);
+	std::vector<B4, AlignedAllocator<B4>> batches(count / 16), rotorBatches(count / 16), outBatches(count / 16);
+	
+	// Angles within (-pi, pi), so Log undoes Exp.
+	std::mt19937 rnd(19);
+	std::uniform_real_distribution<float> uniform(-0.8f, 0.8f);
+	for (int i=0; i<count; i++)
+	{
+		for (int b : {3, 5, 6, 9, 10, 12})
+			bivectors[i]._data[b] = uniform(rnd);
+		rotors[i] = Exp(bivectors[i]);
+		batches[i / 16].set(i % 16, bivectors[i]);
+		rotorBatches[i / 16].set(i % 16, rotors[i]);
+	}
+	
+	// Flops of one tuple with Flop and FlopMath, the batches run the same
+	// formulas on every lane.
+	GATuple<e1^e2^e3^e4, Flop> fb, fr;
+	for (int b=0; b<16; b++)
+	{
+		fb._data[b] = bivectors[0]._data[b];
+		fr._data[b] = rotors[0]._data[b];
+	}
+	auto counted = [](std::function<void()> run)
+	{
+		Flop::count = 0;
+		run();
+		return (double)Flop::count;
+	};
+	const double seriesFlops = counted([&]() { GAExpSeries(fb); });
+	const double expFlops = counted([&]() { Exp<FlopMath>(fb); });
+	const double logFlops = counted([&]() { Log<FlopMath>(fr); });
+	const double solveFlops = counted([&]() { GAInverse(fr, std::integral_constant<int, 6>()); });
+	const double inverseFlops = counted([&]() { Inverse(fr); });
+	
+	auto timed = [&](const char *name, double flops, std::function<void()> run)
+	{
+		Result res;
+		res.name = name;
+		res.dim = 4;
+		res.flopsPerOp = flops;
+		res.nsPerOp = TimeItems(opt, count, run);
+		return res;
+	};
+	
+	Result series = timed("exp_series", seriesFlops, [&]()
+	{
+		for (int i=0; i<count; i++)
+			out[i] = GAExpSeries(bivectors[i]);
+		Sink(out.data());
+	});
+	Result closed = timed("exp_closed", expFlops, [&]()
+	{
+		for (int i=0; i<count; i++)
+			out[i] = Exp(bivectors[i]);
+		Sink(out.data());
+	});
+	Result batched = timed("exp_batches", expFlops, [&]()
+	{
+		Exp(outBatches.data(), batches.data(), count / 16);
+		Sink(outBatches.data());
+	});
+	Result log = timed("log_closed", logFlops, [&]()
+	{
+		for (int i=0; i<count; i++)
+			out[i] = Log(rotors[i]);
+		Sink(out.data());
+	});
+	Result logBatched = timed("log_batches", logFlops, [&]()
+	{
+		Log(outBatches.data(), rotorBatches.data(), count / 16);
+		Sink(outBatches.data());
+	});
+	Result solve = timed("inverse_solve", solveFlops, [&]()
+	{
+		for (int i=0; i<count; i++)
+			out[i] = GAInverse(rotors[i], std::integral_constant<int, 6>());
+		Sink(out.data());
+	});
+	Result inverse = timed("inverse_closed", inverseFlops, [&]()
+	{
+		for (int i=0; i<count; i++)
+			out[i] = Inverse(rotors[i]);
+		Sink(out.data());
+	});
+	Result inverseBatched = timed("inverse_batches", inverseFlops, [&]()
+	{
+		for (int i=0; i<count / 16; i++)
+			outBatches[i] = Inverse(rotorBatches[i]);
+		Sink(outBatches.data());
+	});
+	
+	// Check against the series in double, Log against the bivector and
+	// the inverses against x | y = 1.
+	auto check = [&](Result &res, std::function<T4(int)> run, std::function<void(int, double *)> expect)
+	{
+		res.maxError = 0;
+		for (int i=0; i<count; i += count / 1000 + 1)
+		{
+			double e[16] = {0};
+			expect(i, e);
+			const T4 got = run(i);
+			for (int b=0; b<16; b++)
+				res.maxError = std::fmax(res.maxError, std::fabs(e[b] - got._data[b]));
+		}
+		res.ok = res.maxError <= 1e-5;
+	};
+	
+	auto exp = [&](int i, double *e)
+	{
+		double term[16] = {1}, next[16], b[16];
+		for (int k=0; k<16; k++)
+			b[k] = bivectors[i]._data[k];
+		e[0] = 1;
+		for (int k=1; k<40; k++)
+		{
+			std::fill(next, next + 16, 0.0);
+			NaiveProduct(NaiveGeometric, 4, term, b, next);
+			for (int j=0; j<16; j++)
+			{
+				term[j] = next[j] / k;
+				e[j] += term[j];
+			}
+		}
+	};
+	auto bivector = [&](int i, double *e)
+	{
+		for (int b=0; b<16; b++)
+			e[b] = bivectors[i]._data[b];
+	};
+	auto inverseOf = [&](std::function<T4(int)> run)
+	{
+		return [&, run](int i)
+		{
+			double x[16], y[16], o[16] = {0};
+			const T4 got = run(i);
+			for (int b=0; b<16; b++)
+			{
+				x[b] = rotors[i]._data[b];
+				y[b] = got._data[b];
+			}
+			NaiveProduct(NaiveGeometric, 4, x, y, o);
+			T4 toRet;
+			for (int b=0; b<16; b++)
+				toRet._data[b] = float(o[b]);
+			return toRet;
+		};
+	};
+	auto one = [](int, double *e) { e[0] = 1; };
+	
+	check(series, [&](int i) { return GAExpSeries(bivectors[i]); }, exp);
+	check(closed, [&](int i) { return Exp(bivectors[i]); }, exp);
+	check(batched, [&](int i) { return Exp(batches[i / 16]).get(i % 16); }, exp);
+	check(log, [&](int i) { return Log(rotors[i]); }, bivector);
+	check(logBatched, [&](int i) { return Log(rotorBatches[i / 16]).get(i % 16); }, bivector);
+	check(solve, inverseOf([&](int i) { return GAInverse(rotors[i], std::integral_constant<int, 6>()); }), one);
+	check(inverse, inverseOf([&](int i) { return Inverse(rotors[i]); }), one);
+	check(inverseBatched, inverseOf([&](int i) { return Inverse(rotorBatches[i / 16]).get(i % 16); }), one);
+	
+	for (Result *res : {&series, &closed, &batched, &log, &logBatched, &solve, &inverse, &inverseBatched})
+	{
+		Report(opt, results, *res);
+	}
+}
+
+
+//! Macro benchmark: move planes by a projective map.
+/*!	outermorphism_rebuild moves the three points of each plane and joins
+	them again, outermorphism_planes runs the grade 3 compound of
+	GAOutermorphism over the tuples, outermorphism_batches over batches.
+ */
+void MeasureOutermorphism(const Options &opt, std::vector<Result> &results)
+{
+	typedef GATuple<e1^e2^e3^e4> T4;
+	typedef GATupleBatch<e1^e2^e3^e4, float, 16> B4;
+	
+	if (!opt.filter.empty() && std::string("outermorphism").find(opt.filter) == std::string::npos
+		&& opt.filter.find("outermorphism") == std::string::npos)
+		return;
+	
+	const int count = (int)std::min<long>(opt.points, 100000) / 16 * 16;
+	std::vector<T4> p1(count), p2(count), p3(count), planes(count), moved(count);
+	std::vector<B4, AlignedAllocator<B4>> batches(count / 16), movedBatches(count / 16);
+	
+	std::mt19937 rnd(13);
+	std::uniform_real_distribution<float> uniform(-10.0f, 10.0f);
+	for (int i=0; i<count; i++)
+	{
+		p1[i] = Plucker::Point(uniform(rnd), uniform(rnd), uniform(rnd));
+		p2[i] = Plucker::Point(uniform(rnd), uniform(rnd), uniform(rnd));
+		p3[i] = Plucker::Point(uniform(rnd), uniform(rnd), uniform(rnd));
+		planes[i] = Plucker::Plane(p1[i], p2[i], p3[i]);
+		batches[i / 16].set(i % 16, planes[i]);
+	}
+	
+	// A rotation, a scale and a translation, m[r][c].
+	float m[4][4];
+	std::uniform_real_distribution<float> small(-0.3f, 0.3f);
+	for (int r=0; r<4; r++)
+		for (int c=0; c<4; c++)
+			m[r][c] = (r == c ? 1.0f : 0.0f) + (r < 3 ? small(rnd) : 0.0f);
+	const GAOutermorphism<e1^e2^e3^e4> f(m);
+	
+	auto move = [&](const T4 &p)
+	{
+		T4 q;
+		for (int r=0; r<4; r++)
+			for (int c=0; c<4; c++)
+				q._data[1 << r] += m[r][c] * p._data[1 << c];
+		return q;
+	};
+	
+	Result rebuild;
+	rebuild.name = "outermorphism_rebuild";
+	rebuild.dim = 4;
+	rebuild.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		for (int i=0; i<count; i++)
+			moved[i] = Plucker::Plane(move(p1[i]), move(p2[i]), move(p3[i]));
+		Sink(moved.data());
+	});
+	
+	// Flops of one plane.
+	{
+		GATuple<e1^e2^e3^e4, Flop> f1, f2, f3;
+		for (int r=0; r<4; r++)
+		{
+			f1._data[1 << r] = 1.0;
+			f2._data[1 << r] = 1.0;
+			f3._data[1 << r] = 1.0;
+		}
+		Flop::count = 0;
+		auto plane = Plucker::Plane(f1, f2, f3);
+		(void)plane;
+		rebuild.flopsPerOp = (double)Flop::count + 3 * 2 * 4 * 4;
+	}
+	
+	Result compound;
+	compound.name = "outermorphism_planes";
+	compound.dim = 4;
+	compound.flopsPerOp = 2 * 4 * 4;
+	compound.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		f.Transform<3>(moved.data(), planes.data(), count);
+		Sink(moved.data());
+	});
+	
+	Result batched = compound;
+	batched.name = "outermorphism_batches";
+	batched.nsPerOp = TimeItems(opt, count, [&]()
+	{
+		f.Transform<3>(movedBatches.data(), batches.data(), count / 16);
+		Sink(movedBatches.data());
+	});
+	
+	// Check against the plane of the moved points, in double.
+	rebuild.maxError = 0;
+	compound.maxError = 0;
+	batched.maxError = 0;
+	for (int i=0; i<count; i += count / 1000 + 1)
+	{
+		double q[3][16] = {{0}}, line[16] = {0}, expect[16] = {0};
+		const T4 *p[3] = {&p1[i], &p2[i], &p3[i]};
+		for (int k=0; k<3; k++)
+			for (int r=0; r<4; r++)
+				for (int c=0; c<4; c++)
+					q[k][1 << r] += (double)m[r][c] * p[k]->_data[1 << c];
+		NaiveProduct(NaiveOuter, 4, q[0], q[1], line);
+		NaiveProduct(NaiveOuter, 4, line, q[2], expect);
+		
+		double norm = 0;
+		for (int b=0; b<16; b++)
+			norm = std::fmax(norm, std::fabs(expect[b]));
+		
+		const T4 reb = Plucker::Plane(move(p1[i]), move(p2[i]), move(p3[i]));
+		f.Transform<3>(&moved[i], &planes[i], 1);
+		const T4 bat = movedBatches[i / 16].get(i % 16);
+		for (int b=0; b<16; b++)
+		{
+			rebuild.maxError = std::fmax(rebuild.maxError, std::fabs(expect[b] - reb._data[b]) / norm);
+			compound.maxError = std::fmax(compound.maxError, std::fabs(expect[b] - moved[i]._data[b]) / norm);
+			batched.maxError = std::fmax(batched.maxError, std::fabs(expect[b] - bat._data[b]) / norm);
+		}
+	}
+	
+	for (Result *res : {&rebuild, &compound, &batched})
+	{
+		res->ok = res->maxError <= 1e-5;
+		Report(opt, results, *res);
+	}
+}
+
+
+//! Level of the SIMD kernels, as a string.
+const char *LevelName(int level)
+{
+	switch (level)
+	{
+		case LGA_SIMD_AVX512:	return "avx512";
+		case LGA_SIMD_AVX2:		return "avx2";
+		case LGA_SIMD_SSE41:	return "sse4.1";
+		default:				return "scalar";
+	}
+}
+
+
+//! Write the results as JSON.
+bool WriteJSON(const Options &opt, const std::vector<Result> &results)
+{
+	FILE *f = fopen(opt.json.c_str(), "w");
+	if (f == nullptr)
+	{
+		fprintf(stderr, "lga_bench: cannot write %s\n", opt.json.c_str());
+		return false;
+	}
+	
+	fprintf(f, "{\n");
+	fprintf(f, "  \"compiler\": \"%s\",\n", __VERSION__);
+	fprintf(f, "  \"simd\": \"%s\",\n", LevelName(GASIMDRuntimeLevel()));
+	fprintf(f, "  \"points\": %ld,\n", opt.points);
+	fprintf(f, "  \"benchmarks\": [\n");
+	for (size_t i=0; i<results.size(); i++)
+	{
+		const Result &r = results[i];
+		fprintf(f, "    {\"name\": \"%s\", \"dim\": %d, \"ns_per_op\": %.4f, \"scalar_ns_per_op\": %.4f, \"flops_per_op\": %.0f, \"max_error\": %.3g, \"ok\": %s}%s\n",
+				r.name.c_str(), r.dim, r.nsPerOp, r.scalarNsPerOp, r.flopsPerOp, r.maxError, r.ok ? "true" : "false",
+				i + 1 < results.size() ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+	fclose(f);
+	return true;
+}
+
+
+//! Macro benchmark: products of tuples whose algebra is picked at run time.
+/*!	runtime_gp and runtime_cga_gp multiply full tuples of the 4D and
+	conformal 5D algebras (cached sign tables), runtime_sparse_gp bivectors
+	by vectors of the 10D algebra (signs on the fly, sorted terms).  Compare
+	with tuple_tuple_gp, cga_gp and sparse_bivector_vector_gp.
+ */
+void MeasureRuntime(const Options &opt, std::vector<Result> &results)
+{
+	if (!opt.filter.empty() && std::string("runtime").find(opt.filter) == std::string::npos
+		&& opt.filter.find("runtime") == std::string::npos)
+		return;
+	
+	//! OP of operands of the grade given (all grades for -1), checked against naive.
+	auto measure = [&](auto op, NaiveOp naive, const char *name, int D, unsigned int neg, int leftGrade, int rightGrade)
+	{
+		typedef decltype(op) OP;
+		
+		const GARuntimeAlgebra &algebra = GARuntimeAlgebra::get(D, neg);
+		const int n = 1 << D;
+		
+		std::mt19937 rnd(4321 + D);
+		std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+		
+		std::vector<double> dl(kOperands * n, 0.0), dr(kOperands * n, 0.0);
+		std::vector<GARuntimeTuple<>> l, r, o;
+		for (int k=0; k<kOperands; k++)
+		{
+			l.emplace_back(algebra);
+			r.emplace_back(algebra);
+			o.emplace_back(algebra);
+			for (int m=0; m<n; m++)
+			{
+				if (leftGrade < 0 || GAGrade(GABasis(m)) == leftGrade)
+					l[k].set(m, float(dl[k * n + m] = uniform(rnd)));
+				if (rightGrade < 0 || GAGrade(GABasis(m)) == rightGrade)
+					r[k].set(m, float(dr[k * n + m] = uniform(rnd)));
+			}
+		}
+		
+		Result res;
+		res.name = name;
+		res.dim = D;
+		res.nsPerOp = TimeItems(opt, kOperands, [&]()
+		{
+			for (int k=0; k<kOperands; k++)
+				GARuntimeMultiply<OP>(o[k], l[k], r[(k + 1) % kOperands]);
+			Sink(o.data());
+		});
+		
+		// A multiply and an add per contributing pair.
+		res.flopsPerOp = 0;
+		for (const auto &a : l[0])
+			for (const auto &b : r[1])
+				res.flopsPerOp += algebra.sign<OP>(a.mask, b.mask) != 0 ? 2 : 0;
+		
+		res.maxError = 0;
+		double scale = 1;
+		for (int k=0; k<kOperands; k++)
+		{
+			const int kr = (k + 1) % kOperands;
+			std::vector<double> expect(n, 0.0);
+			NaiveProduct(naive, D, &dl[k * n], &dr[kr * n], expect.data(), neg);
+			
+			for (int b=0; b<n; b++)
+			{
+				res.maxError = std::fmax(res.maxError, std::fabs(expect[b] - o[k][b]));
+				scale = std::fmax(scale, std::fabs(expect[b]));
+			}
+		}
+		res.ok = res.maxError <= 1e-4 * scale * n;
+		
+		Report(opt, results, res);
+	};
+	
+	measure(GA_GeometricProduct(), NaiveGeometric, "runtime_gp", 4, 0, -1, -1);
+	measure(GA_GeometricProduct(), NaiveGeometric, "runtime_cga_gp", 5, e5, -1, -1);
+	measure(GA_GeometricProduct(), NaiveGeometric, "runtime_sparse_gp", 10, 0, 2, 1);
+	measure(GA_OuterProduct(), NaiveOuter, "runtime_op", 5, e5, -1, -1);
+	measure(GA_InnerProduct(), NaiveInner, "runtime_ip", 5, e5, -1, -1);
+	measure(GA_RightContraction(), NaiveRightContraction, "runtime_rc", 5, e5, -1, -1);
+	measure(GA_ScalarProduct(), NaiveScalar, "runtime_sp", 5, e5, -1, -1);
+	
+	// Past LGA_RUNTIME_DENSE_BITS, the products go through the sorted path.
+	measure(GA_GeometricProduct(), NaiveGeometric, "runtime_wide_gp", LGA_RUNTIME_DENSE_BITS + 1, 0, 2, 1);
+	measure(GA_OuterProduct(), NaiveOuter, "runtime_wide_op", LGA_RUNTIME_DENSE_BITS + 1, 0, 2, 1);
+	measure(GA_RightContraction(), NaiveRightContraction, "runtime_wide_rc", LGA_RUNTIME_DENSE_BITS + 1, 0, 2, 1);
+}
+
+
+//! Run every benchmark.
+void MeasureAll(const Options &opt, std::vector<Result> &results)
+{
+	typedef std::integer_sequence<int, 2, 3, 4, 5, 6, 7, 8, 9> Dims;
+	
+	MeasureDims<GAxGA>(opt, results, Dims());
+	MeasureDims<TuplexGA>(opt, results, Dims());
+	MeasureDims<TuplexTupleGP>(opt, results, Dims());
+	MeasureDims<TuplexTupleOP>(opt, results, Dims());
+	MeasureDims<TuplexTupleIP>(opt, results, Dims());
+	MeasureDims<ProjectiveGP>(opt, results, std::integer_sequence<int, 3, 4>());
+	MeasureDims<ConformalGP>(opt, results, std::integer_sequence<int, 4, 5>());
+	MeasureDims<WideGP>(opt, results, std::integer_sequence<int, 10, 12, 14>());
+	MeasureDims<LazyChain>(opt, results, std::integer_sequence<int, 3, 4>());
+	MeasureDims<LazyAlias>(opt, results, std::integer_sequence<int, 3, 4>());
+	MeasureDims<InPlaceGP>(opt, results, std::integer_sequence<int, 3, 4, 5>());
+	MeasureDims<InPlaceOP>(opt, results, std::integer_sequence<int, 3, 4, 5>());
+	MeasureDims<InPlaceIP>(opt, results, std::integer_sequence<int, 3, 4, 5>());
+	MeasureDims<InPlaceSquare>(opt, results, std::integer_sequence<int, 3, 4>());
+	MeasureDims<InPlaceSub>(opt, results, std::integer_sequence<int, 3, 4>());
+	
+	MeasureDims<TupleDual>(opt, results, std::integer_sequence<int, 3, 4>());
+	MeasureDims<TupleCross>(opt, results, std::integer_sequence<int, 3>());
+	MeasureDims<TupleSquare>(opt, results, std::integer_sequence<int, 3, 4, 5>());
+	MeasureDims<TupleNormSquared>(opt, results, std::integer_sequence<int, 3, 4, 5>());
+	
+	Measure<PluckerPoint, 4>(opt, results);
+	Measure<PluckerLine, 4>(opt, results);
+	Measure<PluckerPlane, 4>(opt, results);
+	Measure<PluckerMeet, 4>(opt, results);
+	Measure<PluckerMeetLinePlane, 4>(opt, results);
+	Measure<PluckerJoin, 4>(opt, results);
+	Measure<PluckerJoinPlane, 4>(opt, results);
+	
+	MeasureIntersect(opt, results);
+	MeasureFile(opt, results);
+	MeasureStream(opt, results);
+	MeasureParallel(opt, results);
+	MeasureReduce(opt, results);
+	MeasureVersor(opt, results);
+	MeasureNormalize(opt, results);
+	MeasureExp(opt, results);
+	MeasureOutermorphism(opt, results);
+	MeasureRuntime(opt, results);
+	MeasureCloud(opt, results);
+	MeasureViewCloud(opt, results);
+}
+
+
+int main(int argc, char **argv)
+{
+	Options opt;
+	for (int i=1; i<argc; i++)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--json" && i+1 < argc)
+			opt.json = argv[++i];
+		else if (arg == "--filter" && i+1 < argc)
+			opt.filter = argv[++i];
+		else if (arg == "--points" && i+1 < argc)
+			opt.points = atol(argv[++i]);
+		else if (arg == "--time" && i+1 < argc)
+			opt.seconds = atof(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: %s [--json out.json] [--points n] [--time seconds] [--filter name]\n", argv[0]);
+			return 2;
+		}
+	}
+	
+	printf("lga_bench, SIMD level %s\n", LevelName(GASIMDRuntimeLevel()));
+	
+	// Every benchmark runs with the kernels at LGA_SIMD_SCALAR first, for the scalar column.
+	if (GASIMDRuntimeLevel() != LGA_SIMD_SCALAR)
+	{
+		Options scalar = opt;
+		scalar.quiet = true;
+		
+		GASIMDSetLevel(LGA_SIMD_SCALAR);
+		MeasureAll(scalar, opt.scalar);
+		GASIMDSetLevel(GASIMDRuntimeLevel());
+	}
+	
+	std::vector<Result> results;
+	MeasureAll(opt, results);
+	
+	if (!WriteJSON(opt, results))
+		return 1;
+	
+	for (const Result &r : results)
+		if (!r.ok)
+			return 1;
+	for (const Result &r : opt.scalar)
+		if (!r.ok)
+			return 1;
+	return 0;
+}